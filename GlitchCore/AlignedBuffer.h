@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+/**
+ * @class AlignedBuffer
+ * @brief Growable array of trivially copyable elements for image-sized storage.
+ *
+ * Unlike std::vector, resize() never initializes elements (the engine always
+ * overwrites them) and never shrinks the allocation, so loading an image of
+ * the same or a smaller size costs nothing. Storage is aligned to kAlignment
+ * bytes, a cache line and a multiple of every SIMD width we use.
+ */
+template <typename T>
+class AlignedBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "AlignedBuffer skips construction");
+
+public:
+    static constexpr size_t kAlignment = 64;
+
+    AlignedBuffer() = default;
+    ~AlignedBuffer() { release(); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    /**
+     * @brief Sets the element count. Reallocates (discarding the contents) only
+     * when the count exceeds the capacity; new elements are uninitialized.
+     */
+    void resize(size_t count) {
+        if (count > capacity) {
+            release();
+            elements = static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(kAlignment)));
+            capacity = count;
+        }
+        length = count;
+    }
+
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+    size_t size() const { return length; }
+    size_t getCapacity() const { return capacity; }
+    bool empty() const { return length == 0; }
+
+    T& operator[](size_t i) { return elements[i]; }
+    const T& operator[](size_t i) const { return elements[i]; }
+
+private:
+    T* elements = nullptr;
+    size_t length = 0;
+    size_t capacity = 0;
+
+    void release() {
+        if (elements) ::operator delete(elements, std::align_val_t(kAlignment));
+        elements = nullptr;
+        length = capacity = 0;
+    }
+};
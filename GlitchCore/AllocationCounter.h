@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Process-wide heap allocation counter for tests and benchmarks.
+ * Counting is only active in the translation unit that defines
+ * GLITCH_TRACK_ALLOCATIONS before including this header: that unit installs
+ * replacement global operator new/delete. Define it in exactly one file.
+ */
+struct AllocationCounter {
+    static inline std::atomic<std::size_t> allocations{0};
+
+    // Number of operator new calls since program start.
+    static std::size_t count() { return allocations.load(std::memory_order_relaxed); }
+};
+
+#ifdef GLITCH_TRACK_ALLOCATIONS
+// GCC pairs inlined free() calls with the operator new call site and warns falsely.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    AllocationCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Over-aligned allocations (AlignedBuffer)
+void* operator new(std::size_t size, std::align_val_t align) {
+    AllocationCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t alignment = static_cast<std::size_t>(align);
+    std::size_t rounded = (size + alignment - 1) / alignment * alignment; // aligned_alloc needs a multiple
+    if (void* p = std::aligned_alloc(alignment, rounded ? rounded : alignment)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
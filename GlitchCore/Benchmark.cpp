@@ -0,0 +1,179 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Native throughput benchmark for every EffectType.
+ *
+ * Renders each effect through GlitchEngine on synthetic images (1 MP to 50 MP),
+ * with a small and a large lens and in full-frame mode (radius 1.5 x max
+ * dimension, as the frontend does). The lens moves a little every frame, like
+ * a mouse drag. Results are printed as JSON so runs can be diffed between commits:
+ * min/median/p99 frame time, megapixels per second (pixels inside the lens,
+ * using the median time) and heap allocations per frame after warm-up.
+ *
+ * Usage: glitch_bench [--quick] [--frames N] [--threads N] [--effect ID]
+ *   --quick     Small images and few frames (smoke test)
+ *   --frames    Timed frames per configuration (default 15)
+ *   --threads   Render threads (default: hardware concurrency)
+ *   --effect    Only benchmark this effect id
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "Common.h"
+
+// Count every heap allocation in this binary (see AllocationCounter.h)
+#define GLITCH_TRACK_ALLOCATIONS
+#include "AllocationCounter.h"
+
+// Include the Engine (Unity build approach, same as bindings.cpp)
+#include "GlitchEngine.cpp"
+
+// --- CONFIGURATION ---
+
+struct BenchOptions {
+    bool quick = false;
+    int frames = 15;
+    int threads = TileScheduler::defaultThreadCount();
+    int effect = 0; // 0 = all
+};
+
+struct ImageSize {
+    int width;
+    int height;
+};
+
+struct BenchStats {
+    double minMs;
+    double medianMs;
+    double p99Ms;
+    double allocationsPerFrame;
+};
+
+// --- HELPER FUNCTIONS ---
+
+BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quick") options.quick = true;
+        else if (arg == "--frames" && hasValue) options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--effect" && hasValue) options.effect = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Usage: glitch_bench [--quick] [--frames N] [--threads N] [--effect ID]" << std::endl;
+            std::exit(2);
+        }
+    }
+    if (options.quick) options.frames = std::min(options.frames, 3);
+    return options;
+}
+
+// Pixels inside the lens, clipped to the image
+long long lensPixels(const EffectParams& params, int width, int height) {
+    LensMask mask;
+    Region region = lensRegion(params, width, height);
+    mask.update(params, region);
+
+    long long pixels = 0;
+    for (int y = region.y; y < region.y + region.height; y++) {
+        int x0, x1;
+        if (mask.span(y, x0, x1)) pixels += x1 - x0;
+    }
+    return pixels;
+}
+
+double percentile(std::vector<double> sorted, double p) {
+    size_t index = static_cast<size_t>(std::ceil(p * sorted.size())) - 1;
+    return sorted[std::min(sorted.size() - 1, index)];
+}
+
+/**
+ * @brief Renders one warm-up frame and then 'frames' timed frames, moving the lens.
+ */
+BenchStats measure(GlitchEngine& engine, int effectId, int cx, int cy, int radius, int frames) {
+    const float intensity = 50.0f;
+    engine.renderFrame(cx, cy, radius, effectId, intensity); // Warm-up: instances, scratch, caches
+
+    std::vector<double> times;
+    times.reserve(frames); // Keep the bench's own allocations out of the count
+    size_t allocationsBefore = AllocationCounter::count();
+    for (int f = 0; f < frames; f++) {
+        int dx = static_cast<int>(8 * std::cos(f * 0.7));
+        int dy = static_cast<int>(8 * std::sin(f * 0.7));
+
+        auto start = std::chrono::steady_clock::now();
+        engine.renderFrame(cx + dx, cy + dy, radius, effectId, intensity);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    size_t allocations = AllocationCounter::count() - allocationsBefore;
+
+    std::sort(times.begin(), times.end());
+    return {times.front(), percentile(times, 0.5), percentile(times, 0.99),
+            static_cast<double>(allocations) / frames};
+}
+
+// --- MAIN ---
+
+int main(int argc, char** argv) {
+    BenchOptions options = parseOptions(argc, argv);
+
+    std::vector<ImageSize> sizes = options.quick
+        ? std::vector<ImageSize>{{320, 240}, {640, 480}}
+        : std::vector<ImageSize>{{1152, 864}, {2304, 1728}, {4608, 3456}, {8160, 6120}}; // 1, 4, 16, 50 MP
+    std::vector<int> radii = options.quick ? std::vector<int>{32} : std::vector<int>{64, 256};
+
+    std::cout << "{\n  \"threads\": " << options.threads << ",\n  \"frames\": " << options.frames
+              << ",\n  \"simd\": " << (GLITCH_SIMD ? "true" : "false") << ",\n  \"results\": [";
+
+    bool first = true;
+    for (const ImageSize& size : sizes) {
+        GlitchEngine engine;
+        engine.setThreadCount(options.threads);
+        engine.loadBox(size.width, size.height);
+
+        Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+        for (size_t i = 0; i < static_cast<size_t>(size.width) * size.height; i++) {
+            original[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 13 + (i >> 9)), static_cast<uint8_t>(i >> 5), 255};
+        }
+
+        int cx = size.width / 2, cy = size.height / 2;
+        std::vector<int> frameRadii = radii;
+        frameRadii.push_back(static_cast<int>(std::max(size.width, size.height) * 1.5)); // Full-frame mode
+
+        for (int id = 1; id < kEffectTypeCount; id++) {
+            if (options.effect != 0 && options.effect != id) continue;
+
+            for (size_t r = 0; r < frameRadii.size(); r++) {
+                bool fullFrame = r + 1 == frameRadii.size();
+                int radius = frameRadii[r];
+                BenchStats stats = measure(engine, id, cx, cy, radius, options.frames);
+
+                EffectParams params = {50.0f, true, cx, cy, radius};
+                long long pixels = lensPixels(params, size.width, size.height);
+                double mpixPerSecond = (stats.medianMs > 0) ? pixels / (stats.medianMs * 1000.0) : 0.0;
+
+                std::cout << (first ? "\n" : ",\n") << "    {\"effect\": \"" << getEffectName(static_cast<EffectType>(id))
+                          << "\", \"id\": " << id
+                          << ", \"width\": " << size.width << ", \"height\": " << size.height
+                          << ", \"mode\": \"" << (fullFrame ? "full" : "lens") << "\", \"radius\": " << radius
+                          << ", \"pixels\": " << pixels
+                          << ", \"min_ms\": " << stats.minMs << ", \"median_ms\": " << stats.medianMs
+                          << ", \"p99_ms\": " << stats.p99Ms << ", \"mpix_per_s\": " << mpixPerSecond
+                          << ", \"allocs_per_frame\": " << stats.allocationsPerFrame << "}";
+                std::cout.flush();
+                first = false;
+            }
+        }
+    }
+
+    std::cout << "\n  ]\n}" << std::endl;
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 
 /**
  * @brief Represents a single RGBA pixel.
@@ -13,6 +14,11 @@ struct Pixel {
     float getLuminance() const {
         return (0.299f * r) + (0.587f * g) + (0.114f * b);
     }
+
+    // Same Rec.601 weights in 8.8 fixed point (77 + 150 + 29 = 256), rounded to 0..255
+    uint8_t getLuma8() const { // Keep in sync with computeLuma()
+        return static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
 };
 
 /**
@@ -22,6 +28,43 @@ struct Pixel {
 struct Region {
     int x, y;       // Top-left corner
     int width, height;
+
+    bool isEmpty() const { return width <= 0 || height <= 0; }
+};
+
+/**
+ * @brief Clips a region to the image bounds [0, imgWidth) x [0, imgHeight).
+ * Regions that fall completely outside the image collapse to an empty region.
+ */
+inline Region clipRegion(const Region& r, int imgWidth, int imgHeight) {
+    int x0 = std::max(0, r.x);
+    int y0 = std::max(0, r.y);
+    int x1 = std::min(imgWidth, r.x + r.width);
+    int y1 = std::min(imgHeight, r.y + r.height);
+    if (x1 <= x0 || y1 <= y0) return {0, 0, 0, 0};
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+/**
+ * @brief Smallest region containing both inputs. Empty inputs are ignored.
+ */
+inline Region unionRegion(const Region& a, const Region& b) {
+    if (a.isEmpty()) return b;
+    if (b.isEmpty()) return a;
+    int x0 = std::min(a.x, b.x);
+    int y0 = std::min(a.y, b.y);
+    int x1 = std::max(a.x + a.width, b.x + b.width);
+    int y1 = std::max(a.y + a.height, b.y + b.height);
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+/**
+ * @enum RenderQuality
+ * @brief Resampling quality of the geometric effects (Swirl, Ripple).
+ */
+enum class RenderQuality {
+    Drag = 0, // Interactive frames: approximate trig (FastMath.h), nearest sampling
+    Final = 1 // Exported / full-image frames: exact trig, fixed-point bilinear sampling
 };
 
 /**
@@ -34,4 +77,85 @@ struct EffectParams {
     int centerX;    // For bubble effect
     int centerY;    // For bubble effect
     int radius;     // For bubble effect
-};
\ No newline at end of file
+    int feather = 0; // Soft lens edge width in pixels (0 = hard edge)
+    RenderQuality quality = RenderQuality::Drag;
+    uint32_t seed = 0;  // Randomized effects: per-engine seed (see Random.h)
+    uint32_t frame = 0; // Randomized effects: frame index, so noise changes between frames
+    bool linearEdge = false; // Mix the soft lens edge in linear light (see LensMask)
+};
+
+/**
+ * @brief Bounding box of the bubble described by params, clipped to the image.
+ * Without a circle mask the effect covers the whole image.
+ */
+inline Region lensRegion(const EffectParams& params, int imgWidth, int imgHeight) {
+    if (!params.useCircleMask) return clipRegion({0, 0, imgWidth, imgHeight}, imgWidth, imgHeight);
+    return clipRegion({params.centerX - params.radius, params.centerY - params.radius,
+                       2 * params.radius, 2 * params.radius}, imgWidth, imgHeight);
+}
+
+/**
+ * @brief Integer square root: largest r such that r * r <= v (0 for v <= 0).
+ */
+inline long long isqrt(long long v) {
+    if (v <= 0) return 0;
+    long long r = static_cast<long long>(std::sqrt(static_cast<double>(v)));
+    while (r * r > v) --r;
+    while ((r + 1) * (r + 1) <= v) ++r;
+    return r;
+}
+
+/**
+ * @brief Converts a run of pixels to 8-bit luma (Pixel::getLuma8).
+ * Plain integer loop without branches, so compilers vectorize it.
+ */
+inline void computeLuma(const Pixel* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = static_cast<uint8_t>((77 * src[i].r + 150 * src[i].g + 29 * src[i].b + 128) >> 8);
+    }
+}
+
+class SummedAreaTable; // SummedAreaTable.h
+
+/**
+ * @brief Non-owning window onto pixel memory, addressed in full-image coordinates.
+ * The window can cover the whole image or just a sub-rectangle of it (e.g. a
+ * lens-plus-halo snapshot). Effects always index it with absolute (x, y), so
+ * they do not need to know which of the two they were given.
+ */
+template <typename T>
+struct BasicImageView {
+    T* data = nullptr;            // Pixel at (bounds.x, bounds.y)
+    int stride = 0;               // Pixels per row of data
+    Region bounds = {0, 0, 0, 0}; // Part of the image actually backed by data
+    int width = 0;                // Full image width (used for clamping)
+    int height = 0;               // Full image height (used for clamping)
+
+    // Optional cached luma of the same pixels: full image, 'width' bytes per row.
+    // Only set for views of the unmodified original (see IEffect::usesLuma).
+    const uint8_t* luma = nullptr;
+
+    // Optional summed-area table of the same pixels (see IEffect::usesIntegral).
+    // Like luma, only set for views of the unmodified original.
+    const SummedAreaTable* integral = nullptr;
+
+    T& at(int x, int y) const {
+        return data[static_cast<size_t>(y - bounds.y) * stride + (x - bounds.x)];
+    }
+
+    uint8_t lumaAt(int x, int y) const {
+        return luma ? luma[static_cast<size_t>(y) * width + x] : at(x, y).getLuma8();
+    }
+
+    // View over a complete, tightly packed image buffer.
+    static BasicImageView whole(T* pixels, int imgWidth, int imgHeight) {
+        return {pixels, imgWidth, {0, 0, imgWidth, imgHeight}, imgWidth, imgHeight};
+    }
+};
+
+using ImageView = BasicImageView<Pixel>;        // Writable destination
+using SourceView = BasicImageView<const Pixel>; // Read-only effect input
+
+inline SourceView asSource(const ImageView& view) {
+    return {view.data, view.stride, view.bounds, view.width, view.height};
+}
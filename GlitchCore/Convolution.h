@@ -0,0 +1,397 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include "Common.h"
+#include "LensMask.h"
+#include "Simd.h"
+
+/**
+ * @struct SeparableKernel
+ * @brief 1D kernel with non-negative weights in 1/256 steps that sum to exactly 256.
+ * Applied once horizontally and once vertically it gives a 2D smoothing kernel.
+ */
+struct SeparableKernel {
+    static constexpr int kMaxRadius = 12;
+
+    int radius = 0;
+    uint16_t weights[2 * kMaxRadius + 1] = {256};
+
+    /**
+     * @brief Gaussian of the given radius (sigma = radius / 2), quantized so
+     * the weights still sum to 256.
+     */
+    static SeparableKernel gaussian(int radius) {
+        SeparableKernel k;
+        k.radius = std::max(0, std::min(kMaxRadius, radius));
+        if (k.radius == 0) return k;
+
+        double sigma = k.radius / 2.0;
+        double raw[2 * kMaxRadius + 1];
+        double sum = 0;
+        for (int i = -k.radius; i <= k.radius; ++i) {
+            raw[i + k.radius] = std::exp(-(i * i) / (2 * sigma * sigma));
+            sum += raw[i + k.radius];
+        }
+
+        // Round the outer taps and give the remainder to the center tap
+        int total = 0;
+        for (int i = 0; i <= 2 * k.radius; ++i) {
+            if (i == k.radius) continue;
+            k.weights[i] = static_cast<uint16_t>(raw[i] / sum * 256.0 + 0.5);
+            total += k.weights[i];
+        }
+        k.weights[k.radius] = static_cast<uint16_t>(256 - total);
+        return k;
+    }
+};
+
+/**
+ * @class Convolution
+ * @brief Fixed-point convolution over the lens region, shared by filter effects.
+ *
+ * The region plus a border is first copied into a padded block whose border
+ * replicates the image edge, so the inner loops never clamp coordinates.
+ * Two paths are provided:
+ * - separable(): a SeparableKernel applied horizontally then vertically.
+ *   Both passes are the same weighted sum of shifted inputs, vectorized in
+ *   16-bit lanes and bit-exact with weightedSumScalar().
+ * - kernel3x3(): any 3x3 kernel with signed weights (sharpen, emboss, ...),
+ *   vectorized with pairs of taps summed in 32-bit lanes.
+ * Edge detectors work on an 8-bit luma block instead (paddedLuma()); the
+ * Sobel operator runs on it as signed separable passes (sobelMagnitude()).
+ *
+ * An instance keeps its buffers between frames, so effects own one each.
+ */
+class Convolution {
+public:
+    /**
+     * @brief Weighted sum of 'taps' inputs: out[i] = sum(inputs[k][i] * weights[k]) / 256, rounded.
+     * Weights must sum to 256, which keeps every intermediate inside 16 bits.
+     */
+    static void weightedSum(const Pixel* const* inputs, const uint16_t* weights, int taps, Pixel* out, int count) {
+        int i = 0;
+
+#if GLITCH_SIMD
+        Simd::Vec half = Simd::splat16(128);
+        for (; i + Simd::kPixels <= count; i += Simd::kPixels) {
+            Simd::Vec lo = half;
+            Simd::Vec hi = half;
+            for (int k = 0; k < taps; ++k) {
+                Simd::Vec v = Simd::load(inputs[k] + i);
+                Simd::Vec w = Simd::splat16(weights[k]);
+                lo = Simd::add16(lo, Simd::mul16(Simd::widenLo(v), w));
+                hi = Simd::add16(hi, Simd::mul16(Simd::widenHi(v), w));
+            }
+            Simd::store(out + i, Simd::narrowSat(Simd::shr16<8>(lo), Simd::shr16<8>(hi)));
+        }
+#endif
+
+        weightedSumScalar(inputs, weights, taps, out, i, count);
+    }
+
+    /**
+     * @brief Reference implementation of weightedSum() for pixels [begin, end).
+     */
+    static void weightedSumScalar(const Pixel* const* inputs, const uint16_t* weights, int taps,
+                                  Pixel* out, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int r = 128, g = 128, b = 128, a = 128;
+            for (int k = 0; k < taps; ++k) {
+                Pixel p = inputs[k][i];
+                r += p.r * weights[k];
+                g += p.g * weights[k];
+                b += p.b * weights[k];
+                a += p.a * weights[k];
+            }
+            out[i] = {static_cast<uint8_t>(r >> 8), static_cast<uint8_t>(g >> 8),
+                      static_cast<uint8_t>(b >> 8), static_cast<uint8_t>(a >> 8)};
+        }
+    }
+
+    /**
+     * @brief Applies kernel horizontally and vertically inside the lens.
+     */
+    void separable(const SourceView& source, const ImageView& dest, const Region& region,
+                   const LensMask& mask, const SeparableKernel& kernel) {
+        int r = kernel.radius;
+        int taps = 2 * r + 1;
+        const Pixel* inputs[2 * SeparableKernel::kMaxRadius + 1];
+
+        padRegion(source, region, r);
+
+        // Horizontal pass over every padded row (the vertical pass needs r rows above and below)
+        int rows = region.height + 2 * r;
+        size_t needed = static_cast<size_t>(rows) * region.width;
+        if (horizontal.size() < needed) horizontal.resize(needed);
+        for (int row = 0; row < rows; ++row) {
+            const Pixel* in = &padded[static_cast<size_t>(row) * paddedStride];
+            for (int k = 0; k < taps; ++k) inputs[k] = in + k;
+            weightedSum(inputs, kernel.weights, taps, &horizontal[static_cast<size_t>(row) * region.width], region.width);
+        }
+
+        // Vertical pass, only over the lens spans
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask.span(y, x0, x1)) continue;
+            for (int k = 0; k < taps; ++k) {
+                inputs[k] = &horizontal[static_cast<size_t>(y - region.y + k) * region.width + (x0 - region.x)];
+            }
+            weightedSum(inputs, kernel.weights, taps, &dest.at(x0, y), x1 - x0);
+        }
+    }
+
+    /**
+     * @brief Applies a 3x3 kernel (row-major, fixed point with 'shift' fraction bits)
+     * to the RGB channels inside the lens. Alpha is copied from the center pixel.
+     * Sums are kept in 32-bit lanes, so weights may be anything in [-32768, 32767].
+     * @param bias Added to every channel after scaling (e.g. 128 for a grey base).
+     */
+    void kernel3x3(const SourceView& source, const ImageView& dest, const Region& region,
+                   const LensMask& mask, const int (&kernel)[9], int shift, int bias = 0) {
+        padRegion(source, region, 1);
+
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask.span(y, x0, x1)) continue;
+
+            // Top-left tap of the first pixel of the span
+            const Pixel* top = &padded[static_cast<size_t>(y - region.y) * paddedStride + (x0 - region.x)];
+            const Pixel* rowsIn[3] = {top, top + paddedStride, top + 2 * paddedStride};
+            kernelRow(rowsIn, kernel, shift, bias, &dest.at(x0, y), x1 - x0);
+        }
+    }
+
+    /**
+     * @brief One output run of kernel3x3(). rows[0..2] point at the left tap of
+     * pixel 0 in the rows above, at and below it; each holds count + 2 pixels.
+     */
+    static void kernelRow(const Pixel* const (&rows)[3], const int (&kernel)[9], int shift, int bias,
+                          Pixel* out, int count) {
+        int i = 0;
+
+#if GLITCH_SIMD
+        // Taps are paired so one multiply-add gives w0 * p0 + w1 * p1 per channel
+        // in a 32-bit lane; the ninth tap is paired with a zero weight.
+        Simd::Vec weights[5];
+        for (int k = 0; k < 5; ++k) {
+            int w0 = kernel[2 * k];
+            int w1 = (2 * k + 1 < 9) ? kernel[2 * k + 1] : 0;
+            weights[k] = Simd::splat32(static_cast<uint16_t>(w0) | (static_cast<uint32_t>(static_cast<uint16_t>(w1)) << 16));
+        }
+        Simd::Vec round = Simd::splat32(static_cast<uint32_t>((shift > 0) ? (1 << (shift - 1)) : 0));
+        Simd::Vec offset = Simd::splat32(static_cast<uint32_t>(bias));
+        Simd::Vec alpha = Simd::alphaMask();
+        Simd::Vec zero = Simd::splat32(0);
+
+        for (; i + Simd::kPixels <= count; i += Simd::kPixels) {
+            Simd::Vec sums[4] = {round, round, round, round}; // One per pixel: R, G, B, A lanes
+            for (int k = 0; k < 5; ++k) {
+                int t0 = 2 * k, t1 = 2 * k + 1;
+                Simd::Vec a = Simd::load(rows[t0 / 3] + i + t0 % 3);
+                Simd::Vec b = (t1 < 9) ? Simd::load(rows[t1 / 3] + i + t1 % 3) : zero;
+                Simd::Vec aLo = Simd::widenLo(a), aHi = Simd::widenHi(a);
+                Simd::Vec bLo = Simd::widenLo(b), bHi = Simd::widenHi(b);
+                sums[0] = Simd::add32(sums[0], Simd::maddPairs16(Simd::interleave16Lo(aLo, bLo), weights[k]));
+                sums[1] = Simd::add32(sums[1], Simd::maddPairs16(Simd::interleave16Hi(aLo, bLo), weights[k]));
+                sums[2] = Simd::add32(sums[2], Simd::maddPairs16(Simd::interleave16Lo(aHi, bHi), weights[k]));
+                sums[3] = Simd::add32(sums[3], Simd::maddPairs16(Simd::interleave16Hi(aHi, bHi), weights[k]));
+            }
+            for (Simd::Vec& sum : sums) sum = Simd::add32(Simd::sra32(sum, shift), offset);
+
+            // Saturating narrows clamp to [0, 255] exactly like clampChannel()
+            Simd::Vec v = Simd::narrowSat(Simd::narrow32Sat(sums[0], sums[1]), Simd::narrow32Sat(sums[2], sums[3]));
+            Simd::store(out + i, Simd::select(alpha, Simd::load(rows[1] + i + 1), v));
+        }
+#endif
+
+        kernelRowScalar(rows, kernel, shift, bias, out, i, count);
+    }
+
+    /**
+     * @brief Reference implementation of kernelRow() for pixels [begin, end).
+     */
+    static void kernelRowScalar(const Pixel* const (&rows)[3], const int (&kernel)[9], int shift, int bias,
+                                Pixel* out, int begin, int end) {
+        int round = (shift > 0) ? (1 << (shift - 1)) : 0;
+        for (int i = begin; i < end; ++i) {
+            int r = 0, g = 0, b = 0;
+            for (int ky = 0; ky < 3; ++ky) {
+                for (int kx = 0; kx < 3; ++kx) {
+                    Pixel p = rows[ky][i + kx];
+                    int w = kernel[ky * 3 + kx];
+                    r += p.r * w;
+                    g += p.g * w;
+                    b += p.b * w;
+                }
+            }
+            out[i] = {clampChannel(((r + round) >> shift) + bias), clampChannel(((g + round) >> shift) + bias),
+                      clampChannel(((b + round) >> shift) + bias), rows[1][i + 1].a};
+        }
+    }
+
+    /**
+     * @brief Sobel gradient magnitude of the luma inside the lens, min(255, |G|).
+     * Both gradients are signed separable passes: across each padded luma row a
+     * [1 2 1] smoothing and a [-1 0 1] difference (16-bit lanes), then down each
+     * column the opposite pair. The magnitude is a float-lane square root.
+     * @return Magnitudes of the region, region.width bytes per row; only the lens spans are written.
+     */
+    const uint8_t* sobelMagnitude(const SourceView& source, const Region& region, const LensMask& mask) {
+        const uint8_t* lumaIn = paddedLuma(source, region, 1);
+        int rows = region.height + 2;
+        size_t needed = static_cast<size_t>(rows) * region.width;
+        if (smooth.size() < needed) smooth.resize(needed);
+        if (difference.size() < needed) difference.resize(needed);
+        if (magnitude.size() < static_cast<size_t>(region.width) * region.height) {
+            magnitude.resize(static_cast<size_t>(region.width) * region.height);
+        }
+
+        for (int row = 0; row < rows; ++row) {
+            size_t offset = static_cast<size_t>(row) * region.width;
+            gradientRow(lumaIn + static_cast<size_t>(row) * lumaStride, &smooth[offset], &difference[offset], region.width);
+        }
+
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask.span(y, x0, x1)) continue;
+            size_t above = static_cast<size_t>(y - region.y) * region.width + (x0 - region.x);
+            size_t below = above + 2 * static_cast<size_t>(region.width);
+            magnitudeRow(&smooth[above], &smooth[below], &difference[above], region.width,
+                         &magnitude[above], x1 - x0);
+        }
+        return magnitude.data();
+    }
+
+    /**
+     * @brief Horizontal Sobel pass over one padded luma row (count + 2 bytes):
+     * smooth[i] = l[i] + 2 l[i+1] + l[i+2], diff[i] = l[i+2] - l[i].
+     */
+    static void gradientRow(const uint8_t* luma, int16_t* smooth, int16_t* diff, int count) {
+        int i = 0;
+#if GLITCH_SIMD
+        // 16 outputs per iteration; the loads stay inside the row (i + 18 <= count + 2)
+        for (; i + 16 <= count; i += 16) {
+            Simd::Vec left = Simd::load(luma + i), mid = Simd::load(luma + i + 1), right = Simd::load(luma + i + 2);
+            Simd::Vec l[2] = {Simd::widenLo(left), Simd::widenHi(left)};
+            Simd::Vec m[2] = {Simd::widenLo(mid), Simd::widenHi(mid)};
+            Simd::Vec r[2] = {Simd::widenLo(right), Simd::widenHi(right)};
+            for (int h = 0; h < 2; ++h) {
+                Simd::store(smooth + i + 8 * h, Simd::add16(Simd::add16(l[h], r[h]), Simd::add16(m[h], m[h])));
+                Simd::store(diff + i + 8 * h, Simd::sub16(r[h], l[h]));
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            smooth[i] = static_cast<int16_t>(luma[i] + 2 * luma[i + 1] + luma[i + 2]);
+            diff[i] = static_cast<int16_t>(luma[i + 2] - luma[i]);
+        }
+    }
+
+    /**
+     * @brief Vertical Sobel pass and magnitude for one output run. 'smoothAbove' /
+     * 'diffAbove' point at the row above the output, rows are 'stride' apart.
+     */
+    static void magnitudeRow(const int16_t* smoothAbove, const int16_t* smoothBelow, const int16_t* diffAbove,
+                             int stride, uint8_t* out, int count) {
+        const int16_t* diffCenter = diffAbove + stride;
+        const int16_t* diffBelow = diffCenter + stride;
+        int i = 0;
+#if GLITCH_SIMD
+        for (; i + 16 <= count; i += 16) {
+            Simd::Vec squares[4];
+            for (int h = 0; h < 2; ++h) {
+                int at = i + 8 * h;
+                Simd::Vec center = Simd::load(diffCenter + at);
+                Simd::Vec gx = Simd::add16(Simd::add16(Simd::load(diffAbove + at), Simd::load(diffBelow + at)), Simd::add16(center, center));
+                Simd::Vec gy = Simd::sub16(Simd::load(smoothBelow + at), Simd::load(smoothAbove + at));
+                // Interleaved (gx, gy) pairs multiplied with themselves: gx^2 + gy^2 per 32-bit lane
+                Simd::Vec lo = Simd::interleave16Lo(gx, gy), hi = Simd::interleave16Hi(gx, gy);
+                squares[2 * h] = Simd::sqrtFloor32(Simd::maddPairs16(lo, lo));
+                squares[2 * h + 1] = Simd::sqrtFloor32(Simd::maddPairs16(hi, hi));
+            }
+            Simd::store(out + i, Simd::narrowSat(Simd::narrow32Sat(squares[0], squares[1]), Simd::narrow32Sat(squares[2], squares[3])));
+        }
+#endif
+        for (; i < count; ++i) {
+            int gx = diffAbove[i] + 2 * diffCenter[i] + diffBelow[i];
+            int gy = smoothBelow[i] - smoothAbove[i];
+            int length = static_cast<int>(std::sqrt(static_cast<float>(gx * gx + gy * gy)));
+            out[i] = static_cast<uint8_t>(std::min(255, length));
+        }
+    }
+
+    /**
+     * @brief Copies the luma of the region plus a border into a padded 8-bit block.
+     * Reads the source's cached luma plane when it has one, otherwise converts.
+     * @return Pointer to the luma of (region.x - pad, region.y - pad); rows are getLumaStride() apart.
+     */
+    const uint8_t* paddedLuma(const SourceView& source, const Region& region, int pad) {
+        lumaStride = region.width + 2 * pad;
+        size_t needed = static_cast<size_t>(lumaStride) * (region.height + 2 * pad);
+        if (luma.size() < needed) luma.resize(needed);
+
+        int left = std::min(pad, region.x);
+        int right = std::min(pad, source.width - (region.x + region.width));
+        int runStart = region.x - left;
+        int runLength = region.width + left + right;
+
+        for (int row = 0; row < region.height + 2 * pad; ++row) {
+            int sy = clampCoord(region.y - pad + row, source.height);
+            uint8_t* out = &luma[static_cast<size_t>(row) * lumaStride];
+            uint8_t* run = out + (pad - left);
+
+            if (source.luma) {
+                const uint8_t* in = source.luma + static_cast<size_t>(sy) * source.width + runStart;
+                std::copy(in, in + runLength, run);
+            } else {
+                computeLuma(&source.at(runStart, sy), run, runLength);
+            }
+            std::fill(out, run, run[0]);
+            std::fill(run + runLength, out + lumaStride, run[runLength - 1]);
+        }
+        return luma.data();
+    }
+
+    int getLumaStride() const { return lumaStride; }
+
+private:
+    // Reused between frames
+    std::vector<Pixel> padded;     // Region plus border, edges replicated
+    std::vector<Pixel> horizontal; // Output of the horizontal separable pass
+    std::vector<uint8_t> luma;     // Padded luma block for edge detectors
+    std::vector<int16_t> smooth;     // Sobel: [1 2 1] across each padded luma row
+    std::vector<int16_t> difference; // Sobel: [-1 0 1] across each padded luma row
+    std::vector<uint8_t> magnitude;  // Sobel: gradient magnitude of the region
+    int paddedStride = 0;
+    int lumaStride = 0;
+
+    static int clampCoord(int v, int size) { return std::max(0, std::min(size - 1, v)); }
+    static uint8_t clampChannel(int v) { return static_cast<uint8_t>(std::max(0, std::min(255, v))); }
+
+    /**
+     * @brief Copies region grown by 'pad' on every side into 'padded'. Coordinates
+     * outside the image repeat the nearest edge pixel, so only the border clamps.
+     */
+    void padRegion(const SourceView& source, const Region& region, int pad) {
+        paddedStride = region.width + 2 * pad;
+        size_t needed = static_cast<size_t>(paddedStride) * (region.height + 2 * pad);
+        if (padded.size() < needed) padded.resize(needed);
+
+        // Columns of the region that exist in the image are copied in one run
+        int left = std::min(pad, region.x);
+        int right = std::min(pad, source.width - (region.x + region.width));
+        int runStart = region.x - left;
+        int runLength = region.width + left + right;
+
+        for (int row = 0; row < region.height + 2 * pad; ++row) {
+            int sy = clampCoord(region.y - pad + row, source.height);
+            Pixel* out = &padded[static_cast<size_t>(row) * paddedStride];
+            const Pixel* in = &source.at(runStart, sy);
+
+            for (int i = 0; i < pad - left; ++i) out[i] = in[0];
+            std::copy(in, in + runLength, out + (pad - left));
+            for (int i = pad - left + runLength; i < paddedStride; ++i) out[i] = in[runLength - 1];
+        }
+    }
+};
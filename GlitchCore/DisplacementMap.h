@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "Common.h"
+
+/**
+ * @brief Source offset of one lens pixel, in fixed point (1/16 pixel).
+ * The sample position of pixel (x, y) is (x + x/16, y + y/16), floored.
+ * Offsets are 32-bit: full-image lenses (radius 1.5 x the image size) swirl
+ * pixels by up to twice their distance from the center, thousands of pixels.
+ */
+struct Displacement {
+    static constexpr int kFractionBits = 4;
+    static constexpr float kScale = 1 << kFractionBits;
+
+    int32_t x, y;
+
+    static Displacement fromFloat(float offsetX, float offsetY) {
+        return {quantize(offsetX), quantize(offsetY)};
+    }
+
+    // Integer part (floor) of the offsets
+    int wholeX() const { return x >> kFractionBits; }
+    int wholeY() const { return y >> kFractionBits; }
+
+    // Fractional part, 0 .. 15
+    int fracX() const { return x & ((1 << kFractionBits) - 1); }
+    int fracY() const { return y & ((1 << kFractionBits) - 1); }
+
+private:
+    static int32_t quantize(float v) {
+        long long q = std::llround(v * kScale);
+        return static_cast<int32_t>(std::max<long long>(INT32_MIN, std::min<long long>(INT32_MAX, q)));
+    }
+};
+
+/**
+ * @class DisplacementMap
+ * @brief Cached displacement field of a geometric effect, relative to the lens center.
+ *
+ * Swirl and Ripple displace each pixel by an amount that only depends on its
+ * position relative to the center, the radius and the intensity, so moving the
+ * lens just translates the field. The map stores one Displacement per pixel of
+ * the lens box and is reused until the radius, intensity or quality changes.
+ *
+ * One map is shared by the instances of an effect on all worker threads (see
+ * IEffect::shareCaches), so it is held once and every row is evaluated once,
+ * by whichever worker renders it first. Rows are claimed with an atomic state;
+ * a worker that finds a row still being filled by another one evaluates the
+ * field directly instead of waiting. Lenses whose box exceeds kMaxEntries are
+ * not cached (update() returns false) and the effect evaluates its field
+ * directly; all paths use the same quantized offsets, so the output does not
+ * depend on which one ran.
+ */
+class DisplacementMap {
+public:
+    static constexpr size_t kMaxEntries = size_t(1) << 21; // 16 MB: lens radius up to 723
+
+    /**
+     * @brief Prepares the map for a frame. Clears it if radius, intensity or quality changed.
+     * Every worker calls it with the same parameters; only the first call of a
+     * frame can change the map, before any row of that frame is read.
+     * @return false if the lens is too large (or has no circle) and must not be cached.
+     */
+    bool update(const EffectParams& params) {
+        if (!params.useCircleMask) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (params.radius == radius && params.intensity == cachedIntensity && params.quality == cachedQuality) {
+            return cacheable;
+        }
+        radius = std::max(0, params.radius);
+        cachedIntensity = params.intensity;
+        cachedQuality = params.quality;
+        side = 2 * radius + 1;
+
+        cacheable = static_cast<size_t>(side) * side <= kMaxEntries;
+        if (!cacheable) return false;
+
+        offsets.resize(static_cast<size_t>(side) * side);
+        if (rowCapacity < static_cast<size_t>(side)) {
+            rowState.reset(new std::atomic<uint8_t>[side]);
+            rowCapacity = side;
+        }
+        for (int i = 0; i < side; ++i) rowState[i].store(kEmpty, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Displacements of the row at 'dy' from the center, indexed by dx in [-radius, radius].
+     * @param field Callable field(dx, dy) -> Displacement, used to fill the row on first use.
+     * @return nullptr while another thread is filling the row (evaluate the field directly).
+     */
+    template <typename Field>
+    const Displacement* row(int dy, Field&& field) {
+        Displacement* out = &offsets[static_cast<size_t>(dy + radius) * side + radius];
+        std::atomic<uint8_t>& state = rowState[dy + radius];
+        uint8_t current = state.load(std::memory_order_acquire);
+        if (current == kReady) return out;
+
+        if (current == kEmpty && state.compare_exchange_strong(current, kFilling, std::memory_order_acquire)) {
+            for (int dx = -radius; dx <= radius; ++dx) out[dx] = field(dx, dy);
+            state.store(kReady, std::memory_order_release);
+            return out;
+        }
+        return current == kReady ? out : nullptr;
+    }
+
+private:
+    int radius = -1;
+    int side = 0;
+    float cachedIntensity = 0.0f;
+    RenderQuality cachedQuality = RenderQuality::Drag;
+    bool cacheable = false;
+
+    static constexpr uint8_t kEmpty = 0, kFilling = 1, kReady = 2;
+
+    std::mutex mutex; // Serializes update() between the workers sharing the map
+    std::vector<Displacement> offsets;                // side x side, row-major, center in the middle
+    std::unique_ptr<std::atomic<uint8_t>[]> rowState; // kEmpty / kFilling / kReady per row
+    size_t rowCapacity = 0;
+};
+
+/**
+ * @brief Reads the displaced source pixel for (x, y) + d. (sx, sy) = floor position,
+ * already inside the image. The Final tier blends the 2x2 neighbourhood with
+ * the 1/16 fractions in fixed point (weights sum to 256, edges clamped).
+ */
+inline Pixel sampleDisplaced(const SourceView& source, int sx, int sy, Displacement d, RenderQuality quality) {
+    if (quality != RenderQuality::Final) return source.at(sx, sy);
+
+    int fx = d.fracX(), fy = d.fracY();
+    int nx = std::min(sx + 1, source.width - 1);
+    int ny = std::min(sy + 1, source.height - 1);
+    Pixel p00 = source.at(sx, sy), p10 = source.at(nx, sy);
+    Pixel p01 = source.at(sx, ny), p11 = source.at(nx, ny);
+
+    int w00 = (16 - fx) * (16 - fy), w10 = fx * (16 - fy);
+    int w01 = (16 - fx) * fy, w11 = fx * fy;
+    auto mix = [&](uint8_t Pixel::*c) {
+        return static_cast<uint8_t>((p00.*c * w00 + p10.*c * w10 + p01.*c * w01 + p11.*c * w11 + 128) >> 8);
+    };
+    return {mix(&Pixel::r), mix(&Pixel::g), mix(&Pixel::b), mix(&Pixel::a)};
+}
@@ -0,0 +1,441 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include "EffectRegistry.h"
+#include "PointwiseEffect.h"
+#include "TileScheduler.h"
+
+/**
+ * @brief One step of an effect chain: which effect to run and with what parameters.
+ */
+struct EffectStage {
+    EffectType type;
+    EffectParams params;
+};
+
+/**
+ * @class EffectChain
+ * @brief Runs an ordered list of effects over the display buffer.
+ *
+ * The display buffer always holds the latest result, and it equals the original
+ * wherever no stage has written yet. Stages therefore ping-pong between:
+ * - the original image, for the first stage that writes (no copy at all),
+ * - a halo-sized snapshot of the display, for later neighbourhood stages.
+ *
+ * Consecutive point-wise stages (Invert, Solarize, RGBNoise, ...) are fused:
+ * each row tile is run through every stage of the group before moving on, so
+ * the group touches memory once instead of once per stage.
+ *
+ * Large regions are split into row or column bands (as declared by each effect's
+ * getParallelism()) and rendered on the TileScheduler. Every worker has its own
+ * effect instances, so effect scratch storage is never shared between threads.
+ *
+ * begin()/step() run the same chain incrementally: each step renders one slice
+ * of about kSlicePixels, cut along the same band direction, so a caller can
+ * spread a heavy frame over several event-loop turns.
+ *
+ * runPointwise() runs point-wise chains on 16-bit or float images (for example
+ * linear light decoded with LinearImage). The fused row pass is a template
+ * instantiated per pixel format, so the 8-bit path is unchanged.
+ */
+class EffectChain {
+public:
+    static constexpr int kMinBandPixels = 16384; // Smaller bands cost more to schedule than to render
+    static constexpr int kBandsPerThread = 4;    // Spare bands so work stealing can even out uneven rows
+    static constexpr int kSlicePixels = 65536;   // Work of one step(): a 256 x 256 tile
+
+    /**
+     * @brief Executes the stages in order.
+     * @param scheduler Worker pool used for large regions.
+     * @param stages Ordered stages. Unknown/NONE effects are skipped.
+     * @param count Number of stages.
+     * @param original The clean image (read-only).
+     * @param display Output buffer; must equal original on entry.
+     * @return Union of the areas written by all stages, clipped to the image.
+     */
+    Region run(TileScheduler& scheduler, const EffectStage* stages, int count,
+               const SourceView& original, const ImageView& display) {
+        int threads = scheduler.getThreadCount();
+        if (static_cast<int>(registries.size()) != threads) registries.resize(threads);
+        if (static_cast<int>(fusedWorkers.size()) != threads) fusedWorkers.resize(threads);
+
+        Region dirty = {0, 0, 0, 0};
+        int i = 0;
+
+        while (i < count) {
+            IEffect* effect = registries[0].get(stages[i].type);
+            if (!effect) { ++i; continue; }
+
+            if (effect->asPointwise()) {
+                // Gather the run of consecutive point-wise stages into one fused group
+                fused.clear();
+                for (; i < count; ++i) {
+                    IEffect* next = registries[0].get(stages[i].type);
+                    if (!next) continue;
+                    if (!next->asPointwise()) break;
+
+                    Region region = lensRegion(stages[i].params, display.width, display.height);
+                    if (!region.isEmpty()) fused.push_back({stages[i].type, &stages[i].params, region});
+                }
+                dirty = unionRegion(dirty, runFused(scheduler, display));
+                continue;
+            }
+
+            const EffectParams& params = stages[i].params;
+            Region region = lensRegion(params, display.width, display.height);
+            if (!region.isEmpty()) {
+                // Nothing written yet: read straight from the original.
+                // Otherwise read the previous result from a halo snapshot of the display.
+                SourceView source = dirty.isEmpty() ? original : effect->prepareSource(display, region, params);
+                runBands(scheduler, stages[i].type, source, display, region, params);
+
+                dirty = unionRegion(dirty, clipRegion(effect->getDirtyBounds(region, params),
+                                                      display.width, display.height));
+            }
+            ++i;
+        }
+        return dirty;
+    }
+
+    /**
+     * @brief Starts an incremental run of the stages; step() then renders it slice by slice.
+     * Same contract as run(). The stages are copied, the views must stay valid until
+     * the job completes. Starting a new job abandons the previous one.
+     */
+    void begin(const EffectStage* stages, int count, const SourceView& original, const ImageView& display) {
+        if (registries.empty()) registries.resize(1);
+        jobStages.assign(stages, stages + count); // Not resized below: jobFused points into it
+        jobFused.clear();
+        jobUnits.clear();
+        jobOriginal = original;
+        jobDisplay = display;
+        jobDirty = {0, 0, 0, 0};
+        lastSlice = {0, 0, 0, 0};
+        jobUnit = 0;
+        jobSlice = 0;
+        slicesDone = 0;
+        slicesTotal = 0;
+
+        // Same grouping as run(): fused point-wise groups and single stages
+        int i = 0;
+        while (i < count) {
+            IEffect* effect = registries[0].get(stages[i].type);
+            if (!effect) { ++i; continue; }
+
+            JobUnit unit = {};
+            if (effect->asPointwise()) {
+                bool serial = false;
+                unit.fused = true;
+                unit.fusedBegin = static_cast<int>(jobFused.size());
+                for (; i < count; ++i) {
+                    IEffect* next = registries[0].get(stages[i].type);
+                    if (!next) continue;
+                    if (!next->asPointwise()) break;
+
+                    Region region = lensRegion(stages[i].params, display.width, display.height);
+                    if (region.isEmpty()) continue;
+                    jobFused.push_back({stages[i].type, &jobStages[i].params, region});
+                    unit.area = unionRegion(unit.area, region);
+                    serial = serial || next->getParallelism() == Parallelism::Serial;
+                }
+                unit.fusedEnd = static_cast<int>(jobFused.size());
+                unit.mode = serial ? Parallelism::Serial : Parallelism::Rows;
+                unit.align = 1;
+            }
+            else {
+                unit.stage = i;
+                unit.area = lensRegion(stages[i].params, display.width, display.height);
+                unit.mode = effect->getParallelism();
+                unit.align = std::max(1, effect->getBandAlignment(stages[i].params));
+                ++i;
+            }
+            if (unit.area.isEmpty()) continue;
+
+            unit.slices = sliceCount(unit.area, unit.mode, unit.align);
+            slicesTotal += unit.slices;
+            jobUnits.push_back(unit);
+        }
+    }
+
+    /**
+     * @brief Renders the next slice of the job started by begin().
+     * @return True once the whole chain has run (also when there is no job).
+     */
+    bool step(TileScheduler& scheduler) {
+        lastSlice = {0, 0, 0, 0};
+        if (isComplete()) return true;
+
+        int threads = scheduler.getThreadCount();
+        if (static_cast<int>(registries.size()) != threads) registries.resize(threads);
+        if (static_cast<int>(fusedWorkers.size()) != threads) fusedWorkers.resize(threads);
+
+        const JobUnit& unit = jobUnits[jobUnit];
+        Parallelism direction = (unit.mode == Parallelism::Columns) ? Parallelism::Columns : Parallelism::Rows;
+        Region slice = bandOf(unit.area, direction, unit.align, jobSlice, unit.slices);
+
+        if (unit.fused) {
+            fused.assign(jobFused.begin() + unit.fusedBegin, jobFused.begin() + unit.fusedEnd);
+            runFusedArea(scheduler, jobDisplay, slice, unit.mode == Parallelism::Serial);
+            lastSlice = slice;
+        }
+        else {
+            const EffectStage& stage = jobStages[unit.stage];
+            IEffect* effect = registries[0].get(stage.type);
+            // The source is fixed when the stage starts, exactly as in run()
+            if (jobSlice == 0) jobSource = jobDirty.isEmpty() ? jobOriginal : effect->prepareSource(jobDisplay, unit.area, stage.params);
+            runBands(scheduler, stage.type, jobSource, jobDisplay, slice, stage.params);
+            lastSlice = clipRegion(effect->getDirtyBounds(slice, stage.params), jobDisplay.width, jobDisplay.height);
+        }
+        jobDirty = unionRegion(jobDirty, lastSlice);
+
+        slicesDone++;
+        if (++jobSlice == unit.slices) {
+            jobSlice = 0;
+            jobUnit++;
+        }
+        return isComplete();
+    }
+
+    /**
+     * @brief Drops the current job; the display keeps what it rendered so far.
+     */
+    void cancel() { jobUnit = jobUnits.size(); }
+
+    bool isComplete() const { return jobUnit >= jobUnits.size(); }
+
+    /**
+     * @brief Fraction of the job's slices rendered so far (1 when complete).
+     */
+    double getProgress() const {
+        if (isComplete() || slicesTotal == 0) return 1.0;
+        return static_cast<double>(slicesDone) / slicesTotal;
+    }
+
+    /**
+     * @brief Area written by the last step() (empty if it did nothing).
+     */
+    Region getLastSlice() const { return lastSlice; }
+
+    /**
+     * @brief Main-thread instance of an effect (worker 0).
+     */
+    IEffect* getEffect(EffectType type) {
+        if (registries.empty()) registries.resize(1);
+        return registries[0].get(type);
+    }
+
+    /**
+     * @brief True if every known stage is point-wise, so runPointwise() can render the chain.
+     */
+    bool isPointwise(const EffectStage* stages, int count) {
+        for (int i = 0; i < count; ++i) {
+            IEffect* effect = getEffect(stages[i].type);
+            if (effect && !effect->asPointwise()) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Runs the point-wise stages in place on a 16-bit or float image, as one
+     * fused group. Neighbourhood stages cannot run on these formats and are
+     * skipped; check isPointwise() first.
+     * @return Union of the areas written, clipped to the image.
+     */
+    template <typename P>
+    Region runPointwise(TileScheduler& scheduler, const EffectStage* stages, int count, const BasicImageView<P>& image) {
+        int threads = scheduler.getThreadCount();
+        if (static_cast<int>(registries.size()) != threads) registries.resize(threads);
+        if (static_cast<int>(fusedWorkers.size()) != threads) fusedWorkers.resize(threads);
+
+        fused.clear();
+        for (int i = 0; i < count; ++i) {
+            IEffect* effect = registries[0].get(stages[i].type);
+            if (!effect || !effect->asPointwise()) continue;
+
+            Region region = lensRegion(stages[i].params, image.width, image.height);
+            if (!region.isEmpty()) fused.push_back({stages[i].type, &stages[i].params, region});
+        }
+        return runFused(scheduler, image);
+    }
+
+private:
+    struct FusedStage {
+        EffectType type;
+        const EffectParams* params;
+        Region region;
+    };
+
+    // Per-worker state for fused point-wise groups
+    struct FusedWorker {
+        std::vector<LensMask> masks; // Lens shape of each fused stage
+        // Effect output for soft-edge pixels before blending, one row per pixel format
+        std::tuple<std::vector<Pixel>, std::vector<Pixel16>, std::vector<PixelF>> edgeRows;
+    };
+
+    // One fused group or one neighbourhood stage of an incremental job
+    struct JobUnit {
+        bool fused;
+        int stage;                // Index in jobStages (single stages)
+        int fusedBegin, fusedEnd; // Range in jobFused (fused groups)
+        Region area;
+        Parallelism mode;
+        int align;
+        int slices;
+    };
+
+    // Reused between frames (no steady-state allocation)
+    std::vector<EffectRegistry> registries; // One set of effect instances per worker
+    std::vector<FusedWorker> fusedWorkers;
+    std::vector<FusedStage> fused;
+
+    // Incremental job (begin / step)
+    std::vector<EffectStage> jobStages;
+    std::vector<FusedStage> jobFused;
+    std::vector<JobUnit> jobUnits;
+    SourceView jobOriginal = {};
+    SourceView jobSource = {};
+    ImageView jobDisplay = {};
+    Region jobDirty = {0, 0, 0, 0};
+    Region lastSlice = {0, 0, 0, 0};
+    size_t jobUnit = 0; // Unit being rendered (jobUnits.size() = complete)
+    int jobSlice = 0;   // Next slice of that unit
+    int slicesDone = 0;
+    int slicesTotal = 0;
+
+    /**
+     * @brief Number of step() slices for a unit, 1 for serial effects.
+     */
+    static int sliceCount(const Region& area, Parallelism mode, int align) {
+        if (mode == Parallelism::Serial) return 1;
+        long long pixels = static_cast<long long>(area.width) * area.height;
+        int length = (mode == Parallelism::Columns) ? area.width : area.height;
+        int units = (length + align - 1) / align;
+        long long bySize = (pixels + kSlicePixels - 1) / kSlicePixels;
+        return static_cast<int>(std::max<long long>(1, std::min<long long>(units, bySize)));
+    }
+
+    /**
+     * @brief Number of bands for a region, 1 if it is too small to be worth splitting.
+     */
+    static int bandCount(const Region& region, Parallelism mode, int align, int threads) {
+        if (mode == Parallelism::Serial || threads <= 1) return 1;
+        long long pixels = static_cast<long long>(region.width) * region.height;
+        int length = (mode == Parallelism::Rows) ? region.height : region.width;
+        int units = (length + align - 1) / align;
+        long long bySize = pixels / kMinBandPixels;
+        return static_cast<int>(std::max<long long>(1, std::min<long long>({units, bySize, 1LL * threads * kBandsPerThread})));
+    }
+
+    /**
+     * @brief Band 'task' of 'tasks': an aligned slice of rows or columns of the region.
+     */
+    static Region bandOf(const Region& region, Parallelism mode, int align, int task, int tasks) {
+        int length = (mode == Parallelism::Columns) ? region.width : region.height;
+        int units = (length + align - 1) / align;
+        int start = static_cast<int>(static_cast<long long>(units) * task / tasks) * align;
+        int end = std::min(length, static_cast<int>(static_cast<long long>(units) * (task + 1) / tasks) * align);
+
+        if (mode == Parallelism::Columns) return {region.x + start, region.y, end - start, region.height};
+        return {region.x, region.y + start, region.width, end - start};
+    }
+
+    void runBands(TileScheduler& scheduler, EffectType type, const SourceView& source,
+                  const ImageView& display, const Region& region, const EffectParams& params) {
+        IEffect* main = registries[0].get(type);
+        Parallelism mode = main->getParallelism();
+        int align = std::max(1, main->getBandAlignment(params));
+        int tasks = bandCount(region, mode, align, scheduler.getThreadCount());
+
+        if (tasks <= 1) {
+            main->apply(source, display, region, params);
+            return;
+        }
+
+        // Create instances up front, sharing worker 0's caches
+        for (EffectRegistry& workerEffects : registries) workerEffects.get(type)->shareCaches(*main);
+        scheduler.run(tasks, [&](int task, int worker) {
+            Region band = bandOf(region, mode, align, task, tasks);
+            registries[worker].get(type)->apply(source, display, band, params);
+        });
+    }
+
+    /**
+     * @brief Runs the current fused group in row bands, in place on the display.
+     * @return Union of the group's regions.
+     */
+    template <typename P>
+    Region runFused(TileScheduler& scheduler, const BasicImageView<P>& display) {
+        Region area = {0, 0, 0, 0};
+        bool serial = false;
+        for (const FusedStage& stage : fused) {
+            area = unionRegion(area, stage.region);
+            serial = serial || registries[0].get(stage.type)->getParallelism() == Parallelism::Serial;
+        }
+        if (!area.isEmpty()) runFusedArea(scheduler, display, area, serial);
+        return area;
+    }
+
+    /**
+     * @brief Runs the current fused group over some rows of its area, in row bands.
+     */
+    template <typename P>
+    void runFusedArea(TileScheduler& scheduler, const BasicImageView<P>& display, const Region& area, bool serial) {
+        int tasks = bandCount(area, serial ? Parallelism::Serial : Parallelism::Rows, 1, scheduler.getThreadCount());
+        if (tasks > 1) {
+            for (EffectRegistry& workerEffects : registries) {
+                for (const FusedStage& stage : fused) workerEffects.get(stage.type);
+            }
+        }
+
+        scheduler.run(tasks, [&](int task, int worker) {
+            runFusedRows(worker, display, bandOf(area, Parallelism::Rows, 1, task, tasks));
+        });
+    }
+
+    template <typename P>
+    void runFusedRows(int worker, const BasicImageView<P>& display, const Region& band) {
+        FusedWorker& state = fusedWorkers[worker];
+        if (state.masks.size() < fused.size()) state.masks.resize(fused.size());
+        for (size_t k = 0; k < fused.size(); ++k) state.masks[k].update(*fused[k].params, fused[k].region);
+
+        for (int y = band.y; y < band.y + band.height; ++y) {
+            for (size_t k = 0; k < fused.size(); ++k) {
+                const FusedStage& stage = fused[k];
+                const LensMask& mask = state.masks[k];
+                PointwiseEffect* effect = registries[worker].get(stage.type)->asPointwise();
+
+                int x0, x1;
+                if (!mask.span(y, x0, x1)) continue;
+
+                if (!mask.hasFeather()) {
+                    P* row = &display.at(x0, y);
+                    effect->processSpan(row, row, x1 - x0, x0, y, *stage.params);
+                    continue;
+                }
+
+                // Full-coverage middle in place, soft edges blended with the input
+                int i0, i1;
+                if (!mask.innerSpan(y, i0, i1)) i0 = i1 = x1;
+                if (i0 < i1) {
+                    P* row = &display.at(i0, y);
+                    effect->processSpan(row, row, i1 - i0, i0, y, *stage.params);
+                }
+                runEdge(state, effect, *stage.params, mask, display, y, x0, i0);
+                runEdge(state, effect, *stage.params, mask, display, y, std::max(i0, i1), x1);
+            }
+        }
+    }
+
+    template <typename P>
+    static void runEdge(FusedWorker& state, PointwiseEffect* effect, const EffectParams& params,
+                        const LensMask& mask, const BasicImageView<P>& display, int y, int x0, int x1) {
+        int count = x1 - x0;
+        if (count <= 0) return;
+        std::vector<P>& edgeRow = std::get<std::vector<P>>(state.edgeRows);
+        if (edgeRow.size() < static_cast<size_t>(count)) edgeRow.resize(count);
+
+        P* row = &display.at(x0, y);
+        effect->processSpan(row, edgeRow.data(), count, x0, y, params);
+        mask.blendRow(row, edgeRow.data(), row, x0, y, count);
+    }
+};
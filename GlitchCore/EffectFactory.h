@@ -1,4 +1,6 @@
 #pragma once
+#include <cstring>
+#include <cstdlib>
 #include <memory>
 #include "IEffect.h"
 
@@ -14,6 +16,10 @@
 #include "Effects/RippleEffect.h"
 #include "Effects/SolarizeEffect.h"
 #include "Effects/RGBNoiseEffect.h"
+#include "Effects/GaussianBlurEffect.h"
+#include "Effects/SharpenEffect.h"
+#include "Effects/EmbossEffect.h"
+#include "Effects/BoxBlurEffect.h"
 
 /**
  * @enum EffectType
@@ -32,9 +38,46 @@ enum class EffectType {
     SOBEL = 8,
     RIPPLE = 9,
     SOLARIZE = 10,
-    RGB_NOISE = 11
+    RGB_NOISE = 11,
+    PIXEL_SORT_INTERVAL = 12,
+    GAUSSIAN_BLUR = 13,
+    SHARPEN = 14,
+    EMBOSS = 15,
+    BOX_BLUR = 16
 };
 
+// Number of EffectType ids (including NONE). Keep in sync with the enum above.
+constexpr int kEffectTypeCount = 17;
+
+/**
+ * @brief Enum name of an effect type (as bound to JavaScript), for logs and benchmarks.
+ */
+inline const char* getEffectName(EffectType type) {
+    static const char* const names[kEffectTypeCount] = {
+        "NONE", "INVERT", "PIXEL_SORT", "CHROMATIC", "SWIRL", "MOSAIC", "JITTER", "SCANLINE",
+        "SOBEL", "RIPPLE", "SOLARIZE", "RGB_NOISE", "PIXEL_SORT_INTERVAL", "GAUSSIAN_BLUR", "SHARPEN", "EMBOSS",
+        "BOX_BLUR"
+    };
+    int index = static_cast<int>(type);
+    return (index >= 0 && index < kEffectTypeCount) ? names[index] : "UNKNOWN";
+}
+
+/**
+ * @brief Effect type from its enum name (e.g. "SWIRL") or numeric id, for command-line tools.
+ * @return false for unknown names and for NONE.
+ */
+inline bool parseEffectType(const char* name, EffectType& type) {
+    for (int id = 1; id < kEffectTypeCount; id++) {
+        char* end = nullptr;
+        bool isId = std::strtol(name, &end, 10) == id && end != name && *end == '\0';
+        if (isId || std::strcmp(name, getEffectName(static_cast<EffectType>(id))) == 0) {
+            type = static_cast<EffectType>(id);
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @class EffectFactory
  * @brief Implements the Factory Method pattern to create effect instances.
@@ -59,6 +102,11 @@ public:
             case EffectType::RIPPLE:    return std::make_unique<RippleEffect>();
             case EffectType::SOLARIZE:  return std::make_unique<SolarizeEffect>();
             case EffectType::RGB_NOISE: return std::make_unique<RGBNoiseEffect>();
+            case EffectType::PIXEL_SORT_INTERVAL: return std::make_unique<PixelSortEffect>(true);
+            case EffectType::GAUSSIAN_BLUR: return std::make_unique<GaussianBlurEffect>();
+            case EffectType::SHARPEN:   return std::make_unique<SharpenEffect>();
+            case EffectType::EMBOSS:    return std::make_unique<EmbossEffect>();
+            case EffectType::BOX_BLUR:  return std::make_unique<BoxBlurEffect>();
             case EffectType::NONE:
             default:
                 return nullptr;
@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <memory>
+#include "EffectFactory.h"
+
+/**
+ * @class EffectRegistry
+ * @brief Owns one persistent instance of every effect for a single engine.
+ * Effects are created through the EffectFactory on first use and then kept
+ * alive across frames, so their scratch storage is reused instead of being
+ * reallocated on every render.
+ */
+class EffectRegistry {
+public:
+    /**
+     * @brief Returns the shared instance for a type, creating it on first use.
+     * @param type The EffectType enum identifier.
+     * @return IEffect* Pointer owned by the registry, or nullptr for NONE/invalid ids.
+     */
+    IEffect* get(EffectType type) {
+        int index = static_cast<int>(type);
+        if (index <= 0 || index >= kEffectTypeCount) return nullptr;
+
+        std::unique_ptr<IEffect>& slot = effects[index];
+        if (!slot) slot = EffectFactory::createEffect(type);
+        return slot.get();
+    }
+
+private:
+    std::array<std::unique_ptr<IEffect>, kEffectTypeCount> effects;
+};
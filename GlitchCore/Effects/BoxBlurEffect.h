@@ -0,0 +1,53 @@
+#pragma once
+#include "../IEffect.h"
+#include "../SummedAreaTable.h"
+#include <algorithm>
+
+/**
+ * @class BoxBlurEffect
+ * @brief Flat-kernel blur: every pixel becomes the mean of the (2r+1)^2 square around it.
+ * Each output pixel costs four summed-area lookups, so large radii are as cheap
+ * as small ones. Near the image border the square is cut to the image.
+ */
+class BoxBlurEffect : public IEffect {
+public:
+    static constexpr int kMaxRadius = 32;
+
+    // Reads up to one box radius away in each direction.
+    int getHaloSize(const EffectParams& params) const override { return getRadius(params); }
+
+    // The box radius is a distance in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+    bool usesIntegral() const override { return true; }
+
+    /**
+     * @brief Box radius: 1 pixel per 3 intensity, between 1 and kMaxRadius.
+     */
+    static int getRadius(const EffectParams& params) {
+        int radius = static_cast<int>(params.intensity / 3.0f + 0.5f);
+        return std::max(1, std::min(kMaxRadius, radius));
+    }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        int radius = getRadius(params);
+        Region reads = clipRegion({region.x - radius, region.y - radius, region.width + 2 * radius, region.height + 2 * radius},
+                                  dest.width, dest.height);
+        const SummedAreaTable& sums = SummedAreaTable::of(source, reads, localSums);
+
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
+            int top = std::max(0, y - radius);
+            int bottom = std::min(dest.height, y + radius + 1);
+            for (int x = x0; x < x1; ++x) {
+                dest.at(x, y) = sums.average(std::max(0, x - radius), top, std::min(dest.width, x + radius + 1), bottom);
+            }
+        }
+    }
+
+private:
+    SummedAreaTable localSums; // Used when the source has no table attached
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "../IEffect.h"
+#include "../RowCopy.h"
 #include <algorithm>
+#include <cstdlib>
 
 /**
  * @class ChromaticEffect
@@ -8,43 +10,30 @@
  */
 class ChromaticEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
+    // Red and blue are sampled up to 'offset' pixels away horizontally.
+    int getHaloSize(const EffectParams& params) const override {
+        return std::abs(static_cast<int>(params.intensity));
+    }
+
+    // The channel offset is a distance in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
         
         // Intensity defines the offset distance in pixels
         int offset = static_cast<int>(params.intensity);
         if (offset == 0) return;
 
-        // Create a copy of the region to read original values from.
-        // We need this because we are modifying the buffer in-place, 
-        // and we don't want to read pixels we just modified.
-        // NOTE: For max performance in a real engine, we would swap full buffers,
-        // but for this localized effect, a temp buffer is fine.
-        std::vector<Pixel> tempBuffer = data; 
-
+        // Channels are read from the read-only source, so we never read
+        // pixels we just modified in the destination.
         for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                if (!isInsideBubble(x, y, params)) continue;
-
-                int index = (y * imgWidth) + x;
-                
-                // Calculate neighbor indices with boundary checks (Clamp)
-                int rX = std::max(0, std::min(imgWidth - 1, x - offset)); // Shift Red Left
-                int bX = std::max(0, std::min(imgWidth - 1, x + offset)); // Shift Blue Right
-                
-                int rIndex = (y * imgWidth) + rX;
-                int bIndex = (y * imgWidth) + bX;
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
 
-                // Write to the main data buffer
-                Pixel& p = data[index];
-                
-                // Construct the new pixel:
-                // Red comes from the left, Blue from the right, Green stays center
-                p.r = tempBuffer[rIndex].r;
-                p.g = tempBuffer[index].g; // Green untouched
-                p.b = tempBuffer[bIndex].b;
-            }
+            // Red comes from the left, Blue from the right, Green stays center
+            RowCopy::splitChannels(source, y, x0, x1, offset, &dest.at(x0, y));
         }
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include "../IEffect.h"
+#include "../Convolution.h"
+#include <algorithm>
+
+/**
+ * @class EmbossEffect
+ * @brief Relief effect: diagonal 3x3 emboss kernel that keeps the image colors.
+ * The kernel sums to one, so flat areas are unchanged and intensity only
+ * scales the relief around edges.
+ */
+class EmbossEffect : public IEffect {
+public:
+    // 3x3 kernel: one pixel of neighbours on every side.
+    int getHaloSize(const EffectParams& params) const override { return 1; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        // Strength in 1/256 steps: intensity 50 = 1.0 (the classic kernel)
+        int s = std::max(0, std::min(512, static_cast<int>(params.intensity * 5.12f + 0.5f)));
+        const int kernel[9] = {
+            -2 * s, -s,  0,
+            -s,     256, s,
+            0,      s,   2 * s
+        };
+        convolution.kernel3x3(source, dest, region, mask(), kernel, 8);
+    }
+
+private:
+    Convolution convolution; // Padded rows, reused between frames
+};
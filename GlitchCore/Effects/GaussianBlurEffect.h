@@ -0,0 +1,37 @@
+#pragma once
+#include "../IEffect.h"
+#include "../Convolution.h"
+#include <algorithm>
+
+/**
+ * @class GaussianBlurEffect
+ * @brief Soft-focus lens: separable Gaussian blur whose radius grows with intensity.
+ */
+class GaussianBlurEffect : public IEffect {
+public:
+    // Reads up to one kernel radius away in each direction.
+    int getHaloSize(const EffectParams& params) const override { return getRadius(params); }
+
+    // The kernel radius is a distance in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+    /**
+     * @brief Kernel radius: 1 pixel per 10 intensity, between 1 and SeparableKernel::kMaxRadius.
+     */
+    static int getRadius(const EffectParams& params) {
+        int radius = static_cast<int>(params.intensity / 10.0f + 0.5f);
+        return std::max(1, std::min(SeparableKernel::kMaxRadius, radius));
+    }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        int radius = getRadius(params);
+        if (radius != kernel.radius) kernel = SeparableKernel::gaussian(radius);
+        convolution.separable(source, dest, region, mask(), kernel);
+    }
+
+private:
+    SeparableKernel kernel;  // Rebuilt only when the radius changes
+    Convolution convolution; // Padded rows and horizontal pass, reused between frames
+};
@@ -1,33 +1,79 @@
 #pragma once
-#include "../IEffect.h"
+#include "../PointwiseEffect.h"
+#include "../Simd.h"
+#include "../PixelFormat.h"
+#include <algorithm>
 
 /**
  * @class InvertEffect
  * @brief Simple negative effect. Inverts RGB channels.
  */
-class InvertEffect : public IEffect {
+class InvertEffect : public PointwiseEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
-        // Loop ONLY through the region of interest
-        for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                // Check Bubble Mask
-                if (!isInsideBubble(x, y, params)) continue;
-
-                int index = (y * imgWidth) + x;
-                Pixel& p = data[index];
-
-                // Logic: Invert colors based on intensity
-                // If intensity is 100 (1.0), fully invert. If 0, do nothing.
-                float factor = params.intensity / 100.0f;
-                
-                p.r = static_cast<uint8_t>(p.r * (1 - factor) + (255 - p.r) * factor);
-                p.g = static_cast<uint8_t>(p.g * (1 - factor) + (255 - p.g) * factor);
-                p.b = static_cast<uint8_t>(p.b * (1 - factor) + (255 - p.b) * factor);
-            }
+    void processSpan(const Pixel* src, Pixel* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        int weight = getWeight(params);
+        int i = 0;
+
+#if GLITCH_SIMD
+        // 4 pixels per iteration, in 16-bit lanes: same formula as the scalar path
+        Simd::Vec keepW = Simd::splat16(static_cast<uint16_t>(256 - weight));
+        Simd::Vec invW = Simd::splat16(static_cast<uint16_t>(weight));
+        Simd::Vec max = Simd::splat16(255);
+        Simd::Vec half = Simd::splat16(128);
+        Simd::Vec alpha = Simd::alphaMask();
+
+        for (; i + Simd::kPixels <= count; i += Simd::kPixels) {
+            Simd::Vec v = Simd::load(src + i);
+            Simd::Vec lo = Simd::widenLo(v);
+            Simd::Vec hi = Simd::widenHi(v);
+
+            lo = Simd::add16(Simd::add16(Simd::mul16(lo, keepW), Simd::mul16(Simd::sub16(max, lo), invW)), half);
+            hi = Simd::add16(Simd::add16(Simd::mul16(hi, keepW), Simd::mul16(Simd::sub16(max, hi), invW)), half);
+
+            Simd::Vec out = Simd::narrowSat(Simd::shr16<8>(lo), Simd::shr16<8>(hi));
+            Simd::store(dst + i, Simd::select(alpha, v, out)); // Alpha untouched
         }
+#endif
+
+        processSpanScalar(src + i, dst + i, count - i, weight);
+    }
+
+    void processSpan(const Pixel16* src, Pixel16* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanScalar<Rgba16>(src, dst, count, getWeight(params));
+    }
+
+    void processSpan(const PixelF* src, PixelF* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanScalar<RgbaF32>(src, dst, count, getWeight(params));
+    }
+
+    /**
+     * @brief Reference implementation of the kernel (also handles SIMD tails).
+     * Specialized at compile time for any pixel format (PixelFormat.h).
+     * @param weight Inversion weight in 1/256 steps (see getWeight).
+     */
+    template <typename Format = Rgba8>
+    static void processSpanScalar(const typename Format::Pixel* src, typename Format::Pixel* dst, int count, int weight) {
+        for (int i = 0; i < count; ++i) {
+            typename Format::Pixel p = src[i];
+            typename Format::Pixel& out = dst[i];
+
+            // Blend between the pixel and its negative: p * (1 - f) + (max - p) * f
+            out.r = Format::mix(p.r, Format::invert(p.r), weight);
+            out.g = Format::mix(p.g, Format::invert(p.g), weight);
+            out.b = Format::mix(p.b, Format::invert(p.b), weight);
+            out.a = p.a;
+        }
+    }
+
+    /**
+     * @brief Inversion factor in fixed point, computed once per span.
+     * If intensity is 100 (256), fully invert. If 0, do nothing.
+     */
+    static int getWeight(const EffectParams& params) {
+        int weight = static_cast<int>(params.intensity / 100.0f * 256.0f + 0.5f);
+        return std::max(0, std::min(256, weight));
     }
-};
\ No newline at end of file
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "../IEffect.h"
-#include <cstdlib>
+#include "../Random.h"
+#include "../RowCopy.h"
 #include <vector>
 #include <algorithm>
 
@@ -11,46 +12,50 @@
  */
 class JitterEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
-        // Copy original buffer to read source blocks safely
-        std::vector<Pixel> source = data;
+    static constexpr int kBlockSize = 10; // Fixed block size for the glitch look
+
+    // Blocks start inside the region but are copied whole, so they can overhang it.
+    Region getDirtyBounds(const Region& region, const EffectParams& params) const override {
+        return {region.x, region.y, region.width + kBlockSize - 1, region.height + kBlockSize - 1};
+    }
+
+    // Blocks are fetched from up to 'shiftPower' pixels away.
+    int getHaloSize(const EffectParams& params) const override {
+        return std::abs(static_cast<int>(params.intensity));
+    }
+
+    // The block displacement is a distance in pixels (the block size stays fixed).
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+    // Bands must not split a block (each block's offset is keyed on its position).
+    int getBandAlignment(const EffectParams& params) const override { return kBlockSize; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
         
-        int blockSize = 10; // Fixed block size for the glitch look
+        int imgWidth = dest.width;
+        int imgHeight = dest.height;
+        int blockSize = kBlockSize;
         int shiftPower = static_cast<int>(params.intensity); // Max displacement in pixels
 
         for (int y = region.y; y < region.y + region.height; y += blockSize) {
             for (int x = region.x; x < region.x + region.width; x += blockSize) {
                 
-                if (!isInsideBubble(x, y, params)) continue;
+                if (!mask().contains(x, y)) continue;
 
                 // Calculate a random offset vector for this specific block
-                int offsetX = (std::rand() % std::max(1, shiftPower)) - (shiftPower / 2);
-                int offsetY = (std::rand() % std::max(1, shiftPower)) - (shiftPower / 2);
-
-                // Copy the displaced block from source to destination
-                for (int by = 0; by < blockSize; ++by) {
-                    for (int bx = 0; bx < blockSize; ++bx) {
-                        int destX = x + bx;
-                        int destY = y + by;
-                        
-                        // Calculate source coordinates (Inverse mapping)
-                        int srcX = destX + offsetX;
-                        int srcY = destY + offsetY;
-
-                        // Boundary checks for destination
-                        if (destX >= imgWidth || destY >= imgHeight) continue;
-                        
-                        // Clamp source coordinates to keep them valid (Wrap or Clamp)
-                        // Using Clamp here to repeat edges (smear effect)
-                        srcX = std::max(0, std::min(imgWidth - 1, srcX));
-                        srcY = std::max(0, std::min(imgHeight - 1, srcY));
-
-                        data[destY * imgWidth + destX] = source[srcY * imgWidth + srcX];
-                    }
+                uint64_t bits = Random::bits(params.seed, params.frame, x, y);
+                int offsetX = Random::below(bits, std::max(1, shiftPower)) - (shiftPower / 2);
+                int offsetY = Random::below(bits >> 32, std::max(1, shiftPower)) - (shiftPower / 2);
+
+                // Copy the displaced block row by row (reads clamped: edges smear)
+                int runLength = std::min(blockSize, imgWidth - x);
+                for (int destY = y; destY < std::min(y + blockSize, imgHeight); ++destY) {
+                    int srcY = std::max(0, std::min(imgHeight - 1, destY + offsetY));
+                    RowCopy::shifted(source, x + offsetX, srcY, &dest.at(x, destY), runLength);
                 }
             }
         }
     }
-};
\ No newline at end of file
+};
@@ -1,47 +1,77 @@
 #pragma once
 #include "../IEffect.h"
+#include "../SummedAreaTable.h"
 #include <algorithm>
 
 /**
  * @class MosaicEffect
  * @brief Reduces the resolution of the image area to create a pixelated look.
  * Useful for retro aesthetics or censorship effects.
+ *
+ * Each block is filled with the mean color of its pixels, read from a
+ * summed-area table in four lookups whatever the block size. Averaging instead
+ * of point-sampling keeps blocks from flickering as the lens moves.
  */
 class MosaicEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
+    // The last row/column of blocks is filled completely, past the region edge.
+    Region getDirtyBounds(const Region& region, const EffectParams& params) const override {
+        int blockSize = getBlockSize(params);
+        return {region.x, region.y, region.width + blockSize - 1, region.height + blockSize - 1};
+    }
+
+    // The block sums are taken before anything is written, and blocks never overlap.
+    bool supportsInPlace() const override { return true; }
+
+    // Bands must hold whole block rows so the block grid stays intact.
+    int getBandAlignment(const EffectParams& params) const override { return getBlockSize(params); }
+
+    // The block size is a length in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+    bool usesIntegral() const override { return true; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
         
-        // Define block size based on intensity. Minimum 1px, max 50px approx.
-        int blockSize = std::max(1, static_cast<int>(params.intensity / 2));
+        int imgWidth = dest.width;
+        int imgHeight = dest.height;
+        int blockSize = getBlockSize(params);
+
+        // Exactly the pixels of this region's blocks: neighbouring bands are off limits
+        int blocksX = (region.width + blockSize - 1) / blockSize;
+        int blocksY = (region.height + blockSize - 1) / blockSize;
+        Region blocks = clipRegion({region.x, region.y, blocksX * blockSize, blocksY * blockSize}, imgWidth, imgHeight);
+        const SummedAreaTable& sums = SummedAreaTable::of(source, blocks, localSums);
 
         // Iterate through the grid in steps of 'blockSize'
         for (int y = region.y; y < region.y + region.height; y += blockSize) {
             for (int x = region.x; x < region.x + region.width; x += blockSize) {
                 
                 // Check if the top-left corner of the block is inside the bubble
-                if (!isInsideBubble(x, y, params)) continue;
-
-                // 1. Sample the color from the first pixel of the block
-                int index = (y * imgWidth) + x;
-                Pixel sample = data[index];
-
-                // 2. Fill the entire block with that sample color
-                for (int by = 0; by < blockSize; ++by) {
-                    for (int bx = 0; bx < blockSize; ++bx) {
-                        int pX = x + bx;
-                        int pY = y + by;
-
-                        // Vital boundary check to prevent segmentation faults
-                        if (pX >= imgWidth || pY >= imgHeight) continue;
-                        
-                        // Note: We skip the circular check per-pixel here for performance 
-                        // and to keep the "blocky" aesthetic at the edges.
-
-                        data[pY * imgWidth + pX] = sample;
-                    }
+                if (!mask().contains(x, y)) continue;
+
+                // 1. Mean color of the block (clipped to the image)
+                int x1 = std::min(x + blockSize, imgWidth);
+                int y1 = std::min(y + blockSize, imgHeight);
+                Pixel sample = sums.average(x, y, x1, y1);
+
+                // 2. Fill the entire block with that color.
+                // Note: We skip the circular check per-pixel here for performance 
+                // and to keep the "blocky" aesthetic at the edges.
+                for (int pY = y; pY < y1; ++pY) {
+                    std::fill(&dest.at(x, pY), &dest.at(x, pY) + (x1 - x), sample);
                 }
             }
         }
     }
-};
\ No newline at end of file
+
+private:
+    SummedAreaTable localSums; // Used when the source has no table attached
+
+    // Define block size based on intensity. Minimum 1px, max 50px approx.
+    static int getBlockSize(const EffectParams& params) {
+        return std::max(1, static_cast<int>(params.intensity / 2));
+    }
+};
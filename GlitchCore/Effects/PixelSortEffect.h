@@ -1,79 +1,145 @@
 #pragma once
 #include "../IEffect.h"
-#include <algorithm> // for std::sort
-#include <cmath>
+#include <cstdint>
 
 /**
  * @class PixelSortEffect
  * @brief Sorts pixels by luminance within vertical columns.
  * Supports circular masking to create a "melting bubble" effect.
+ *
+ * Pixels are keyed by their 8-bit luma (SourceView::lumaAt) and ordered with a
+ * stable counting sort, so each column costs O(n) instead of O(n log n)
+ * float comparisons. Equal keys keep their original top-to-bottom order.
+ *
+ * In interval mode only runs of pixels whose luma lies inside a threshold
+ * window are sorted; darker/brighter pixels stay put and split the column
+ * into independent runs (the classic "threshold" pixel sort).
  */
 class PixelSortEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
+    /**
+     * @param intervals Sort only runs between luminance thresholds (see getThresholds).
+     */
+    explicit PixelSortEffect(bool intervals = false) : intervalMode(intervals) {}
+
+    // Each column segment is copied out before anything is written back.
+    bool supportsInPlace() const override { return true; }
+
+    // Columns are sorted independently of each other.
+    Parallelism getParallelism() const override { return Parallelism::Columns; }
+
+    // Sort keys come from the engine's cached luma plane when available.
+    bool usesLuma() const override { return true; }
+
+    /**
+     * @brief Luma window [lower, upper] for interval mode.
+     * The window is centered on mid grey and widens with intensity
+     * (intensity 100 sorts every pixel, low intensities only mid-tones).
+     */
+    static void getThresholds(const EffectParams& params, int& lower, int& upper) {
+        int span = static_cast<int>(std::max(0.0f, std::min(100.0f, params.intensity)) * 2.56f);
+        lower = (256 - span) / 2;
+        upper = std::min(255, lower + span);
+    }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        int lower = 0, upper = 255;
+        if (intervalMode) getThresholds(params, lower, upper);
+        if (params.intensity <= 0) lower = 256; // Empty window: columns are copied unsorted
+
         // We iterate column by column (X axis) within the region
         for (int x = region.x; x < region.x + region.width; ++x) {
-            
-            int startY = region.y;
-            int endY = region.y + region.height;
-
-            // --- BUBBLE MATH OPTIMIZATION ---
-            // If we are using a circle mask, we calculate the precise vertical span 
-            // of the circle at this specific X coordinate.
-            if (params.useCircleMask) {
-                int dx = x - params.centerX;
-                int distSq = dx * dx;
-                int radiusSq = params.radius * params.radius;
-
-                // If this column is outside the circle's width, skip it completely.
-                if (distSq > radiusSq) continue;
-
-                // Pythagorean theorem to find the height of the chord at x
-                // y = sqrt(r^2 - x^2)
-                int ySpan = static_cast<int>(std::sqrt(radiusSq - distSq));
-                
-                // Clamping to image boundaries
-                startY = std::max(0, params.centerY - ySpan);
-                endY = std::min(imgHeight, params.centerY + ySpan);
-            }
 
-            // Safety check
-            if (startY >= endY) continue;
+            // --- BUBBLE SPAN ---
+            // The lens mask gives the precise vertical chord of the circle at
+            // this X coordinate (already clamped to the region).
+            int startY, endY;
+            if (!mask().columnSpan(x, startY, endY)) continue;
 
             // --- SORTING PROCESS ---
-            processColumn(data, imgWidth, x, startY, endY, params.intensity);
+            processColumn(source, dest, x, startY, endY, lower, upper);
         }
     }
 
 private:
+    static constexpr int kInsertionSortMax = 32; // Below this, clearing 256 counters costs more than sorting
+
+    bool intervalMode;
+
+    // Reused across columns and frames
+    std::vector<Pixel> columnStrip;
+    std::vector<uint8_t> columnKeys;
+    std::vector<Pixel> sortedStrip;
+
     /**
-     * @brief Extracts, sorts, and writes back a column segment.
+     * @brief Extracts a column segment, sorts its runs and writes them back.
      */
-    void processColumn(std::vector<Pixel>& data, int width, int x, int startY, int endY, float intensity) {
+    void processColumn(const SourceView& source, const ImageView& dest, int x, int startY, int endY,
+                       int lower, int upper) {
         int length = endY - startY;
-        if (length <= 1) return;
-
-        // 1. Extract pixels into a temporary vector
-        std::vector<Pixel> columnStrip;
-        columnStrip.reserve(length);
-        
-        for (int y = startY; y < endY; ++y) {
-            columnStrip.push_back(data[y * width + x]);
+        if (length <= 0) return;
+
+        // 1. Extract pixels and their keys into the reusable strips
+        if (columnStrip.size() < static_cast<size_t>(length)) {
+            columnStrip.resize(length);
+            columnKeys.resize(length);
+            sortedStrip.resize(length);
+        }
+        for (int i = 0; i < length; ++i) {
+            columnStrip[i] = source.at(x, startY + i);
+            columnKeys[i] = source.lumaAt(x, startY + i);
         }
 
-        // 2. Sort the strip based on Luminance
-        // Intensity > 50 sorts ascending, < 50 sorts descending (optional feature)
-        if (intensity > 0) {
-            std::sort(columnStrip.begin(), columnStrip.end(), [](const Pixel& a, const Pixel& b) {
-                return a.getLuminance() < b.getLuminance(); // Darkest at top
-            });
+        // 2. Sort every run of pixels inside the luma window (the whole strip in normal mode)
+        int i = 0;
+        while (i < length) {
+            if (columnKeys[i] < lower || columnKeys[i] > upper) { ++i; continue; }
+            int runEnd = i + 1;
+            while (runEnd < length && columnKeys[runEnd] >= lower && columnKeys[runEnd] <= upper) ++runEnd;
+            sortRun(i, runEnd);
+            i = runEnd;
         }
 
-        // 3. Write back to the main buffer
-        for (int i = 0; i < length; ++i) {
-            data[(startY + i) * width + x] = columnStrip[i];
+        // 3. Write back to the destination buffer
+        for (int k = 0; k < length; ++k) {
+            dest.at(x, startY + k) = columnStrip[k];
+        }
+    }
+
+    /**
+     * @brief Stable sort of columnStrip[begin, end) by key, darkest at top.
+     */
+    void sortRun(int begin, int end) {
+        int count = end - begin;
+        if (count <= 1) return;
+
+        if (count <= kInsertionSortMax) {
+            for (int i = begin + 1; i < end; ++i) {
+                Pixel p = columnStrip[i];
+                uint8_t key = columnKeys[i];
+                int j = i;
+                for (; j > begin && columnKeys[j - 1] > key; --j) {
+                    columnStrip[j] = columnStrip[j - 1];
+                    columnKeys[j] = columnKeys[j - 1];
+                }
+                columnStrip[j] = p;
+                columnKeys[j] = key;
+            }
+            return;
+        }
+
+        // Counting sort: histogram, prefix sums, stable scatter
+        int offsets[256] = {};
+        for (int i = begin; i < end; ++i) ++offsets[columnKeys[i]];
+        int total = 0;
+        for (int& offset : offsets) {
+            int n = offset;
+            offset = total;
+            total += n;
         }
+        for (int i = begin; i < end; ++i) sortedStrip[offsets[columnKeys[i]]++] = columnStrip[i];
+        std::copy(sortedStrip.begin(), sortedStrip.begin() + count, columnStrip.begin() + begin);
     }
-};
\ No newline at end of file
+};
@@ -1,35 +1,112 @@
 #pragma once
-#include "../IEffect.h"
-#include <cstdlib>
+#include "../PointwiseEffect.h"
+#include "../Simd.h"
+#include "../Random.h"
+#include "../PixelFormat.h"
+#include <algorithm>
+#include <vector>
 
 /**
  * @class RGBNoiseEffect
  * @brief Adds random static noise independently to R, G, and B channels.
+ * The noise of a pixel is a hash of (seed, frame, x, y), so it is the same
+ * whatever the span split or thread count.
  */
-class RGBNoiseEffect : public IEffect {
+class RGBNoiseEffect : public PointwiseEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
+    void processSpan(const Pixel* src, Pixel* dst, int count, int x, int y,
+                     const EffectParams& params) override {
         
-        int noiseLevel = static_cast<int>(params.intensity);
+        int noiseLevel = getNoiseLevel(params);
+        if (noiseLevel <= 0) {
+            // No noise requested
+            if (src != dst) std::copy(src, src + count, dst);
+            return;
+        }
+
+        // Draw the noise for the whole span first, then add it to the pixels
+        // with saturating vector arithmetic.
+        if (noise.size() < static_cast<size_t>(count) * 4) noise.resize(static_cast<size_t>(count) * 4);
+        fillNoise(noise.data(), count, x, y, params, noiseLevel);
+
+        int i = 0;
+#if GLITCH_SIMD
+        for (; i + Simd::kPixels <= count; i += Simd::kPixels) {
+            Simd::Vec v = Simd::load(src + i);
+            Simd::Vec lo = Simd::add16(Simd::widenLo(v), Simd::load(&noise[i * 4]));
+            Simd::Vec hi = Simd::add16(Simd::widenHi(v), Simd::load(&noise[i * 4 + 8]));
+            Simd::store(dst + i, Simd::narrowSat(lo, hi)); // Alpha noise is zero
+        }
+#endif
+        addNoiseScalar(src + i, dst + i, count - i, noise.data() + i * 4);
+    }
+
+    // The noise stays in 8-bit levels, scaled to the channel range
+    void processSpan(const Pixel16* src, Pixel16* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanWide<Rgba16>(src, dst, count, x, y, params);
+    }
+
+    void processSpan(const PixelF* src, PixelF* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanWide<RgbaF32>(src, dst, count, x, y, params);
+    }
 
-        for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                if (!isInsideBubble(x, y, params)) continue;
+    /**
+     * @brief Reference implementation of the kernel, for any pixel format.
+     */
+    template <typename Format = Rgba8>
+    static void processSpanScalar(const typename Format::Pixel* src, typename Format::Pixel* dst, int count, int x, int y,
+                                  const EffectParams& params) {
+        int noiseLevel = getNoiseLevel(params);
+        for (int i = 0; i < count; ++i) {
+            int16_t n[4] = {0, 0, 0, 0};
+            if (noiseLevel > 0) fillNoise(n, 1, x + i, y, params, noiseLevel);
+            addNoiseScalar<Format>(src + i, dst + i, 1, n);
+        }
+    }
 
-                int idx = (y * imgWidth) + x;
-                Pixel& p = data[idx];
+    // Noise amplitude, limited so channel sums always fit in 16 bits
+    static int getNoiseLevel(const EffectParams& params) {
+        return std::min(255, static_cast<int>(params.intensity));
+    }
 
-                // Add random value between -noiseLevel and +noiseLevel per channel
-                int nr = (std::rand() % (noiseLevel * 2)) - noiseLevel;
-                int ng = (std::rand() % (noiseLevel * 2)) - noiseLevel;
-                int nb = (std::rand() % (noiseLevel * 2)) - noiseLevel;
+private:
+    std::vector<int16_t> noise; // Per-span RGBA noise, reused across frames
+
+    template <typename Format>
+    void processSpanWide(const typename Format::Pixel* src, typename Format::Pixel* dst, int count, int x, int y,
+                         const EffectParams& params) {
+        int noiseLevel = getNoiseLevel(params);
+        if (noiseLevel <= 0) {
+            if (src != dst) std::copy(src, src + count, dst);
+            return;
+        }
+        if (noise.size() < static_cast<size_t>(count) * 4) noise.resize(static_cast<size_t>(count) * 4);
+        fillNoise(noise.data(), count, x, y, params, noiseLevel);
+        addNoiseScalar<Format>(src, dst, count, noise.data());
+    }
+
+    // Add random value between -noiseLevel and +noiseLevel per channel.
+    // One 64-bit draw per pixel: 21 random bits for each of R, G and B.
+    static void fillNoise(int16_t* out, int count, int x, int y, const EffectParams& params, int noiseLevel) {
+        for (int i = 0; i < count; ++i) {
+            uint64_t bits = Random::bits(params.seed, params.frame, x + i, y);
+            out[i * 4 + 0] = static_cast<int16_t>(Random::below(bits, noiseLevel * 2, 21) - noiseLevel);
+            out[i * 4 + 1] = static_cast<int16_t>(Random::below(bits >> 21, noiseLevel * 2, 21) - noiseLevel);
+            out[i * 4 + 2] = static_cast<int16_t>(Random::below(bits >> 42, noiseLevel * 2, 21) - noiseLevel);
+            out[i * 4 + 3] = 0;
+        }
+    }
 
-                p.r = static_cast<uint8_t>(std::max(0, std::min(255, p.r + nr)));
-                p.g = static_cast<uint8_t>(std::max(0, std::min(255, p.g + ng)));
-                p.b = static_cast<uint8_t>(std::max(0, std::min(255, p.b + nb)));
-            }
+    template <typename Format = Rgba8>
+    static void addNoiseScalar(const typename Format::Pixel* src, typename Format::Pixel* dst, int count, const int16_t* n) {
+        for (int i = 0; i < count; ++i) {
+            typename Format::Pixel p = src[i];
+            p.r = Format::offset(p.r, n[i * 4 + 0]);
+            p.g = Format::offset(p.g, n[i * 4 + 1]);
+            p.b = Format::offset(p.b, n[i * 4 + 2]);
+            dst[i] = p;
         }
     }
-};
\ No newline at end of file
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include "../IEffect.h"
+#include "../DisplacementMap.h"
+#include "../FastMath.h"
 #include <cmath>
+#include <memory>
 
 /**
  * @class RippleEffect
@@ -8,43 +11,70 @@
  */
 class RippleEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
-        std::vector<Pixel> source = data;
-        
+    // Pixels are displaced by at most the ripple amplitude (plus truncation,
+    // plus the neighbour read by bilinear sampling).
+    int getHaloSize(const EffectParams& params) const override {
+        int bilinear = params.quality == RenderQuality::Final ? 1 : 0;
+        return static_cast<int>(std::ceil(std::fabs(params.intensity / 5.0f))) + 1 + bilinear;
+    }
+
+    // The amplitude is a distance in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+    /**
+     * @brief Source offset of the pixel at (dx, dy) from the center.
+     * Math: Offset based on Sine of distance, along the direction from the center.
+     */
+    static Displacement getDisplacement(int dx, int dy, const EffectParams& params) {
         // Wavelength controls how tight the rings are
         float wavelength = 20.0f; 
         // Amplitude controls how much pixels move
         float amplitude = params.intensity / 5.0f;
 
+        float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+        float phase = dist / wavelength;
+        float amount = (params.quality == RenderQuality::Final ? std::sin(phase) : fastSin(phase)) * amplitude;
+
+        // Normalize direction (dx/dist, dy/dist) and scale by amount
+        return Displacement::fromFloat((dx / (dist + 0.1f)) * amount, (dy / (dist + 0.1f)) * amount);
+    }
+
+    void shareCaches(IEffect& primary) override {
+        displacement = static_cast<RippleEffect&>(primary).displacement;
+    }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        
+        int imgWidth = dest.width;
+        int imgHeight = dest.height;
+
+        // Cached across frames while radius and intensity stay the same
+        bool cached = displacement->update(params);
+        auto field = [&params](int dx, int dy) { return getDisplacement(dx, dy, params); };
+
         for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
+
+            int dy = y - params.centerY;
+            const Displacement* row = cached ? displacement->row(dy, field) : nullptr;
+
+            for (int x = x0; x < x1; ++x) {
                 int dx = x - params.centerX;
-                int dy = y - params.centerY;
-                float dist = std::sqrt(dx*dx + dy*dy);
-                
-                if (dist > params.radius) continue;
-
-                // Math: Offset based on Sine of distance
-                float amount = std::sin(dist / wavelength) * amplitude;
-                
-                // Displacement vector (towards/away from center)
-                // Normalize direction (dx/dist, dy/dist) and scale by amount
-                float srcX = x + (dx / (dist + 0.1f)) * amount;
-                float srcY = y + (dy / (dist + 0.1f)) * amount;
-
-                // Sampling
-                int sx = static_cast<int>(srcX);
-                int sy = static_cast<int>(srcY);
-
-                // Boundary clamp
-                sx = std::max(0, std::min(imgWidth - 1, sx));
-                sy = std::max(0, std::min(imgHeight - 1, sy));
-
-                data[y * imgWidth + x] = source[sy * imgWidth + sx];
+                Displacement d = row ? row[dx] : field(dx, dy);
+
+                // Sampling with boundary clamp
+                int sx = std::max(0, std::min(imgWidth - 1, x + d.wholeX()));
+                int sy = std::max(0, std::min(imgHeight - 1, y + d.wholeY()));
+
+                dest.at(x, y) = sampleDisplaced(source, sx, sy, d, params.quality);
             }
         }
     }
-};
\ No newline at end of file
+
+private:
+    // Cached field, shared with the instances of the other workers
+    std::shared_ptr<DisplacementMap> displacement = std::make_shared<DisplacementMap>();
+};
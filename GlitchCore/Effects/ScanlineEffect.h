@@ -1,6 +1,7 @@
 #pragma once
 #include "../IEffect.h"
-#include <cstdlib>
+#include "../Random.h"
+#include "../RowCopy.h"
 #include <vector>
 #include <algorithm>
 
@@ -11,31 +12,37 @@
  */
 class ScanlineEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
+    // Rows are shifted by at most 'maxShift' pixels.
+    int getHaloSize(const EffectParams& params) const override {
+        return std::abs(static_cast<int>(params.intensity));
+    }
+
+    // The maximum row shift is a distance in pixels.
+    void scaleParams(EffectParams& params, float scale) const override { params.intensity *= scale; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
         
-        std::vector<Pixel> source = data;
         int maxShift = static_cast<int>(params.intensity);
 
         for (int y = region.y; y < region.y + region.height; ++y) {
             
+            // One draw per row (keyed on y only, so it does not depend on the lens)
+            uint64_t bits = Random::bits(params.seed, params.frame, 0, y);
+
             // Randomly decide if this line should be shifted.
             // 30% probability of shifting a line to create a noisy look.
-            if ((std::rand() % 100) > 30) continue; 
+            if (Random::below(bits, 100) > 30) continue; 
             
             // Calculate random horizontal shift
-            int shift = (std::rand() % std::max(1, maxShift)) - (maxShift / 2);
-
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                if (!isInsideBubble(x, y, params)) continue;
+            int shift = Random::below(bits >> 32, std::max(1, maxShift)) - (maxShift / 2);
 
-                int srcX = x - shift;
-                
-                // Clamp horizontal coordinate to image bounds
-                srcX = std::max(0, std::min(imgWidth - 1, srcX));
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
 
-                data[y * imgWidth + x] = source[y * imgWidth + srcX];
-            }
+            // One shifted run per row, edge pixel repeated past the image border
+            RowCopy::shifted(source, x0 - shift, y, &dest.at(x0, y), x1 - x0);
         }
     }
-};
\ No newline at end of file
+};
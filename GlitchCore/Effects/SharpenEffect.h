@@ -0,0 +1,30 @@
+#pragma once
+#include "../IEffect.h"
+#include "../Convolution.h"
+#include <algorithm>
+
+/**
+ * @class SharpenEffect
+ * @brief Unsharp-style 3x3 sharpen: the pixel plus 'amount' times its Laplacian.
+ */
+class SharpenEffect : public IEffect {
+public:
+    // 3x3 kernel: one pixel of neighbours on every side.
+    int getHaloSize(const EffectParams& params) const override { return 1; }
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        // Amount in 1/256 steps: intensity 50 = 1.0, 100 = 2.0
+        int amount = std::max(0, std::min(512, static_cast<int>(params.intensity * 5.12f + 0.5f)));
+        const int kernel[9] = {
+            0,       -amount,             0,
+            -amount, 256 + 4 * amount,    -amount,
+            0,       -amount,             0
+        };
+        convolution.kernel3x3(source, dest, region, mask(), kernel, 8);
+    }
+
+private:
+    Convolution convolution; // Padded rows, reused between frames
+};
@@ -1,66 +1,47 @@
 #pragma once
 #include "../IEffect.h"
-#include <cmath>
+#include "../Convolution.h"
 #include <algorithm>
 
 /**
  * @class SobelEffect
  * @brief Performs edge detection using the Sobel operator.
  * Highlights high-contrast transitions (edges) and darkens flat areas.
+ *
+ * Luma is computed once per pixel into a padded block, and both gradients
+ * and their magnitude come from Convolution::sobelMagnitude(): the separable
+ * form of the kernels ([1 2 1] smoothing across the gradient, [-1 0 1]
+ * difference along it) in vectorized integer passes.
  */
 class SobelEffect : public IEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
-        // Copy source to read neighbors safely
-        std::vector<Pixel> source = data;
-        
-        // Sobel Kernels for X and Y directions
-        int gx[3][3] = { {-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1} };
-        int gy[3][3] = { {-1, -2, -1}, {0, 0, 0}, {1, 2, 1} };
+    // 3x3 kernel: one pixel of neighbours on every side.
+    int getHaloSize(const EffectParams& params) const override { return 1; }
 
-        for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                if (!isInsideBubble(x, y, params)) continue;
+    // Gradients are taken on luma (from the engine's cached plane when available).
+    bool usesLuma() const override { return true; }
 
-                float sumX = 0;
-                float sumY = 0;
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        const uint8_t* magnitudes = convolution.sobelMagnitude(source, region, mask());
 
-                // Convolution Loop (3x3 kernel)
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int pX = std::min(std::max(x + kx, 0), imgWidth - 1);
-                        int pY = std::min(std::max(y + ky, 0), imgHeight - 1);
-                        
-                        int idx = (pY * imgWidth) + pX;
-                        // Use luminance for edge calculation
-                        float val = source[idx].getLuminance();
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
 
-                        sumX += val * gx[ky + 1][kx + 1];
-                        sumY += val * gy[ky + 1][kx + 1];
-                    }
-                }
+            const uint8_t* edges = magnitudes + static_cast<size_t>(y - region.y) * region.width + (x0 - region.x);
+            Pixel* out = &dest.at(x0, y);
 
-                // Gradient Magnitude
-                int magnitude = static_cast<int>(std::sqrt(sumX * sumX + sumY * sumY));
-                
-                // Clamp and invert capability based on intensity
-                // If intensity is high, edges are neon colored, background black.
-                uint8_t edgeVal = static_cast<uint8_t>(std::min(255, magnitude));
-                
-                // Art style: Green edges (Matrix style) or White edges
-                int idx = (y * imgWidth) + x;
-                
-                if (params.intensity > 50) {
-                    // Neon Mode
-                    data[idx] = {0, edgeVal, 0, 255}; 
-                } else {
-                    // Standard B&W Edges
-                    data[idx] = {edgeVal, edgeVal, edgeVal, 255};
-                }
+            // Art style: green edges (Matrix style) above 50, otherwise white edges on black
+            if (params.intensity > 50) {
+                for (int i = 0; i < x1 - x0; ++i) out[i] = {0, edges[i], 0, 255};
+            } else {
+                for (int i = 0; i < x1 - x0; ++i) out[i] = {edges[i], edges[i], edges[i], 255};
             }
         }
     }
-};
\ No newline at end of file
+
+private:
+    Convolution convolution; // Luma block and gradient planes, reused between frames
+};
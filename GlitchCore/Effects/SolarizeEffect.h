@@ -1,32 +1,69 @@
 #pragma once
-#include "../IEffect.h"
+#include "../PointwiseEffect.h"
+#include "../Simd.h"
+#include "../PixelFormat.h"
+#include <algorithm>
 
 /**
  * @class SolarizeEffect
  * @brief Inverts pixel colors only if they exceed a specific threshold.
  * Creates a "burned film" or psychedelic look.
  */
-class SolarizeEffect : public IEffect {
+class SolarizeEffect : public PointwiseEffect {
 public:
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
-        
-        // Threshold is inverse of intensity (High intensity = low threshold = more effect)
-        uint8_t threshold = static_cast<uint8_t>(255 - (params.intensity * 2.5));
-
-        for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                if (!isInsideBubble(x, y, params)) continue;
-
-                int idx = (y * imgWidth) + x;
-                Pixel& p = data[idx];
-
-                // Logic: If channel > threshold, invert it. Else, keep it.
-                if (p.r > threshold) p.r = 255 - p.r;
-                if (p.g > threshold) p.g = 255 - p.g;
-                if (p.b > threshold) p.b = 255 - p.b;
-            }
+    void processSpan(const Pixel* src, Pixel* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        uint8_t threshold = getThreshold(params);
+        int i = 0;
+
+#if GLITCH_SIMD
+        Simd::Vec limit = Simd::splat8(threshold);
+        Simd::Vec ones = Simd::splat8(0xFF);
+        Simd::Vec alpha = Simd::alphaMask();
+
+        for (; i + Simd::kPixels <= count; i += Simd::kPixels) {
+            Simd::Vec v = Simd::load(src + i);
+            Simd::Vec inverted = Simd::select(Simd::greaterU8(v, limit), Simd::bitXor(v, ones), v);
+            Simd::store(dst + i, Simd::select(alpha, v, inverted)); // Alpha untouched
+        }
+#endif
+
+        processSpanScalar(src + i, dst + i, count - i, threshold);
+    }
+
+    void processSpan(const Pixel16* src, Pixel16* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanScalar<Rgba16>(src, dst, count, getThreshold(params));
+    }
+
+    void processSpan(const PixelF* src, PixelF* dst, int count, int x, int y,
+                     const EffectParams& params) override {
+        processSpanScalar<RgbaF32>(src, dst, count, getThreshold(params));
+    }
+
+    /**
+     * @brief Reference implementation of the kernel (also handles SIMD tails).
+     * Specialized at compile time for any pixel format (PixelFormat.h); the
+     * threshold stays an 8-bit level and is scaled to the format.
+     */
+    template <typename Format = Rgba8>
+    static void processSpanScalar(const typename Format::Pixel* src, typename Format::Pixel* dst, int count, uint8_t threshold) {
+        typename Format::Channel limit = Format::fromByte(threshold);
+        for (int i = 0; i < count; ++i) {
+            typename Format::Pixel p = src[i];
+
+            // Logic: If channel > threshold, invert it. Else, keep it.
+            if (p.r > limit) p.r = Format::invert(p.r);
+            if (p.g > limit) p.g = Format::invert(p.g);
+            if (p.b > limit) p.b = Format::invert(p.b);
+
+            dst[i] = p;
         }
     }
-};
\ No newline at end of file
+
+    // Threshold is inverse of intensity (High intensity = low threshold = more effect)
+    static uint8_t getThreshold(const EffectParams& params) {
+        int threshold = static_cast<int>(255 - (params.intensity * 2.5));
+        return static_cast<uint8_t>(std::max(0, std::min(255, threshold)));
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include "../IEffect.h"
+#include "../DisplacementMap.h"
+#include "../FastMath.h"
 #include <cmath>
+#include <memory>
 #include <vector>
 
 /**
@@ -10,58 +13,87 @@
  */
 class SwirlEffect : public IEffect {
 public:
+    // Rotation about the center keeps the distance, so reads stay inside the
+    // lens box; the extra pixel covers the box's exclusive far edge, and one
+    // more the right/bottom neighbour read by bilinear sampling.
+    int getHaloSize(const EffectParams& params) const override {
+        return params.quality == RenderQuality::Final ? 2 : 1;
+    }
+
+    // A row of the lens samples from anywhere on its circle
+    bool isBandLocal() const override { return false; }
+
     /**
-     * @brief Applies the swirl algorithm.
+     * @brief Source offset of the pixel at (dx, dy) from the center.
      * Logic: Calculates a rotation angle theta that increases as the pixel gets closer to the center.
-     * @param data The image buffer.
-     * @param imgWidth Image width.
-     * @param imgHeight Image height.
+     */
+    static Displacement getDisplacement(int dx, int dy, const EffectParams& params) {
+        // Scale intensity to a reasonable radian angle (e.g., intensity 100 = ~10 radians)
+        float angleParam = params.intensity / 10.0f;
+        float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+
+        // 1. Calculate rotation angle theta
+        // The angle is strongest at the center (dist=0) and 0 at the edge (dist=radius).
+        float percent = (params.radius - dist) / params.radius;
+        float theta = percent * percent * angleParam;
+
+        // 2. 2D Rotation Matrix application (inverse mapping, relative to the pixel)
+        bool exact = params.quality == RenderQuality::Final;
+        float sinTheta = exact ? std::sin(theta) : fastSin(theta);
+        float cosTheta = exact ? std::cos(theta) : fastCos(theta);
+        return Displacement::fromFloat(dx * cosTheta - dy * sinTheta - dx,
+                                       dx * sinTheta + dy * cosTheta - dy);
+    }
+
+    void shareCaches(IEffect& primary) override {
+        displacement = static_cast<SwirlEffect&>(primary).displacement;
+    }
+
+protected:
+    /**
+     * @brief Applies the swirl algorithm.
+     * Reads original coordinates from the read-only source: the transformation is
+     * non-linear and reading from the modified buffer would create visual artifacts.
+     * @param source The clean input image.
+     * @param dest The output image.
      * @param region The bounding box optimization.
      * @param params Effect parameters (intensity controls the max rotation angle).
      */
-    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-               const Region& region, const EffectParams& params) override {
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
         
-        // Create a temporary copy of the buffer to read original coordinates.
-        // This is crucial because the transformation is non-linear and reading 
-        // from the already-modified buffer would create visual artifacts.
-        std::vector<Pixel> source = data;
-        
-        // Scale intensity to a reasonable radian angle (e.g., intensity 100 = ~10 radians)
-        float angleParam = params.intensity / 10.0f; 
+        int imgWidth = dest.width;
+        int imgHeight = dest.height;
+
+        // The field only depends on the position relative to the center, so it
+        // is cached across frames while radius and intensity stay the same.
+        bool cached = displacement->update(params);
+        auto field = [&params](int dx, int dy) { return getDisplacement(dx, dy, params); };
 
         for (int y = region.y; y < region.y + region.height; ++y) {
-            for (int x = region.x; x < region.x + region.width; ++x) {
-                
-                // --- Bubble Geometry Calculations ---
-                int dx = x - params.centerX;
-                int dy = y - params.centerY;
-                float dist = std::sqrt(dx*dx + dy*dy);
-                
-                // Optimization: Skip pixels outside the radius
-                if (dist > params.radius) continue;
+            // Optimization: Only visit the pixels inside the radius
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
 
-                // 1. Calculate rotation angle theta
-                // The angle is strongest at the center (dist=0) and 0 at the edge (dist=radius).
-                float percent = (params.radius - dist) / params.radius;
-                float theta = percent * percent * angleParam;
-                
-                // 2. 2D Rotation Matrix application
-                float sinTheta = std::sin(theta);
-                float cosTheta = std::cos(theta);
-                
-                // Calculate the source coordinate (inverse mapping) relative to the center
-                float srcX = params.centerX + (dx * cosTheta - dy * sinTheta);
-                float srcY = params.centerY + (dx * sinTheta + dy * cosTheta);
+            int dy = y - params.centerY;
+            const Displacement* row = cached ? displacement->row(dy, field) : nullptr;
 
-                // 3. Sampling with Boundary Checks
-                int sx = static_cast<int>(srcX);
-                int sy = static_cast<int>(srcY);
+            for (int x = x0; x < x1; ++x) {
+                int dx = x - params.centerX;
+                Displacement d = row ? row[dx] : field(dx, dy);
+
+                // Sampling with Boundary Checks
+                int sx = x + d.wholeX();
+                int sy = y + d.wholeY();
 
                 if (sx >= 0 && sx < imgWidth && sy >= 0 && sy < imgHeight) {
-                    data[y * imgWidth + x] = source[sy * imgWidth + sx];
+                    dest.at(x, y) = sampleDisplaced(source, sx, sy, d, params.quality);
                 }
             }
         }
     }
-};
\ No newline at end of file
+
+private:
+    // Cached field, shared with the instances of the other workers
+    std::shared_ptr<DisplacementMap> displacement = std::make_shared<DisplacementMap>();
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cmath>
+
+/**
+ * @file FastMath.h
+ * @brief Polynomial approximations used by the drag quality tier.
+ *
+ * Error bounds (absolute, float arithmetic included):
+ * - fastSin / fastCos: <= 2e-4 for |x| <= 1e4 (degree-7 Taylor on [-pi/2, pi/2]
+ *   after Cody-Waite range reduction; the truncation term is (pi/2)^9 / 9! = 1.6e-4).
+ * In the geometric effects the angle multiplies a distance of at most the lens
+ * radius, so the source position moves by at most radius * 2e-4 pixels
+ * (0.2 px for a 1000 px lens), below the nearest-neighbour step.
+ *
+ * sqrt is not approximated: it is a single instruction on every target
+ * (f32.sqrt, sqrtss, fsqrt) and already as fast as any polynomial.
+ */
+
+constexpr float kPi = 3.14159265358979f;
+
+// x - k * 2pi in [-pi, pi]. 2pi is split in two parts so that k * 6.28125 is exact.
+inline float reduceAngle(float x) {
+    float k = std::nearbyint(x * (0.5f / kPi));
+    return (x - k * 6.28125f) - k * 1.9353071795864769e-3f;
+}
+
+// sin on [-pi/2, pi/2]
+inline float sinPoly(float x) {
+    float x2 = x * x;
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f))));
+}
+
+inline float fastSin(float x) {
+    // Fold into [-pi/2, pi/2] using sin(pi - x) = sin(x)
+    x = reduceAngle(x);
+    if (x > 0.5f * kPi) x = kPi - x;
+    else if (x < -0.5f * kPi) x = -kPi - x;
+    return sinPoly(x);
+}
+
+inline float fastCos(float x) {
+    // cos(x) = sin(pi/2 - |x|), and pi/2 - |x| is already in [-pi/2, pi/2]
+    return sinPoly(0.5f * kPi - std::fabs(reduceAngle(x)));
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "Common.h"
+#include "EffectFactory.h"
+
+/**
+ * Frame statistics are compiled in by default. Builds that do not want the
+ * clock reads and counters define GLITCH_FRAME_STATS=0: the recorder and the
+ * stopwatch below become empty stubs and getFrameStats() reports zeros.
+ */
+#ifndef GLITCH_FRAME_STATS
+    #define GLITCH_FRAME_STATS 1
+#endif
+
+/**
+ * @brief Distribution of one per-frame measurement over the recorded window.
+ */
+struct StatSummary {
+    double mean = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+/**
+ * @brief Aggregated statistics of the last recorded frames (see FrameStatsRecorder).
+ * Times are in milliseconds, pixels are lens-box pixels summed over all stages,
+ * bytes are what the engine copied itself (healing + luma refresh).
+ */
+struct FrameStats {
+    int count = 0; // Frames in the window (at most FrameStatsRecorder::kCapacity)
+    StatSummary healMs;  // Restoring the previous frame's pixels
+    StatSummary setupMs; // Preparing the sources (luma plane) before the effects run
+    StatSummary applyMs; // Running the effect chain
+    StatSummary totalMs;
+    StatSummary pixels;
+    StatSummary bytesCopied;
+};
+
+/**
+ * @brief Raw measurements of one rendered frame.
+ */
+struct FrameSample {
+    float healMs = 0;
+    float setupMs = 0;
+    float applyMs = 0;
+    uint64_t pixels = 0;
+    uint64_t bytesCopied = 0;
+};
+
+#if GLITCH_FRAME_STATS
+
+/**
+ * @class FrameStopwatch
+ * @brief Measures consecutive phases of a frame: each lap() returns the
+ * milliseconds since the previous lap (or since construction).
+ */
+class FrameStopwatch {
+public:
+    float lap() {
+        Clock::time_point now = Clock::now();
+        float ms = std::chrono::duration<float, std::milli>(now - last).count();
+        last = now;
+        return ms;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last = Clock::now();
+};
+
+/**
+ * @class FrameStatsRecorder
+ * @brief Keeps the last kCapacity FrameSamples in a fixed ring buffer, plus
+ * per-effect pixel totals since the last reset.
+ *
+ * Recording is a plain copy into the ring and never allocates; the sorting
+ * needed for percentiles happens only when summarize() is called.
+ */
+class FrameStatsRecorder {
+public:
+    static constexpr int kCapacity = 256;
+
+    void record(const FrameSample& sample) {
+        samples[next] = sample;
+        next = (next + 1) % kCapacity;
+        count = std::min(count + 1, kCapacity);
+    }
+
+    /**
+     * @brief Adds the pixels one stage covered to its effect's total.
+     */
+    void countStage(EffectType type, const Region& region) {
+        int index = static_cast<int>(type);
+        if (index < 0 || index >= kEffectTypeCount || region.isEmpty()) return;
+        effectPixels[index] += static_cast<uint64_t>(region.width) * region.height;
+    }
+
+    uint64_t getEffectPixels(EffectType type) const {
+        int index = static_cast<int>(type);
+        return (index >= 0 && index < kEffectTypeCount) ? effectPixels[index] : 0;
+    }
+
+    FrameStats summarize() const {
+        FrameStats stats;
+        stats.count = count;
+        stats.healMs = summarizeField([](const FrameSample& s) { return double(s.healMs); });
+        stats.setupMs = summarizeField([](const FrameSample& s) { return double(s.setupMs); });
+        stats.applyMs = summarizeField([](const FrameSample& s) { return double(s.applyMs); });
+        stats.totalMs = summarizeField([](const FrameSample& s) { return double(s.healMs) + s.setupMs + s.applyMs; });
+        stats.pixels = summarizeField([](const FrameSample& s) { return double(s.pixels); });
+        stats.bytesCopied = summarizeField([](const FrameSample& s) { return double(s.bytesCopied); });
+        return stats;
+    }
+
+    void reset() {
+        count = 0;
+        next = 0;
+        effectPixels.fill(0);
+    }
+
+private:
+    std::array<FrameSample, kCapacity> samples;
+    int count = 0; // Valid samples
+    int next = 0;  // Slot written by the next record()
+    std::array<uint64_t, kEffectTypeCount> effectPixels = {};
+
+    template <typename Field>
+    StatSummary summarizeField(Field field) const {
+        StatSummary summary;
+        if (count == 0) return summary;
+
+        std::array<double, kCapacity> values;
+        double sum = 0;
+        for (int i = 0; i < count; ++i) {
+            values[i] = field(samples[i]);
+            sum += values[i];
+        }
+        std::sort(values.begin(), values.begin() + count);
+
+        // Nearest-rank percentiles
+        auto percentile = [&](double p) {
+            int rank = static_cast<int>(std::ceil(p * count)) - 1;
+            return values[std::max(0, std::min(count - 1, rank))];
+        };
+        summary.mean = sum / count;
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = values[count - 1];
+        return summary;
+    }
+};
+
+#else
+
+class FrameStopwatch {
+public:
+    float lap() { return 0; }
+};
+
+class FrameStatsRecorder {
+public:
+    static constexpr int kCapacity = 0;
+
+    void record(const FrameSample&) {}
+    void countStage(EffectType, const Region&) {}
+    uint64_t getEffectPixels(EffectType) const { return 0; }
+    FrameStats summarize() const { return {}; }
+    void reset() {}
+};
+
+#endif // GLITCH_FRAME_STATS
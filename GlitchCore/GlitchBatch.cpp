@@ -0,0 +1,238 @@
+/**
+ * @file GlitchBatch.cpp
+ * @brief Headless batch tool: applies an effect chain to every image in a directory.
+ *
+ * Usage: glitch_batch [options] <input_dir> <output_dir>
+ *   --effect NAME[:I]    Append a chain stage, by name or id, with intensity I (default 50)
+ *   --lens X,Y,R         Apply inside this bubble (default: the whole image)
+ *   --feather N          Soft lens edge in pixels
+ *   --quality drag|final Resampling tier of Swirl/Ripple (default final)
+ *   --seed N             Seed of the randomized effects
+ *   --jobs N             Worker threads (default: hardware concurrency)
+ *   --linear 16|float    Run the chain in linear light at 16-bit or float precision
+ *                        (point-wise effects only: Invert, Solarize, RGB Noise)
+ *   --format ppm|pam|qoi Output format (default: same as each input)
+ *
+ * Reads .ppm (P6), .pam (P7) and .qoi files. Every worker owns a GlitchEngine
+ * and its file buffers, so after the first few images nothing is reallocated
+ * unless a larger image comes along. Workers pull the next file from a shared
+ * counter; each engine renders single-threaded since the pool is already busy.
+ *
+ * With --linear the lens area is decoded to linear light once, every stage runs
+ * on the wide pixels and the result is encoded back to sRGB once, instead of
+ * each stage working on (and rounding to) gamma-encoded 8-bit values.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Common.h"
+#include "ImageIO.h"
+
+// Include the Engine (Unity build approach, same as bindings.cpp)
+#include "GlitchEngine.cpp"
+
+namespace fs = std::filesystem;
+
+// --- CONFIGURATION ---
+
+struct BatchStage {
+    EffectType type;
+    float intensity;
+};
+
+// Pixels the chain runs on (GlitchEngine::renderChain / renderChainLinear)
+enum class BatchPrecision { Srgb8, Linear16, LinearFloat };
+
+struct BatchOptions {
+    std::vector<BatchStage> stages;
+    bool useLens = false;
+    int lensX = 0, lensY = 0, lensRadius = 0;
+    int feather = 0;
+    int quality = 1; // GlitchEngine::setQuality tier
+    uint32_t seed = 0;
+    BatchPrecision precision = BatchPrecision::Srgb8;
+    int jobs = TileScheduler::defaultThreadCount();
+    ImageFormat outputFormat = ImageFormat::Unknown; // Unknown = same as input
+};
+
+/**
+ * @brief Per-thread state, reused for every image the worker processes.
+ */
+struct BatchWorker {
+    GlitchEngine engine;
+    LinearImage<Pixel16> linear16; // Working copies for --linear
+    LinearImage<PixelF> linearF;
+    std::vector<uint8_t> fileBytes;
+    std::vector<uint8_t> encoded;
+};
+
+// --- HELPER FUNCTIONS ---
+
+[[noreturn]] void usage(const std::string& error) {
+    std::cerr << "glitch_batch: " << error << "\n"
+              << "Usage: glitch_batch [--effect NAME[:I]]... [--lens X,Y,R] [--feather N] [--quality drag|final]\n"
+              << "                    [--seed N] [--jobs N] [--linear 16|float] [--format ppm|pam|qoi] <input_dir> <output_dir>" << std::endl;
+    std::exit(2);
+}
+
+bool readFile(const fs::path& path, std::vector<uint8_t>& bytes) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    bytes.resize(static_cast<size_t>(size));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), size));
+}
+
+bool writeFile(const fs::path& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(path, std::ios::binary);
+    return file && file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+/**
+ * @brief Decodes, glitches and re-encodes one file.
+ * @return Empty string on success, otherwise the reason it failed.
+ */
+std::string processImage(BatchWorker& worker, const BatchOptions& options, const fs::path& input, const fs::path& outputDir) {
+    ImageFormat format = imageFormatFromPath(input.string());
+    if (!readFile(input, worker.fileBytes)) return "cannot read";
+
+    int width = 0, height = 0;
+    if (!ImageCodec::readHeader(worker.fileBytes.data(), worker.fileBytes.size(), format, width, height)) return "unsupported or corrupt header";
+
+    GlitchEngine& engine = worker.engine;
+    engine.loadBox(width, height);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    if (!ImageCodec::decode(worker.fileBytes.data(), worker.fileBytes.size(), format, original)) return "truncated or corrupt data";
+
+    // Same full-image lens as the editor's "Full Image" mode
+    int radius = options.useLens ? options.lensRadius : static_cast<int>(std::max(width, height) * 1.5);
+    int cx = options.useLens ? options.lensX : width / 2;
+    int cy = options.useLens ? options.lensY : height / 2;
+    if (options.precision == BatchPrecision::Linear16) engine.renderChainLinear(cx, cy, radius, worker.linear16);
+    else if (options.precision == BatchPrecision::LinearFloat) engine.renderChainLinear(cx, cy, radius, worker.linearF);
+    else engine.renderChain(cx, cy, radius);
+
+    ImageFormat outputFormat = (options.outputFormat == ImageFormat::Unknown) ? format : options.outputFormat;
+    const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+    ImageCodec::encode(display, width, height, outputFormat, worker.encoded);
+
+    static const char* const extensions[] = {"", ".ppm", ".pam", ".qoi"};
+    fs::path output = outputDir / input.filename();
+    output.replace_extension(extensions[static_cast<int>(outputFormat)]);
+    return writeFile(output, worker.encoded) ? "" : "cannot write " + output.string();
+}
+
+// --- MAIN ---
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--effect" && hasValue) {
+            std::string spec = argv[++i];
+            size_t colon = spec.find(':');
+            BatchStage stage = {EffectType::NONE, 50.0f};
+            if (!parseEffectType(spec.substr(0, colon).c_str(), stage.type)) usage("unknown effect '" + spec + "'");
+            if (colon != std::string::npos) stage.intensity = std::strtof(spec.c_str() + colon + 1, nullptr);
+            options.stages.push_back(stage);
+        }
+        else if (arg == "--lens" && hasValue) {
+            if (std::sscanf(argv[++i], "%d,%d,%d", &options.lensX, &options.lensY, &options.lensRadius) != 3) usage("bad --lens (expected X,Y,R)");
+            options.useLens = true;
+        }
+        else if (arg == "--feather" && hasValue) options.feather = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--quality" && hasValue) {
+            std::string tier = argv[++i];
+            if (tier != "drag" && tier != "final") usage("--quality must be drag or final");
+            options.quality = (tier == "final") ? 1 : 0;
+        }
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--linear" && hasValue) {
+            std::string precision = argv[++i];
+            if (precision != "16" && precision != "float") usage("--linear must be 16 or float");
+            options.precision = (precision == "16") ? BatchPrecision::Linear16 : BatchPrecision::LinearFloat;
+        }
+        else if (arg == "--jobs" && hasValue) options.jobs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--format" && hasValue) {
+            options.outputFormat = imageFormatFromPath(std::string(".") + argv[++i]);
+            if (options.outputFormat == ImageFormat::Unknown) usage("--format must be ppm, pam or qoi");
+        }
+        else if (arg[0] != '-') paths.push_back(arg);
+        else usage("unknown option '" + arg + "'");
+    }
+    if (paths.size() != 2) usage("expected an input and an output directory");
+    if (options.stages.empty()) usage("no --effect given");
+    if (options.precision != BatchPrecision::Srgb8) {
+        EffectRegistry effects;
+        for (const BatchStage& stage : options.stages) {
+            IEffect* effect = effects.get(stage.type);
+            if (effect && !effect->asPointwise()) usage(std::string("--linear cannot run ") + getEffectName(stage.type) + " (not point-wise)");
+        }
+    }
+
+    std::error_code error;
+    std::vector<fs::path> inputs;
+    for (const fs::directory_entry& entry : fs::directory_iterator(paths[0], error)) {
+        if (entry.is_regular_file() && imageFormatFromPath(entry.path().string()) != ImageFormat::Unknown) inputs.push_back(entry.path());
+    }
+    if (error) usage("cannot list " + paths[0] + ": " + error.message());
+    std::sort(inputs.begin(), inputs.end());
+    fs::create_directories(paths[1], error);
+    if (error) usage("cannot create " + paths[1] + ": " + error.message());
+
+    // One engine per worker, configured once
+    int jobs = std::max(1, std::min(options.jobs, static_cast<int>(inputs.size())));
+    std::vector<std::unique_ptr<BatchWorker>> workers;
+    for (int i = 0; i < jobs; i++) {
+        workers.push_back(std::make_unique<BatchWorker>());
+        GlitchEngine& engine = workers.back()->engine;
+        engine.setThreadCount(1);
+        engine.setFeather(options.feather);
+        engine.setQuality(options.quality);
+        engine.setSeed(options.seed);
+        for (const BatchStage& stage : options.stages) engine.addChainStage(static_cast<int>(stage.type), stage.intensity);
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> failures{0};
+    std::mutex logMutex;
+    auto work = [&](BatchWorker& worker) {
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            worker.engine.setFrameIndex(static_cast<uint32_t>(i)); // Noise depends on the file, not the worker
+            std::string problem = processImage(worker, options, inputs[i], paths[1]);
+            if (!problem.empty()) {
+                failures++;
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "glitch_batch: " << inputs[i].string() << ": " << problem << std::endl;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; i++) threads.emplace_back(work, std::ref(*workers[i]));
+    if (!workers.empty()) work(*workers[0]);
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t done = inputs.size() - failures;
+    std::cerr << "glitch_batch: " << done << " of " << inputs.size() << " images in " << seconds << " s ("
+              << (seconds > 0 ? done / seconds : 0.0) << " images/s, " << jobs << " jobs)" << std::endl;
+    return failures > 0 ? 1 : 0;
+}
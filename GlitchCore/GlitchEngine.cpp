@@ -1,71 +1,785 @@
 #include <vector>
 #include <cstring> // for std::memcpy
 #include <algorithm>
+#include <chrono>
 #include "Common.h"
-#include "EffectFactory.h"
+#include "AlignedBuffer.h"
+#include "EffectRegistry.h"
+#include "EffectChain.h"
+#include "TileScheduler.h"
+#include "FrameStats.h"
+#include "UndoHistory.h"
+#include "MipPyramid.h"
+#include "LensMask.h"
+#include "SummedAreaTable.h"
+#include "LinearImage.h"
 
 class GlitchEngine {
 private:
-    std::vector<Pixel> originalBuffer; // The clean backup
-    std::vector<Pixel> displayBuffer;  // The dirty render
+    // Both buffers keep their capacity across loads and are never zero-filled.
+    // The display is only allocated once a frame is rendered (or its pointer is requested).
+    AlignedBuffer<Pixel> originalBuffer; // The clean backup, written by JS
+    AlignedBuffer<Pixel> displayBuffer;  // The dirty render
+    bool displayReady = false;           // displayBuffer sized for the current image
     int width = 0;
     int height = 0;
 
+    // Worker pool for large lenses. The chain keeps one set of persistent
+    // effect instances per worker (created once, reused every frame).
+    TileScheduler scheduler;
+    EffectChain chain;
+
+    // Effect chain configured from JS through addChainStage()
+    std::vector<EffectStage> chainStages;
+
+    int lensFeather = 0; // Soft lens edge width in pixels
+    bool linearEdges = false; // Mix the soft edge in linear light
+    RenderQuality quality = RenderQuality::Drag;
+
+    // Randomized effects are a pure function of (seed, frame index, position)
+    uint32_t seed = 0;
+    uint32_t nextFrame = 0; // Frame index used by the next render
+    uint32_t lastFrame = 0; // Frame index used by the last render
+
+    // 8-bit luma of originalBuffer, built on first use by a luma-driven effect
+    // and refreshed only where the original changed since (lumaStale).
+    AlignedBuffer<uint8_t> lumaPlane;
+    Region lumaStale = {0, 0, 0, 0};
+
+    // Per-channel summed-area table of originalBuffer, built on first use by an
+    // averaging effect and updated past the area changed since (integralStale).
+    // Updates cost up to the whole image, so none happen while a stroke is open.
+    SummedAreaTable integral;
+    Region integralStale = {0, 0, 0, 0};
+
+    // Dirty rectangle tracking: displayBuffer equals originalBuffer everywhere
+    // outside lastDirty, so healing only has to touch that rectangle.
+    Region lastDirty = {0, 0, 0, 0};   // Pixels written by the previous frame
+    Region presentRect = {0, 0, 0, 0}; // Pixels that changed since the last presented frame
+
+    // Timings and counters of the last frames (no-op when GLITCH_FRAME_STATS is 0)
+    FrameStatsRecorder frameStats;
+
+    // Paint mode: strokes committed into originalBuffer, undone per tile
+    UndoHistory undoHistory;
+
+    // Progressive preview: effects run on a reduced copy of the original while
+    // the pointer moves, then refine() renders the same frame at full size.
+    MipPyramid pyramid;
+    AlignedBuffer<Pixel> previewBuffer; // Effect output at the preview level
+    LensMask previewMask;               // Full-resolution lens used for upscaling
+    double previewBudgetMs = 12.0;
+    int forcedPreviewLevel = -1;       // -1 = pick from the budget
+    int lastPreviewLevel = 0;
+    double previewCost[kEffectTypeCount] = {}; // Measured ms per processed pixel (0 = unknown)
+    EffectStage lastPreview;
+    bool hasPreview = false;
+
+    // Resumable frame started by beginFrame() and advanced by step()
+    bool frameInFlight = false;
+    Region pendingPresent = {0, 0, 0, 0}; // Healed by beginFrame, reported by the first step
+    FrameSample jobSample;
+    EffectStage jobStage;
+
+    /**
+     * @brief Recomputes the stale part of the luma plane.
+     * @return Number of luma bytes written.
+     */
+    size_t refreshLuma() {
+        if (lumaPlane.size() != originalBuffer.size()) {
+            lumaPlane.resize(originalBuffer.size());
+            lumaStale = {0, 0, width, height};
+        }
+        for (int y = lumaStale.y; y < lumaStale.y + lumaStale.height; ++y) {
+            size_t offset = static_cast<size_t>(y) * width + lumaStale.x;
+            computeLuma(originalBuffer.data() + offset, lumaPlane.data() + offset, lumaStale.width);
+        }
+        size_t written = lumaStale.isEmpty() ? 0 : static_cast<size_t>(lumaStale.width) * lumaStale.height;
+        lumaStale = {0, 0, 0, 0};
+        return written;
+    }
+
+    /**
+     * @brief Brings the summed-area table up to date with the original.
+     * @return Number of table bytes written.
+     */
+    size_t refreshIntegral() {
+        SourceView original = SourceView::whole(originalBuffer.data(), width, height);
+        const Region& area = integral.getArea();
+        size_t entries;
+        if (area.x != 0 || area.y != 0 || area.width != width || area.height != height) {
+            integral.build(original, {0, 0, width, height});
+            entries = static_cast<size_t>(width) * height;
+        }
+        else {
+            entries = integral.update(original, integralStale);
+        }
+        integralStale = {0, 0, 0, 0};
+        return entries * 4 * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief Attaches the summed-area table to the source if it matches the original.
+     * While a stroke is open every dab changes the original, and bringing the
+     * table up to date would rewrite everything below and right of the dab. The
+     * table is left stale instead: the effects build a table over their lens
+     * (SummedAreaTable::of), and the first frame after the stroke updates it.
+     * @return Number of table bytes written.
+     */
+    size_t attachIntegral(SourceView& source) {
+        if (undoHistory.isCapturing() && !integralStale.isEmpty()) return 0;
+        size_t bytes = refreshIntegral();
+        source.integral = &integral;
+        return bytes;
+    }
+
+    /**
+     * @brief Records that the original changed: the caches derived from it
+     * (luma plane, summed-area table, pyramid) are refreshed there on next use.
+     */
+    void markOriginalChanged(const Region& changed) {
+        lumaStale = unionRegion(lumaStale, changed);
+        integralStale = unionRegion(integralStale, changed);
+        pyramid.invalidate(changed);
+    }
+
+    /**
+     * @brief Sizes the display buffer for the current image on first use.
+     * Its contents are undefined until a render heals it (lastDirty covers the
+     * whole image after every load).
+     */
+    void ensureDisplay() {
+        if (displayReady) return;
+        displayBuffer.resize(originalBuffer.size());
+        displayReady = true;
+    }
+
+    /**
+     * @brief Restores a rectangle of the display buffer from the original, row by row.
+     */
+    void healRegion(const Region& r) {
+        for (int y = r.y; y < r.y + r.height; ++y) {
+            size_t offset = static_cast<size_t>(y) * width + r.x;
+            std::memcpy(displayBuffer.data() + offset, originalBuffer.data() + offset, r.width * sizeof(Pixel));
+        }
+    }
+
 public:
     GlitchEngine() {}
 
     // 1. Memory Setup
-    void loadBox(int w, int h) {
-        width = w;
-        height = h;
-        originalBuffer.resize(w * h);
-        displayBuffer.resize(w * h);
+    /**
+     * @brief Prepares the engine for a new w x h image and returns where to write it.
+     * The caller writes w * h RGBA pixels there exactly once (e.g. ImageData.data
+     * into HEAPU8). The buffer is 64-byte aligned and not zero-filled; its memory
+     * is reused when the new image is not larger than the previous one.
+     * @return Address of the original buffer (same as getOriginalPointer()).
+     */
+    uintptr_t beginIngest(int w, int h) {
+        width = std::max(0, w);
+        height = std::max(0, h);
+        size_t count = static_cast<size_t>(width) * height;
+        originalBuffer.resize(count);
+        displayReady = false; // Resized lazily by the next render
+        cancelFrame();
+
+        // The display buffer has never been healed: treat the whole image as dirty.
+        lastDirty = {0, 0, width, height};
+        presentRect = {0, 0, 0, 0};
+        lumaStale = {0, 0, width, height}; // JS fills the original after this call
+        integralStale = {0, 0, width, height};
+        undoHistory.reset(width, height);
+        pyramid.reset(width, height);
+        hasPreview = false;
+        return getOriginalPointer();
+    }
+
+    /**
+     * @brief Same as beginIngest(), for callers that fetch the pointer separately.
+     */
+    void loadBox(int w, int h) { beginIngest(w, h); }
+
+    /**
+     * @brief Tells the engine that JS rewrote part of the original buffer.
+     * The cached luma of that area is rebuilt on next use, and the display is
+     * healed there on the next frame.
+     */
+    void invalidateOriginal(int x, int y, int w, int h) {
+        Region changed = clipRegion({x, y, w, h}, width, height);
+        markOriginalChanged(changed);
+        lastDirty = unionRegion(lastDirty, changed);
     }
 
     // 2. Accessors for JS
     uintptr_t getOriginalPointer() { return reinterpret_cast<uintptr_t>(originalBuffer.data()); }
-    uintptr_t getDisplayPointer() { return reinterpret_cast<uintptr_t>(displayBuffer.data()); }
+
+    /**
+     * @brief Address of the rendered image. Allocates it if no frame was rendered
+     * since the last load; its contents are defined once a frame has been rendered.
+     */
+    uintptr_t getDisplayPointer() {
+        ensureDisplay();
+        return reinterpret_cast<uintptr_t>(displayBuffer.data());
+    }
+
+    /**
+     * @brief Area of the display buffer changed by the last renderFrame call.
+     * Union of the healed previous frame and the newly written region; the caller
+     * only needs to upload this sub-rectangle. Empty if nothing changed.
+     */
+    Region getDirtyRect() const { return presentRect; }
 
     /**
      * @brief The Main Render Loop.
-     * 1. Resets the frame (Healing).
-     * 2. Gets the correct effect from Factory.
-     * 3. Applies the effect.
+     * Applies a single effect inside the lens around the mouse.
      */
     void renderFrame(int mouseX, int mouseY, int radius, int effectId, float intensity) {
-        // Step A: "Heal" the frame (Copy Original -> Display)
-        // This ensures the glitch doesn't paint permanently over the image
-        if (!originalBuffer.empty()) {
-             std::memcpy(displayBuffer.data(), originalBuffer.data(), originalBuffer.size() * sizeof(Pixel));
-        }
-
-        // Step B: Get Strategy
-        EffectType type = static_cast<EffectType>(effectId);
-        auto effect = EffectFactory::createEffect(type);
-
-        if (!effect) return; // NONE or Invalid
-
-        // Step C: Prepare Context
-        // Optimization: Define a Bounding Box around the mouse to avoid scanning the whole HD image
-        Region region;
-        region.x = std::max(0, mouseX - radius);
-        region.y = std::max(0, mouseY - radius);
-        
-        // Clamp width/height to image boundaries
-        int endX = std::min(width, mouseX + radius);
-        int endY = std::min(height, mouseY + radius);
-        
-        region.width = endX - region.x;
-        region.height = endY - region.y;
+        EffectStage stage;
+        stage.type = static_cast<EffectType>(effectId);
+        stage.params = makeLensParams(mouseX, mouseY, radius, intensity);
+        renderEffects(&stage, 1);
+    }
+
+    /**
+     * @brief Renders an ordered chain of effects, each with its own parameters.
+     * 1. Resets the frame (Healing) where the previous frame left marks.
+     * 2. Runs the stages (point-wise neighbours fused into one pass).
+     * 3. Records the new dirty rectangle.
+     */
+    void renderEffects(const EffectStage* stages, int count) {
+        FrameStopwatch stopwatch;
+        FrameSample sample;
+        ensureDisplay();
+        cancelFrame();
+
+        // Step A: "Heal" the previous frame (Copy Original -> Display)
+        // This ensures the glitch doesn't paint permanently over the image.
+        // The new region needs no copy: it is already clean unless it overlaps lastDirty.
+        Region healed = lastDirty;
+        healRegion(healed);
+        sample.healMs = stopwatch.lap();
+        if (!healed.isEmpty()) sample.bytesCopied = static_cast<uint64_t>(healed.width) * healed.height * sizeof(Pixel);
+
+        // Step B: Execute. The display is clean at this point, so the first stage
+        // can read straight from the original image.
+        SourceView source = SourceView::whole(originalBuffer.data(), width, height);
+        ImageView dest = ImageView::whole(displayBuffer.data(), width, height);
+        if (needsLuma(stages, count)) {
+            sample.bytesCopied += refreshLuma();
+            source.luma = lumaPlane.data();
+        }
+        if (needsIntegral(stages, count)) sample.bytesCopied += attachIntegral(source);
+        sample.setupMs = stopwatch.lap();
+
+        lastDirty = chain.run(scheduler, stages, count, source, dest);
+        presentRect = unionRegion(healed, lastDirty);
+        sample.applyMs = stopwatch.lap();
+
+        for (int i = 0; i < count; ++i) {
+            Region covered = lensRegion(stages[i].params, width, height);
+            if (!covered.isEmpty()) sample.pixels += static_cast<uint64_t>(covered.width) * covered.height;
+            frameStats.countStage(stages[i].type, covered);
+        }
+        frameStats.record(sample);
+
+        lastFrame = nextFrame++;
+    }
+
+    /**
+     * @brief Sets the width of the anti-aliased lens edge (0 = hard edge).
+     */
+    void setFeather(int pixels) { lensFeather = std::max(0, pixels); }
+
+    /**
+     * @brief Mixes the soft lens edge in linear light instead of sRGB.
+     */
+    void setLinearEdges(bool enabled) { linearEdges = enabled; }
+
+    /**
+     * @brief Seed of the randomized effects (Jitter, Scanline, RGB Noise).
+     */
+    void setSeed(uint32_t value) { seed = value; }
+
+    /**
+     * @brief Frame index used by the last render. Passing it to setFrameIndex()
+     * and rendering the same input again reproduces that frame exactly.
+     */
+    uint32_t getFrameIndex() const { return lastFrame; }
+
+    /**
+     * @brief Makes the next render use this frame index (it then keeps counting up).
+     */
+    void setFrameIndex(uint32_t frame) { nextFrame = frame; }
+
+    /**
+     * @brief Selects the resampling tier: 0 = drag (fast, nearest), 1 = final (bilinear).
+     */
+    void setQuality(int tier) { quality = (tier == 1) ? RenderQuality::Final : RenderQuality::Drag; }
+
+    /**
+     * @brief Number of threads used for rendering, including the caller (1 = single-threaded).
+     * Defaults to the hardware concurrency; always 1 in wasm builds without pthreads.
+     */
+    void setThreadCount(int threads) { scheduler.setThreadCount(threads); }
+    int getThreadCount() const { return scheduler.getThreadCount(); }
+
+    /**
+     * @brief Count, mean, p50/p95/p99 and max of the per-phase timings, pixels
+     * and bytes copied over the last FrameStatsRecorder::kCapacity frames.
+     */
+    FrameStats getFrameStats() const { return frameStats.summarize(); }
+
+    /**
+     * @brief Lens-box pixels processed by one effect type since the last reset
+     * (a double so JS receives a plain number).
+     */
+    double getEffectPixels(int effectId) const {
+        return static_cast<double>(frameStats.getEffectPixels(static_cast<EffectType>(effectId)));
+    }
+
+    void resetFrameStats() { frameStats.reset(); }
+
+    // 3. Paint mode API for JS
+    /**
+     * @brief Starts a stroke: the dabs until endStroke() form one undo step.
+     * paintDab() opens a stroke by itself if none is open.
+     */
+    void beginStroke() { undoHistory.beginStroke(); }
+
+    /**
+     * @brief Renders the effect inside the lens and commits it into the working
+     * image (the original buffer), so the next dabs and frames build on it.
+     */
+    void paintDab(int mouseX, int mouseY, int radius, int effectId, float intensity) {
+        undoHistory.beginStroke();
+        renderFrame(mouseX, mouseY, radius, effectId, intensity);
+
+        // Save the touched tiles, then copy the painted box into the original.
+        // Afterwards the display equals the original everywhere.
+        Region painted = lastDirty;
+        undoHistory.capture(originalBuffer.data(), painted);
+        for (int y = painted.y; y < painted.y + painted.height; ++y) {
+            size_t offset = static_cast<size_t>(y) * width + painted.x;
+            std::memcpy(originalBuffer.data() + offset, displayBuffer.data() + offset, painted.width * sizeof(Pixel));
+        }
+        markOriginalChanged(painted);
+        lastDirty = {0, 0, 0, 0};
+    }
+
+    /**
+     * @brief Closes the stroke and stores it as an undo step.
+     * @return False if the stroke changed nothing (or did not fit the budget).
+     */
+    bool endStroke() { return undoHistory.endStroke(originalBuffer.data()); }
+
+    /**
+     * @brief Reverts the last stroke (closing an open one first).
+     * The restored area is healed into the display and reported by getDirtyRect().
+     */
+    bool undo() {
+        endStroke();
+        return applyHistory(undoHistory.undo(originalBuffer.data()));
+    }
+
+    bool redo() {
+        endStroke();
+        return applyHistory(undoHistory.redo(originalBuffer.data()));
+    }
+
+    bool canUndo() const { return undoHistory.getUndoCount() > 0; }
+    bool canRedo() const { return undoHistory.getRedoCount() > 0; }
 
+    /**
+     * @brief Caps the memory of the undo history; the oldest strokes are dropped first.
+     * Doubles so JS can pass and receive plain numbers.
+     */
+    void setUndoBudget(double bytes) { undoHistory.setBudget(static_cast<size_t>(std::max(0.0, bytes))); }
+    double getUndoMemory() const { return static_cast<double>(undoHistory.getMemoryUsage()); }
+
+    // 4. Progressive preview API for JS
+    /**
+     * @brief Builds (or brings up to date) the reduced copies used by renderPreview().
+     * Optional: the first preview builds them otherwise. Call it after loading an
+     * image to keep that cost out of the first drag.
+     */
+    void buildPyramid() { pyramid.update(originalBuffer.data()); }
+
+    /**
+     * @brief Like renderFrame(), but may run the effect on a reduced copy of the
+     * image and upscale the result into the lens. The level is the finest one
+     * whose estimated cost fits the preview budget (see setPreviewBudget).
+     */
+    void renderPreview(int mouseX, int mouseY, int radius, int effectId, float intensity) {
+        EffectStage stage;
+        stage.type = static_cast<EffectType>(effectId);
+        stage.params = makeLensParams(mouseX, mouseY, radius, intensity);
+        lastPreview = stage;
+        hasPreview = true;
+
+        int level = choosePreviewLevel(stage);
+        lastPreviewLevel = level;
+        auto start = std::chrono::steady_clock::now();
+        size_t processed = (level == 0) ? renderFull(stage) : renderReduced(stage, level);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Running estimate of the effect's cost per processed pixel
+        int index = static_cast<int>(stage.type);
+        if (processed > 0 && index >= 0 && index < kEffectTypeCount) {
+            double sample = ms / static_cast<double>(processed);
+            previewCost[index] = (previewCost[index] > 0) ? previewCost[index] * 0.75 + sample * 0.25 : sample;
+        }
+    }
+
+    /**
+     * @brief Renders the last preview again at full resolution (e.g. once input is idle).
+     * @return False if there was no preview, or it was already at full resolution.
+     */
+    bool refine() {
+        if (!hasPreview || lastPreviewLevel == 0) return false;
+        lastPreview.params.quality = quality;
+        lastPreview.params.frame = nextFrame;
+        renderEffects(&lastPreview, 1);
+        lastPreviewLevel = 0;
+        return true;
+    }
+
+    /**
+     * @brief Target time of a preview frame in milliseconds (default 12).
+     */
+    void setPreviewBudget(double ms) { previewBudgetMs = std::max(0.0, ms); }
+
+    /**
+     * @brief Forces the preview level (0 = full resolution); -1 restores the automatic choice.
+     */
+    void setPreviewLevel(int level) { forcedPreviewLevel = std::max(-1, level); }
+
+    /**
+     * @brief Level used by the last renderPreview (0 = full resolution, L = 1 / 2^L).
+     */
+    int getPreviewLevel() const { return lastPreviewLevel; }
+
+    // 5. Resumable rendering API for JS
+    /**
+     * @brief Starts a frame that step() renders in slices (same result as renderFrame).
+     * Supersedes a frame still in flight: what it drew is healed like any old frame.
+     * Any synchronous render, undo/redo or load also abandons the frame in flight.
+     */
+    void beginFrame(int mouseX, int mouseY, int radius, int effectId, float intensity) {
+        FrameStopwatch stopwatch;
+        jobSample = FrameSample();
+        ensureDisplay();
+
+        Region healed = lastDirty;
+        healRegion(healed);
+        pendingPresent = unionRegion(pendingPresent, healed);
+        lastDirty = {0, 0, 0, 0};
+        jobSample.healMs = stopwatch.lap();
+        if (!healed.isEmpty()) jobSample.bytesCopied = static_cast<uint64_t>(healed.width) * healed.height * sizeof(Pixel);
+
+        jobStage.type = static_cast<EffectType>(effectId);
+        jobStage.params = makeLensParams(mouseX, mouseY, radius, intensity);
+        SourceView source = SourceView::whole(originalBuffer.data(), width, height);
+        if (needsLuma(&jobStage, 1)) {
+            jobSample.bytesCopied += refreshLuma();
+            source.luma = lumaPlane.data();
+        }
+        if (needsIntegral(&jobStage, 1)) jobSample.bytesCopied += attachIntegral(source);
+        chain.begin(&jobStage, 1, source, ImageView::whole(displayBuffer.data(), width, height));
+        jobSample.setupMs = stopwatch.lap();
+
+        frameInFlight = true;
+        lastFrame = nextFrame++;
+    }
+
+    /**
+     * @brief Renders slices of the frame in flight until it completes or the budget
+     * runs out (at least one slice per call, so every call makes progress).
+     * getDirtyRect() then covers what changed since the previous step.
+     * @return True once the frame is complete (also when none is in flight).
+     */
+    bool step(double budgetMicros) {
+        presentRect = pendingPresent;
+        pendingPresent = {0, 0, 0, 0};
+        if (!frameInFlight) return true;
+
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        bool done = false;
+        while (!done) {
+            done = chain.step(scheduler);
+            Region slice = chain.getLastSlice();
+            lastDirty = unionRegion(lastDirty, slice);
+            presentRect = unionRegion(presentRect, slice);
+            elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= budgetMicros) break;
+        }
+        jobSample.applyMs += static_cast<float>(elapsed / 1000.0);
+
+        if (done) {
+            frameInFlight = false;
+            Region covered = lensRegion(jobStage.params, width, height);
+            if (!covered.isEmpty()) jobSample.pixels = static_cast<uint64_t>(covered.width) * covered.height;
+            frameStats.countStage(jobStage.type, covered);
+            frameStats.record(jobSample);
+        }
+        return done;
+    }
+
+    /**
+     * @brief True when no frame is in flight.
+     */
+    bool isComplete() const { return !frameInFlight; }
+
+    /**
+     * @brief Fraction of the frame in flight rendered so far (1 when complete).
+     */
+    double getProgress() const { return frameInFlight ? chain.getProgress() : 1.0; }
+
+    // 6. Effect chain API for JS
+    void clearChain() { chainStages.clear(); }
+
+    void addChainStage(int effectId, float intensity) {
+        EffectStage stage;
+        stage.type = static_cast<EffectType>(effectId);
+        stage.params = makeLensParams(0, 0, 0, intensity);
+        chainStages.push_back(stage);
+    }
+
+    /**
+     * @brief Renders the configured chain inside the lens around the mouse.
+     */
+    void renderChain(int mouseX, int mouseY, int radius) {
+        prepareChain(mouseX, mouseY, radius);
+        renderEffects(chainStages.data(), static_cast<int>(chainStages.size()));
+    }
+
+    /**
+     * @brief Renders the configured chain in linear light at 16-bit or float precision.
+     * The lens area of the original is decoded into 'linear' (which stores only
+     * that area), the stages run on it and the result is encoded back into the
+     * display, so stacked stages neither work on gamma-encoded values nor round
+     * to 8 bits in between.
+     * Only point-wise chains can run this way (EffectChain::isPointwise).
+     * @return False, without rendering, if a stage is not point-wise.
+     */
+    template <typename P>
+    bool renderChainLinear(int mouseX, int mouseY, int radius, LinearImage<P>& linear) {
+        const EffectStage* stages = chainStages.data();
+        int count = static_cast<int>(chainStages.size());
+        if (!chain.isPointwise(stages, count)) return false;
+
+        FrameStopwatch stopwatch;
+        FrameSample sample;
+        prepareChain(mouseX, mouseY, radius);
+        ensureDisplay();
+        cancelFrame();
+
+        Region healed = lastDirty;
+        healRegion(healed);
+        sample.healMs = stopwatch.lap();
+        if (!healed.isEmpty()) sample.bytesCopied = static_cast<uint64_t>(healed.width) * healed.height * sizeof(Pixel);
+
+        Region area = {0, 0, 0, 0};
+        for (int i = 0; i < count; ++i) area = unionRegion(area, lensRegion(stages[i].params, width, height));
+        linear.resize(area, width, height);
+        linear.decode(SourceView::whole(originalBuffer.data(), width, height), area);
+        if (!area.isEmpty()) sample.bytesCopied += static_cast<uint64_t>(area.width) * area.height * sizeof(P);
+        sample.setupMs = stopwatch.lap();
+
+        lastDirty = chain.runPointwise(scheduler, stages, count, linear.view());
+        linear.encode(lastDirty, ImageView::whole(displayBuffer.data(), width, height));
+        presentRect = unionRegion(healed, lastDirty);
+        sample.applyMs = stopwatch.lap();
+
+        for (int i = 0; i < count; ++i) {
+            Region covered = lensRegion(stages[i].params, width, height);
+            if (!covered.isEmpty()) sample.pixels += static_cast<uint64_t>(covered.width) * covered.height;
+            frameStats.countStage(stages[i].type, covered);
+        }
+        frameStats.record(sample);
+
+        lastFrame = nextFrame++;
+        return true;
+    }
+
+private:
+    /**
+     * @brief Writes the lens and the render settings into every chain stage.
+     */
+    void prepareChain(int mouseX, int mouseY, int radius) {
+        for (EffectStage& stage : chainStages) {
+            stage.params.centerX = mouseX;
+            stage.params.centerY = mouseY;
+            stage.params.radius = radius;
+            stage.params.feather = lensFeather;
+            stage.params.linearEdge = linearEdges;
+            stage.params.quality = quality;
+            stage.params.seed = seed;
+            stage.params.frame = nextFrame;
+        }
+    }
+
+
+    /**
+     * @brief Shows an undo/redo change: heals the changed area into the display.
+     */
+    bool applyHistory(const Region& changed) {
+        if (changed.isEmpty()) return false;
+        ensureDisplay();
+        cancelFrame();
+        healRegion(changed);
+        markOriginalChanged(changed);
+        presentRect = changed;
+        return true;
+    }
+
+    /**
+     * @brief Abandons the frame in flight. lastDirty already covers what it drew;
+     * the area healed but not yet presented is added so the next frame reports it.
+     */
+    void cancelFrame() {
+        if (!frameInFlight) return;
+        frameInFlight = false;
+        chain.cancel();
+        lastDirty = unionRegion(lastDirty, pendingPresent);
+        pendingPresent = {0, 0, 0, 0};
+    }
+
+    /**
+     * @brief Finest pyramid level whose estimated cost fits the preview budget.
+     * Without a measurement yet, starts where the lens box is about 256 x 256.
+     */
+    int choosePreviewLevel(const EffectStage& stage) const {
+        int levels = pyramid.getLevelCount();
+        if (forcedPreviewLevel >= 0) return std::min(forcedPreviewLevel, levels - 1);
+
+        Region box = lensRegion(stage.params, width, height);
+        double area = static_cast<double>(box.width) * box.height;
+        int index = static_cast<int>(stage.type);
+        double cost = (index >= 0 && index < kEffectTypeCount) ? previewCost[index] : 0;
+
+        int level = 0;
+        if (cost <= 0) {
+            while (level + 1 < levels && area / (1 << (2 * level)) > 65536) level++;
+            return level;
+        }
+        while (level + 1 < levels && cost * area / (1 << (2 * level)) > previewBudgetMs) level++;
+        return level;
+    }
+
+    /**
+     * @brief Full-resolution render used by previews at level 0.
+     * @return Lens-box pixels processed.
+     */
+    size_t renderFull(const EffectStage& stage) {
+        renderEffects(&stage, 1);
+        return lastDirty.isEmpty() ? 0 : static_cast<size_t>(lastDirty.width) * lastDirty.height;
+    }
+
+    /**
+     * @brief Runs the effect on pyramid level L (lens and pixel lengths scaled by 1 / 2^L) and
+     * upscales the result (nearest) into the full-resolution lens of the display.
+     * Frame statistics count the level pixels, since that is the work done.
+     * @return Level pixels processed.
+     */
+    size_t renderReduced(const EffectStage& stage, int level) {
+        FrameStopwatch stopwatch;
+        FrameSample sample;
+        ensureDisplay();
+        cancelFrame();
+
+        Region healed = lastDirty;
+        healRegion(healed);
+        sample.healMs = stopwatch.lap();
+        if (!healed.isEmpty()) sample.bytesCopied = static_cast<uint64_t>(healed.width) * healed.height * sizeof(Pixel);
+
+        sample.bytesCopied += pyramid.update(originalBuffer.data()) * sizeof(Pixel);
+        Region full = lensRegion(stage.params, width, height);
+        lastDirty = full;
+        presentRect = unionRegion(healed, full);
+        if (full.isEmpty()) {
+            frameStats.record(sample);
+            return 0;
+        }
+
+        // Same lens in level coordinates (rounded outwards), and pixel lengths in the parameters
+        int scale = 1 << level;
+        int lw = pyramid.getWidth(level), lh = pyramid.getHeight(level);
+        EffectStage reduced = stage;
+        reduced.params.centerX = floorDiv(stage.params.centerX, scale);
+        reduced.params.centerY = floorDiv(stage.params.centerY, scale);
+        reduced.params.radius = (stage.params.radius + scale - 1) / scale;
+        reduced.params.feather = stage.params.feather / scale;
+        IEffect* effect = chain.getEffect(stage.type);
+        if (effect) effect->scaleParams(reduced.params, 1.0f / scale);
+
+        // The chain expects a clean destination inside the lens
+        previewBuffer.resize(static_cast<size_t>(lw) * lh);
+        Region box = lensRegion(reduced.params, lw, lh);
+        const Pixel* levelPixels = pyramid.data(level);
+        for (int y = box.y; y < box.y + box.height; ++y) {
+            size_t offset = static_cast<size_t>(y) * lw + box.x;
+            std::memcpy(previewBuffer.data() + offset, levelPixels + offset, box.width * sizeof(Pixel));
+        }
+        if (!box.isEmpty()) sample.bytesCopied += static_cast<uint64_t>(box.width) * box.height * sizeof(Pixel);
+        sample.setupMs = stopwatch.lap();
+
+        SourceView source = SourceView::whole(levelPixels, lw, lh);
+        ImageView dest = ImageView::whole(previewBuffer.data(), lw, lh);
+        chain.run(scheduler, &reduced, 1, source, dest);
+
+        previewMask.update(stage.params, full);
+        for (int y = full.y; y < full.y + full.height; ++y) {
+            int x0, x1;
+            if (!previewMask.span(y, x0, x1)) continue;
+            const Pixel* from = previewBuffer.data() + static_cast<size_t>(std::min(y >> level, lh - 1)) * lw;
+            Pixel* to = displayBuffer.data() + static_cast<size_t>(y) * width;
+            for (int x = x0; x < x1; ++x) to[x] = from[std::min(x >> level, lw - 1)];
+        }
+        previewMask.blendEdge(SourceView::whole(originalBuffer.data(), width, height),
+                              ImageView::whole(displayBuffer.data(), width, height));
+        sample.applyMs = stopwatch.lap();
+
+        sample.pixels = box.isEmpty() ? 0 : static_cast<uint64_t>(box.width) * box.height;
+        frameStats.countStage(stage.type, box);
+        frameStats.record(sample);
+
+        lastFrame = nextFrame++;
+        return static_cast<size_t>(sample.pixels);
+    }
+
+    static int floorDiv(int value, int divisor) {
+        return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    bool needsLuma(const EffectStage* stages, int count) {
+        for (int i = 0; i < count; ++i) {
+            IEffect* effect = chain.getEffect(stages[i].type);
+            if (effect && effect->usesLuma()) return true;
+        }
+        return false;
+    }
+
+    bool needsIntegral(const EffectStage* stages, int count) {
+        for (int i = 0; i < count; ++i) {
+            IEffect* effect = chain.getEffect(stages[i].type);
+            if (effect && effect->usesIntegral()) return true;
+        }
+        return false;
+    }
+
+    EffectParams makeLensParams(int mouseX, int mouseY, int radius, float intensity) const {
         EffectParams params;
         params.intensity = intensity;
         params.useCircleMask = true; // Always bubble mode for interaction
         params.centerX = mouseX;
         params.centerY = mouseY;
         params.radius = radius;
-
-        // Step D: Execute
-        effect->apply(displayBuffer, width, height, region, params);
+        params.feather = lensFeather;
+        params.linearEdge = linearEdges;
+        params.quality = quality;
+        params.seed = seed;
+        params.frame = nextFrame;
+        return params;
     }
-};
\ No newline at end of file
+};
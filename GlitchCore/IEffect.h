@@ -1,7 +1,22 @@
 #pragma once
 #include "Common.h"
+#include "LensMask.h"
 #include <vector>
 
+class PointwiseEffect;
+
+/**
+ * @enum Parallelism
+ * @brief How the region of an effect may be split across worker threads.
+ * Sources are read-only, so reading a halo around a band is always safe; what
+ * matters is that bands never write the same pixels or share mutable state.
+ */
+enum class Parallelism {
+    Rows,    // Horizontal bands of the region can be rendered independently
+    Columns, // Vertical bands of the region can be rendered independently
+    Serial   // Must run as one task (e.g. draws from shared random state)
+};
+
 /**
  * @interface IEffect
  * @brief Interface (Strategy Pattern) that all glitch effects must implement.
@@ -11,23 +26,171 @@ public:
     virtual ~IEffect() = default;
 
     /**
-     * @brief Applies the effect to the buffer within the specified region.
+     * @brief Applies the effect reading from a clean source and writing into dest.
+     * This is the engine's path: the source is normally the original image, so no
+     * copy is needed at all.
+     * @param source Read-only input. Must cover the dirty bounds grown by getHaloSize().
+     * @param dest Output buffer. May alias source only if supportsInPlace() is true.
+     * @param region The bounding box to process (optimization).
+     * @param params Configuration parameters (intensity, mask, etc).
+     */
+    void apply(const SourceView& source, const ImageView& dest,
+               const Region& region, const EffectParams& params) {
+        lensMask.update(params, region);
+        render(source, dest, region, params);
+        lensMask.blendEdge(source, dest);
+    }
+
+    /**
+     * @brief Applies the effect to the buffer within the specified region, in place.
+     * Effects that read neighbours render from a snapshot of the region plus
+     * halo, so the copy scales with the lens area rather than the image size.
      * * @param data The entire image buffer (read/write).
      * @param imgWidth Total width of the image.
      * @param imgHeight Total height of the image.
      * @param region The bounding box to process (optimization).
      * @param params Configuration parameters (intensity, mask, etc).
      */
-    virtual void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight, 
-                       const Region& region, const EffectParams& params) = 0;
+    void apply(std::vector<Pixel>& data, int imgWidth, int imgHeight,
+               const Region& region, const EffectParams& params) {
+        applyInPlace(ImageView::whole(data.data(), imgWidth, imgHeight), region, params);
+    }
+
+    /**
+     * @brief View-based variant of the in-place apply (used by effect chains).
+     */
+    void applyInPlace(const ImageView& data, const Region& region, const EffectParams& params) {
+        apply(prepareSource(data, region, params), data, region, params);
+    }
+
+    /**
+     * @brief Returns a source for rendering in place over data.
+     * Either data itself (in-place safe effects without a soft edge) or a
+     * snapshot of the dirty bounds plus halo held in this effect's scratch.
+     * The view stays valid until the next call on this instance.
+     */
+    SourceView prepareSource(const ImageView& data, const Region& region, const EffectParams& params) {
+        // A soft edge blends with the input, so the input must survive the render
+        if (supportsInPlace() && !(params.useCircleMask && params.feather > 0)) return asSource(data);
+        return snapshot(data, region, params);
+    }
+
+    /**
+     * @brief Returns the area this effect may write to for a given region.
+     * Most effects stay inside the region; block-based effects override this
+     * because their last row/column of blocks can spill past the far edges.
+     * The engine clips the result to the image and uses it as the dirty rect.
+     */
+    virtual Region getDirtyBounds(const Region& region, const EffectParams& params) const {
+        return region;
+    }
+
+    /**
+     * @brief Maximum distance (in pixels) between a written pixel and any pixel it reads.
+     * Sizes the snapshot taken for in-place rendering.
+     */
+    virtual int getHaloSize(const EffectParams& params) const { return 0; }
+
+    /**
+     * @brief True if every written pixel only depends on source pixels the effect
+     * has already read before writing, so source and dest may be the same buffer.
+     */
+    virtual bool supportsInPlace() const { return false; }
+
+    /**
+     * @brief True if the effect reads luminance, so the engine should attach its
+     * cached luma plane to the source (SourceView::luma) when it can.
+     */
+    virtual bool usesLuma() const { return false; }
+
+    /**
+     * @brief True if the effect averages rectangles, so the engine should attach
+     * its summed-area table of the original (SourceView::integral) when it can.
+     */
+    virtual bool usesIntegral() const { return false; }
+
+    /**
+     * @brief How the region may be split into bands for multithreaded rendering.
+     */
+    virtual Parallelism getParallelism() const { return Parallelism::Rows; }
+
+    /**
+     * @brief True if rendering a band of the region only reads that band grown
+     * by getHaloSize(). Effects whose reads span the whole lens (the halo is then
+     * relative to the full region) return false, so out-of-core rendering hands
+     * them the complete lens as source.
+     */
+    virtual bool isBandLocal() const { return true; }
+
+    /**
+     * @brief Band sizes (rows or columns) must be multiples of this, measured
+     * from the region origin. Block-based effects return their block size so a
+     * block never straddles two bands.
+     */
+    virtual int getBandAlignment(const EffectParams& params) const { return 1; }
+
+    /**
+     * @brief Adapts the parameters to the image scaled by 'scale' (0.5 on pyramid
+     * level 1), so a reduced preview looks like the full render downsampled.
+     * The caller scales the lens; effects whose intensity is a length in pixels
+     * (offsets, radii, block sizes) scale it too.
+     */
+    virtual void scaleParams(EffectParams& params, float scale) const {}
+
+    /**
+     * @brief Makes this instance use the caches of 'primary', an instance of the
+     * same type. Multithreaded renderers call it on every worker's instance with
+     * worker 0's, so caches that do not depend on the band (displacement fields)
+     * are built and held once rather than once per thread.
+     */
+    virtual void shareCaches(IEffect& primary) {}
+
+    /**
+     * @brief Returns this effect as a point-wise effect, or nullptr.
+     * Point-wise effects can be fused with their neighbours in an effect chain.
+     */
+    virtual PointwiseEffect* asPointwise() { return nullptr; }
 
 protected:
-    // Helper to check if a pixel is inside the circular bubble
-    bool isInsideBubble(int x, int y, const EffectParams& params) {
-        if (!params.useCircleMask) return true; // Full image mode
-        
-        int dx = x - params.centerX;
-        int dy = y - params.centerY;
-        return (dx * dx + dy * dy) <= (params.radius * params.radius);
+    /**
+     * @brief Effect implementation. Reads only from source, writes only to dest.
+     */
+    virtual void render(const SourceView& source, const ImageView& dest,
+                        const Region& region, const EffectParams& params) = 0;
+
+    /**
+     * @brief Reusable scratch storage owned by the effect instance.
+     * Effects live for the whole engine lifetime (see EffectRegistry), so once
+     * the scratch has grown to the working size, later frames never reallocate.
+     */
+    std::vector<Pixel> scratch;
+
+    /**
+     * @brief Copies the dirty bounds plus halo out of the buffer into scratch.
+     * @return A read-only view of the copy, addressed in image coordinates.
+     */
+    SourceView snapshot(const ImageView& data, const Region& region, const EffectParams& params) {
+        Region dirty = getDirtyBounds(region, params);
+        int halo = getHaloSize(params);
+        Region area = clipRegion({dirty.x - halo, dirty.y - halo, dirty.width + 2 * halo, dirty.height + 2 * halo},
+                                 data.width, data.height);
+
+        size_t count = static_cast<size_t>(area.width) * area.height;
+        if (scratch.size() < count) scratch.resize(count);
+
+        for (int y = 0; y < area.height; ++y) {
+            const Pixel* row = &data.at(area.x, area.y + y);
+            std::copy(row, row + area.width, scratch.begin() + static_cast<size_t>(y) * area.width);
+        }
+        return {scratch.data(), area.width, area, data.width, data.height};
     }
-};
\ No newline at end of file
+
+    /**
+     * @brief Lens shape for the current apply() call, as row spans.
+     * Effects iterate mask().span(y) instead of testing every pixel.
+     */
+    const LensMask& mask() const { return lensMask; }
+
+private:
+    LensMask lensMask;
+};
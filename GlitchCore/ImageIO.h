@@ -0,0 +1,332 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include "Common.h"
+
+/**
+ * @enum ImageFormat
+ * @brief Still-image file formats read and written by the native tools.
+ */
+enum class ImageFormat {
+    Unknown,
+    PPM, // Binary PPM (P6), 8 bit; written without alpha
+    PAM, // PAM (P7): GRAYSCALE, GRAYSCALE_ALPHA, RGB or RGB_ALPHA, 8 bit; written as RGB_ALPHA
+    QOI  // Quite OK Image format, RGB or RGBA
+};
+
+/**
+ * @brief Format from a file extension (.ppm, .pam, .qoi; case-insensitive).
+ */
+inline ImageFormat imageFormatFromPath(const std::string& path) {
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return ImageFormat::Unknown;
+    std::string ext = path.substr(dot + 1);
+    for (char& c : ext) c = static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+    if (ext == "ppm") return ImageFormat::PPM;
+    if (ext == "pam") return ImageFormat::PAM;
+    if (ext == "qoi") return ImageFormat::QOI;
+    return ImageFormat::Unknown;
+}
+
+/**
+ * @class ImageCodec
+ * @brief In-memory decoder/encoder for PPM, PAM and QOI.
+ *
+ * Decoding is split in two so callers can size (or reuse) the destination
+ * first: readHeader() validates the file and returns its size, decode()
+ * writes width * height RGBA pixels. encode() appends to a caller-owned byte
+ * vector, so a worker that keeps its vectors does not allocate per image once
+ * they have grown to the largest size seen.
+ */
+class ImageCodec {
+public:
+    /**
+     * @brief Parses the header of an encoded image.
+     * @return false if the data is not a supported image of that format.
+     */
+    static bool readHeader(const uint8_t* data, size_t size, ImageFormat format, int& width, int& height) {
+        Layout layout;
+        if (!parse(data, size, format, layout)) return false;
+        width = layout.width;
+        height = layout.height;
+        return true;
+    }
+
+    /**
+     * @brief Decodes an image into out (width * height pixels, as given by readHeader).
+     * @return false if the data is truncated or malformed.
+     */
+    static bool decode(const uint8_t* data, size_t size, ImageFormat format, Pixel* out) {
+        Layout layout;
+        if (!parse(data, size, format, layout)) return false;
+        if (format == ImageFormat::QOI) return decodeQoi(data + layout.offset, size - layout.offset, layout, out);
+
+        size_t pixels = static_cast<size_t>(layout.width) * layout.height;
+        if (size - layout.offset < pixels * layout.channels) return false;
+        const uint8_t* in = data + layout.offset;
+        for (size_t i = 0; i < pixels; ++i, in += layout.channels) {
+            switch (layout.channels) {
+                case 1: out[i] = {in[0], in[0], in[0], 255}; break;
+                case 2: out[i] = {in[0], in[0], in[0], in[1]}; break;
+                case 3: out[i] = {in[0], in[1], in[2], 255}; break;
+                default: out[i] = {in[0], in[1], in[2], in[3]}; break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Encodes width * height pixels, replacing the contents of out.
+     */
+    static void encode(const Pixel* pixels, int width, int height, ImageFormat format, std::vector<uint8_t>& out) {
+        out.clear();
+        size_t count = static_cast<size_t>(width) * height;
+        if (format == ImageFormat::QOI) {
+            encodeQoi(pixels, width, height, out);
+            return;
+        }
+
+        std::string header = (format == ImageFormat::PPM)
+            ? "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n"
+            : "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height) +
+              "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+        int channels = (format == ImageFormat::PPM) ? 3 : 4;
+        out.resize(header.size() + count * channels);
+        std::memcpy(out.data(), header.data(), header.size());
+
+        uint8_t* dst = out.data() + header.size();
+        if (channels == 4) {
+            std::memcpy(dst, pixels, count * sizeof(Pixel));
+            return;
+        }
+        for (size_t i = 0; i < count; ++i, dst += 3) {
+            dst[0] = pixels[i].r;
+            dst[1] = pixels[i].g;
+            dst[2] = pixels[i].b;
+        }
+    }
+
+    /**
+     * @brief Whether an image of this size can be decoded: both sides within
+     * kMaxDimension and width * height RGBA pixels addressable in maxBytes.
+     * With the default, 32768 x 32768 is accepted on 64-bit targets but not on
+     * 32-bit ones (wasm32), where its 4 GB would wrap size_t to 0.
+     */
+    static bool validSize(int width, int height, size_t maxBytes = std::numeric_limits<size_t>::max()) {
+        if (width <= 0 || height <= 0 || width > kMaxDimension || height > kMaxDimension) return false;
+        return static_cast<size_t>(width) <= maxBytes / sizeof(Pixel) / static_cast<size_t>(height);
+    }
+
+private:
+    // Largest accepted image side; the total size is checked separately (validSize)
+    static constexpr int kMaxDimension = 1 << 15;
+
+    struct Layout {
+        int width = 0;
+        int height = 0;
+        int channels = 0;  // Bytes per pixel in the file (PPM/PAM)
+        size_t offset = 0; // First byte after the header
+    };
+
+    // --- Netpbm ---
+
+    struct Cursor {
+        const uint8_t* data;
+        size_t size;
+        size_t pos;
+
+        void skipSpaceAndComments() {
+            while (pos < size) {
+                if (data[pos] == '#') {
+                    while (pos < size && data[pos] != '\n') ++pos;
+                } else if (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r' || data[pos] == '\n') {
+                    ++pos;
+                } else {
+                    return;
+                }
+            }
+        }
+
+        bool number(int& value) {
+            skipSpaceAndComments();
+            if (pos >= size || data[pos] < '0' || data[pos] > '9') return false;
+            long long v = 0;
+            while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+                v = v * 10 + (data[pos++] - '0');
+                if (v > (1 << 30)) return false;
+            }
+            value = static_cast<int>(v);
+            return true;
+        }
+
+        std::string word() {
+            skipSpaceAndComments();
+            size_t start = pos;
+            while (pos < size && data[pos] > ' ') ++pos;
+            return std::string(reinterpret_cast<const char*>(data + start), pos - start);
+        }
+    };
+
+    static bool parse(const uint8_t* data, size_t size, ImageFormat format, Layout& layout) {
+        if (format == ImageFormat::QOI) return parseQoi(data, size, layout);
+        if (size < 3 || data[0] != 'P') return false;
+
+        Cursor cursor = {data, size, 2};
+        if (format == ImageFormat::PPM) {
+            int maxval = 0;
+            if (data[1] != '6' || !cursor.number(layout.width) || !cursor.number(layout.height) || !cursor.number(maxval)) return false;
+            if (maxval != 255 || cursor.pos >= size) return false;
+            layout.channels = 3;
+            layout.offset = cursor.pos + 1; // Single whitespace after maxval
+            return validSize(layout.width, layout.height);
+        }
+
+        if (format != ImageFormat::PAM || data[1] != '7') return false;
+        int maxval = 0;
+        std::string tupleType;
+        for (;;) {
+            std::string key = cursor.word();
+            if (key.empty()) return false;
+            if (key == "ENDHDR") break;
+            if (key == "WIDTH") { if (!cursor.number(layout.width)) return false; }
+            else if (key == "HEIGHT") { if (!cursor.number(layout.height)) return false; }
+            else if (key == "DEPTH") { if (!cursor.number(layout.channels)) return false; }
+            else if (key == "MAXVAL") { if (!cursor.number(maxval)) return false; }
+            else if (key == "TUPLTYPE") tupleType = cursor.word();
+            else return false;
+        }
+        while (cursor.pos < size && data[cursor.pos] != '\n') ++cursor.pos;
+        layout.offset = cursor.pos + 1;
+        return maxval == 255 && layout.channels >= 1 && layout.channels <= 4 && layout.offset <= size &&
+               validSize(layout.width, layout.height);
+    }
+
+    // --- QOI (https://qoiformat.org/qoi-specification.pdf) ---
+
+    static constexpr uint8_t kOpIndex = 0x00, kOpDiff = 0x40, kOpLuma = 0x80, kOpRun = 0xc0;
+    static constexpr uint8_t kOpRgb = 0xfe, kOpRgba = 0xff, kMask2 = 0xc0;
+    static constexpr size_t kQoiHeaderSize = 14;
+    static constexpr uint8_t kQoiEnd[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+    static int qoiHash(const Pixel& p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64; }
+
+    static uint32_t readBE32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    static void writeBE32(std::vector<uint8_t>& out, uint32_t v) {
+        out.push_back(static_cast<uint8_t>(v >> 24));
+        out.push_back(static_cast<uint8_t>(v >> 16));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    static bool parseQoi(const uint8_t* data, size_t size, Layout& layout) {
+        if (size < kQoiHeaderSize + sizeof(kQoiEnd) || std::memcmp(data, "qoif", 4) != 0) return false;
+        uint32_t w = readBE32(data + 4), h = readBE32(data + 8);
+        if (w > kMaxDimension || h > kMaxDimension || (data[12] != 3 && data[12] != 4)) return false;
+        layout.width = static_cast<int>(w);
+        layout.height = static_cast<int>(h);
+        layout.channels = data[12];
+        layout.offset = kQoiHeaderSize;
+        return validSize(layout.width, layout.height);
+    }
+
+    static bool decodeQoi(const uint8_t* in, size_t size, const Layout& layout, Pixel* out) {
+        Pixel index[64] = {};
+        Pixel px = {0, 0, 0, 255};
+        size_t pixels = static_cast<size_t>(layout.width) * layout.height;
+        size_t pos = 0;
+        size_t end = size - sizeof(kQoiEnd);
+
+        for (size_t i = 0; i < pixels;) {
+            if (pos >= end) return false;
+            uint8_t b1 = in[pos++];
+            int run = 1;
+
+            if (b1 == kOpRgb || b1 == kOpRgba) {
+                size_t bytes = (b1 == kOpRgb) ? 3 : 4;
+                if (pos + bytes > end) return false;
+                px.r = in[pos]; px.g = in[pos + 1]; px.b = in[pos + 2];
+                if (b1 == kOpRgba) px.a = in[pos + 3];
+                pos += bytes;
+            } else if ((b1 & kMask2) == kOpIndex) {
+                px = index[b1];
+            } else if ((b1 & kMask2) == kOpDiff) {
+                px.r = static_cast<uint8_t>(px.r + ((b1 >> 4) & 3) - 2);
+                px.g = static_cast<uint8_t>(px.g + ((b1 >> 2) & 3) - 2);
+                px.b = static_cast<uint8_t>(px.b + (b1 & 3) - 2);
+            } else if ((b1 & kMask2) == kOpLuma) {
+                if (pos >= end) return false;
+                uint8_t b2 = in[pos++];
+                int vg = (b1 & 0x3f) - 32;
+                px.r = static_cast<uint8_t>(px.r + vg - 8 + ((b2 >> 4) & 0x0f));
+                px.g = static_cast<uint8_t>(px.g + vg);
+                px.b = static_cast<uint8_t>(px.b + vg - 8 + (b2 & 0x0f));
+            } else {
+                run = (b1 & 0x3f) + 1;
+            }
+
+            index[qoiHash(px)] = px;
+            for (size_t n = std::min(pixels - i, static_cast<size_t>(run)); n > 0; --n) out[i++] = px;
+        }
+        return true;
+    }
+
+    static void encodeQoi(const Pixel* pixels, int width, int height, std::vector<uint8_t>& out) {
+        size_t count = static_cast<size_t>(width) * height;
+        out.reserve(kQoiHeaderSize + count * 5 + sizeof(kQoiEnd)); // Worst case: every pixel QOI_OP_RGBA
+
+        out.insert(out.end(), {'q', 'o', 'i', 'f'});
+        writeBE32(out, static_cast<uint32_t>(width));
+        writeBE32(out, static_cast<uint32_t>(height));
+        out.push_back(4); // Channels
+        out.push_back(0); // sRGB with linear alpha
+
+        Pixel index[64] = {};
+        Pixel prev = {0, 0, 0, 255};
+        int run = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const Pixel& px = pixels[i];
+            if (std::memcmp(&px, &prev, sizeof(Pixel)) == 0) {
+                if (++run == 62 || i + 1 == count) {
+                    out.push_back(static_cast<uint8_t>(kOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out.push_back(static_cast<uint8_t>(kOpRun | (run - 1)));
+                run = 0;
+            }
+
+            int hash = qoiHash(px);
+            if (std::memcmp(&index[hash], &px, sizeof(Pixel)) == 0) {
+                out.push_back(static_cast<uint8_t>(kOpIndex | hash));
+            } else {
+                index[hash] = px;
+                if (px.a == prev.a) {
+                    int vr = static_cast<int8_t>(px.r - prev.r);
+                    int vg = static_cast<int8_t>(px.g - prev.g);
+                    int vb = static_cast<int8_t>(px.b - prev.b);
+                    int vgr = vr - vg, vgb = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        out.push_back(static_cast<uint8_t>(kOpDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                    } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                        out.push_back(static_cast<uint8_t>(kOpLuma | (vg + 32)));
+                        out.push_back(static_cast<uint8_t>((vgr + 8) << 4 | (vgb + 8)));
+                    } else {
+                        out.insert(out.end(), {kOpRgb, px.r, px.g, px.b});
+                    }
+                } else {
+                    out.insert(out.end(), {kOpRgba, px.r, px.g, px.b, px.a});
+                }
+            }
+            prev = px;
+        }
+        out.insert(out.end(), kQoiEnd, kQoiEnd + sizeof(kQoiEnd));
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include "Common.h"
+#include "Srgb.h"
+
+/**
+ * @class LensMask
+ * @brief Row-span representation of the circular lens, shared by all effects.
+ *
+ * For every row the mask stores the contiguous run [x0, x1) inside the circle,
+ * so effects loop over spans instead of testing each pixel. The span table
+ * only depends on (radius, feather) relative to the center, so it is cached and
+ * simply translated when the lens moves; it is rebuilt when either changes.
+ *
+ * With a feather width > 0 the outer 'feather' pixels of the lens get a partial
+ * coverage in 1/256 steps (256 = fully inside). The inner span is the part
+ * of each row with full coverage; the rest of the span is the soft edge.
+ * The edge is mixed in sRGB by default, or in linear light (EffectParams::linearEdge),
+ * which keeps it from darkening between contrasting colors.
+ */
+class LensMask {
+public:
+    static constexpr int kFullCoverage = 256;
+
+    /**
+     * @brief Prepares the mask for a frame. Cheap when radius/feather are unchanged.
+     */
+    void update(const EffectParams& params, const Region& area) {
+        region = area;
+        circle = params.useCircleMask;
+        centerX = params.centerX;
+        centerY = params.centerY;
+        linear = params.linearEdge;
+        if (!circle) return;
+
+        int radius = std::max(0, params.radius);
+        int soft = std::max(0, std::min(params.feather, radius));
+        if (radius != cachedRadius || soft != cachedFeather) build(radius, soft);
+    }
+
+    bool hasFeather() const { return circle && cachedFeather > 0; }
+
+    /**
+     * @brief Run of row y that lies inside the lens (and inside the region).
+     * @return false if the row does not intersect the lens.
+     */
+    bool span(int y, int& x0, int& x1) const {
+        if (y < region.y || y >= region.y + region.height) return false;
+        x0 = region.x;
+        x1 = region.x + region.width;
+        if (circle) {
+            int dy = std::abs(y - centerY);
+            if (dy > cachedRadius) return false;
+            x0 = std::max(x0, centerX - half[dy]);
+            x1 = std::min(x1, centerX + half[dy] + 1);
+        }
+        return x0 < x1;
+    }
+
+    /**
+     * @brief Part of span(y) with full coverage. Equal to span(y) without feathering.
+     */
+    bool innerSpan(int y, int& x0, int& x1) const {
+        if (!span(y, x0, x1)) return false;
+        if (!hasFeather()) return true;
+        int inner = innerHalf[std::abs(y - centerY)];
+        if (inner < 0) return false;
+        x0 = std::max(x0, centerX - inner);
+        x1 = std::min(x1, centerX + inner + 1);
+        return x0 < x1;
+    }
+
+    /**
+     * @brief Run of column x inside the lens: [y0, y1). The circle is symmetric,
+     * so the row table doubles as the column table.
+     */
+    bool columnSpan(int x, int& y0, int& y1) const {
+        if (x < region.x || x >= region.x + region.width) return false;
+        y0 = region.y;
+        y1 = region.y + region.height;
+        if (circle) {
+            int dx = std::abs(x - centerX);
+            if (dx > cachedRadius) return false;
+            y0 = std::max(y0, centerY - half[dx]);
+            y1 = std::min(y1, centerY + half[dx] + 1);
+        }
+        return y0 < y1;
+    }
+
+    bool contains(int x, int y) const {
+        int x0, x1;
+        return span(y, x0, x1) && x >= x0 && x < x1;
+    }
+
+    /**
+     * @brief Coverage of a pixel inside span(y), from 0 to kFullCoverage.
+     */
+    int coverage(int x, int y) const {
+        if (!hasFeather()) return kFullCoverage;
+        int dy = std::abs(y - centerY);
+        int dx = std::abs(x - centerX);
+        if (dy > cachedRadius || dx > half[dy]) return 0;
+        if (dx <= innerHalf[dy]) return kFullCoverage;
+        return edge[edgeOffset[dy] + dx - innerHalf[dy] - 1];
+    }
+
+    /**
+     * @brief Blends the soft edge of every row: dest = source + (dest - source) * coverage.
+     * Called after an effect has rendered the full span into dest.
+     */
+    void blendEdge(const SourceView& source, const ImageView& dest) const {
+        if (!hasFeather()) return;
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1, i0, i1;
+            if (!span(y, x0, x1)) continue;
+            if (!innerSpan(y, i0, i1)) i0 = i1 = x1;
+            blendRow(&source.at(x0, y), &dest.at(x0, y), &dest.at(x0, y), x0, y, i0 - x0);
+            int e0 = std::max(i1, i0);
+            blendRow(&source.at(e0, y), &dest.at(e0, y), &dest.at(e0, y), e0, y, x1 - e0);
+        }
+    }
+
+    /**
+     * @brief out[i] = mix of from[i] and to[i] by the coverage of (x0 + i, y).
+     * 'out' may be either input. The color space is chosen once per row.
+     */
+    void blendRow(const Pixel* from, const Pixel* to, Pixel* out, int x0, int y, int count) const {
+        if (linear) blendRowLinear(from, to, out, x0, y, count);
+        else blendRow<Pixel>(from, to, out, x0, y, count);
+    }
+
+    /**
+     * @brief Same for 16-bit or float rows, mixed in the space they are stored in
+     * (linear light when decoded with Srgb.h).
+     */
+    template <typename P>
+    void blendRow(const P* from, const P* to, P* out, int x0, int y, int count) const {
+        for (int i = 0; i < count; ++i) out[i] = mixPixels(from[i], to[i], coverage(x0 + i, y));
+    }
+
+    // Integer mix of two pixels: coverage 0 returns a, kFullCoverage returns b
+    static Pixel blend(Pixel a, Pixel b, int cov) { return mixPixels(a, b, cov); }
+
+    // Same mix in 16-bit linear light (one pixel of blendRow with linear edges)
+    static Pixel blendLinear(Pixel a, Pixel b, int cov) {
+        Pixel out;
+        blendRowLinearWith(&a, &b, &out, 1, [cov](int) { return cov; });
+        return out;
+    }
+
+private:
+    Region region = {0, 0, 0, 0};
+    bool circle = false;
+    bool linear = false;
+    int centerX = 0;
+    int centerY = 0;
+
+    // Span tables relative to the center, indexed by |dy|
+    int cachedRadius = -1;
+    int cachedFeather = -1;
+    std::vector<int> half;       // Outer half-width: |dx| <= half[dy] is inside
+    std::vector<int> innerHalf;  // Full-coverage half-width (-1 if none)
+    std::vector<int> edgeOffset; // Start of each row's edge coverage in 'edge'
+    std::vector<uint16_t> edge;  // Coverage of dx = innerHalf+1 .. half
+
+    void build(int radius, int soft) {
+        cachedRadius = radius;
+        cachedFeather = soft;
+        half.resize(radius + 1);
+        innerHalf.resize(radius + 1);
+        edgeOffset.resize(radius + 1);
+        edge.clear();
+
+        long long r2 = static_cast<long long>(radius) * radius;
+        long long inner = radius - soft;
+        for (int dy = 0; dy <= radius; ++dy) {
+            long long dy2 = static_cast<long long>(dy) * dy;
+            half[dy] = static_cast<int>(isqrt(r2 - dy2));
+            innerHalf[dy] = (dy <= inner) ? static_cast<int>(isqrt(inner * inner - dy2)) : -1;
+            if (soft == 0) continue;
+
+            edgeOffset[dy] = static_cast<int>(edge.size());
+            for (int dx = innerHalf[dy] + 1; dx <= half[dy]; ++dx) {
+                double dist = std::sqrt(static_cast<double>(dx) * dx + dy2);
+                int cov = static_cast<int>((radius - dist) * kFullCoverage / soft + 0.5);
+                edge.push_back(static_cast<uint16_t>(std::max(0, std::min(kFullCoverage, cov))));
+            }
+        }
+    }
+
+    static constexpr int kLinearChunk = 64; // Pixels decoded per batch (2 KB of stack)
+
+    void blendRowLinear(const Pixel* from, const Pixel* to, Pixel* out, int x0, int y, int count) const {
+        blendRowLinearWith(from, to, out, count, [&](int i) { return coverage(x0 + i, y); });
+    }
+
+    // Decodes both inputs in chunks, mixes them in linear light and encodes the
+    // chunk back, so the tables are looked up once per chunk rather than per pixel.
+    // A chunk is read completely before it is written, so 'out' may alias an input.
+    template <typename Coverage>
+    static void blendRowLinearWith(const Pixel* from, const Pixel* to, Pixel* out, int count, Coverage cov) {
+        Pixel16 a[kLinearChunk], b[kLinearChunk];
+        for (int start = 0; start < count; start += kLinearChunk) {
+            int n = std::min(kLinearChunk, count - start);
+            Srgb::decode(from + start, a, n);
+            Srgb::decode(to + start, b, n);
+            for (int i = 0; i < n; ++i) a[i] = mixPixels(a[i], b[i], cov(start + i));
+            Srgb::encode(a, out + start, n);
+        }
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "Common.h"
+#include "AlignedBuffer.h"
+#include "PixelFormat.h"
+#include "Srgb.h"
+
+/**
+ * @class LinearImage
+ * @brief Working copy of part of an 8-bit sRGB image in linear light, with
+ * 16-bit (Pixel16) or float (PixelF) channels.
+ *
+ * decode() is the ingest step and encode() the egress step of a linear-light
+ * chain: the stages run on view() (EffectChain::runPointwise), so their
+ * intermediate results are neither gamma encoded nor rounded to 8 bits. Both
+ * conversions are table lookups (Srgb.h). Only the area being rendered (the
+ * lens box) is stored; like the snapshots of IEffect, it is addressed in image
+ * coordinates through the view's bounds. The storage keeps its capacity across
+ * frames.
+ */
+template <typename P>
+class LinearImage {
+public:
+    /**
+     * @brief Covers 'area' of an imgWidth x imgHeight image. The contents are
+     * undefined until decoded.
+     */
+    void resize(const Region& area, int imgWidth, int imgHeight) {
+        bounds = area;
+        width = imgWidth;
+        height = imgHeight;
+        pixels.resize(static_cast<size_t>(area.width) * area.height);
+    }
+
+    /**
+     * @brief Converts an area of an sRGB image (inside the bounds) into this one.
+     */
+    void decode(const SourceView& srgb, const Region& area) {
+        for (int y = area.y; y < area.y + area.height; ++y) {
+            Srgb::decode(&srgb.at(area.x, y), &at(area.x, y), area.width);
+        }
+    }
+
+    /**
+     * @brief Converts an area of this image (inside the bounds) back into an sRGB image.
+     */
+    void encode(const Region& area, const ImageView& srgb) const {
+        for (int y = area.y; y < area.y + area.height; ++y) {
+            Srgb::encode(&pixels[index(area.x, y)], &srgb.at(area.x, y), area.width);
+        }
+    }
+
+    /**
+     * @brief View of the stored area, in image coordinates.
+     */
+    BasicImageView<P> view() { return {pixels.data(), bounds.width, bounds, width, height}; }
+
+    /**
+     * @brief Pixel at image coordinates (x, y), which must lie inside the bounds.
+     */
+    P& at(int x, int y) { return pixels[index(x, y)]; }
+    const Region& getBounds() const { return bounds; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    AlignedBuffer<P> pixels;
+    Region bounds = {0, 0, 0, 0};
+    int width = 0;
+    int height = 0;
+
+    size_t index(int x, int y) const {
+        return static_cast<size_t>(y - bounds.y) * bounds.width + (x - bounds.x);
+    }
+};
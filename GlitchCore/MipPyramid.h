@@ -0,0 +1,136 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include "Common.h"
+#include "AlignedBuffer.h"
+#include "Simd.h"
+
+/**
+ * @class MipPyramid
+ * @brief Half-resolution copies of the original image, for previews.
+ *
+ * Level 0 is the original itself (not stored); level L is 2^L times smaller,
+ * each pixel the rounded mean of a 2x2 block of level L - 1 (edge pixels are
+ * repeated for odd sizes). Levels stop once the short side drops below
+ * kMinSize. Like the luma plane, the pyramid tracks a stale area of the
+ * original and update() only rebuilds the blocks above it.
+ */
+class MipPyramid {
+public:
+    static constexpr int kMaxLevels = 7; // Including level 0: down to 1/64
+    static constexpr int kMinSize = 8;
+
+    /**
+     * @brief Sets the level sizes for a w x h original and marks everything stale.
+     * Allocates nothing; the levels are allocated by the first update().
+     */
+    void reset(int w, int h) {
+        levelCount = 1;
+        widths[0] = w;
+        heights[0] = h;
+        while (levelCount < kMaxLevels) {
+            int lw = (widths[levelCount - 1] + 1) / 2;
+            int lh = (heights[levelCount - 1] + 1) / 2;
+            if (std::min(lw, lh) < kMinSize) break;
+            widths[levelCount] = lw;
+            heights[levelCount] = lh;
+            levelCount++;
+        }
+        stale = {0, 0, w, h};
+    }
+
+    /**
+     * @brief Marks an area of the original as changed.
+     */
+    void invalidate(const Region& area) { stale = unionRegion(stale, clipRegion(area, widths[0], heights[0])); }
+
+    bool isStale() const { return !stale.isEmpty(); }
+
+    /**
+     * @brief Rebuilds the stale area of every level from the original.
+     * @return Number of level pixels written.
+     */
+    size_t update(const Pixel* original) {
+        if (stale.isEmpty()) return 0;
+        size_t written = 0;
+        Region area = stale;
+        const Pixel* src = original;
+        for (int level = 1; level < levelCount; ++level) {
+            // Blocks of this level that read the changed pixels of the one below
+            int x0 = area.x / 2, y0 = area.y / 2;
+            int x1 = (area.x + area.width + 1) / 2, y1 = (area.y + area.height + 1) / 2;
+            area = clipRegion({x0, y0, x1 - x0, y1 - y0}, widths[level], heights[level]);
+
+            levels[level].resize(static_cast<size_t>(widths[level]) * heights[level]);
+            downsample(src, widths[level - 1], heights[level - 1], levels[level].data(), widths[level], area);
+            written += static_cast<size_t>(area.width) * area.height;
+            src = levels[level].data();
+        }
+        stale = {0, 0, 0, 0};
+        return written;
+    }
+
+    int getLevelCount() const { return levelCount; }
+    int getWidth(int level) const { return widths[level]; }
+    int getHeight(int level) const { return heights[level]; }
+
+    /**
+     * @brief Pixels of a level >= 1 (valid after update()).
+     */
+    const Pixel* data(int level) const { return levels[level].data(); }
+
+    /**
+     * @brief 2x2 box filter of src (sw x sh) into the given area of dst (dw wide).
+     * Rows and columns past the source edge repeat its last row / column.
+     */
+    static void downsample(const Pixel* src, int sw, int sh, Pixel* dst, int dw, const Region& area) {
+        for (int y = area.y; y < area.y + area.height; ++y) {
+            const Pixel* row0 = src + static_cast<size_t>(2 * y) * sw;
+            const Pixel* row1 = src + static_cast<size_t>(std::min(2 * y + 1, sh - 1)) * sw;
+            Pixel* out = dst + static_cast<size_t>(y) * dw;
+            int x = area.x;
+            int end = area.x + area.width;
+
+#if GLITCH_SIMD
+            // 4 output pixels from 2 x 8 input pixels, sums in 16-bit lanes
+            Simd::Vec two = Simd::splat16(2);
+            for (; x + Simd::kPixels <= end && 2 * x + 2 * Simd::kPixels <= sw; x += Simd::kPixels) {
+                Simd::Vec a = blockSums(Simd::load(row0 + 2 * x), Simd::load(row1 + 2 * x));
+                Simd::Vec b = blockSums(Simd::load(row0 + 2 * x + 4), Simd::load(row1 + 2 * x + 4));
+                a = Simd::shr16<2>(Simd::add16(a, two));
+                b = Simd::shr16<2>(Simd::add16(b, two));
+                Simd::store(out + x, Simd::narrowSat(a, b));
+            }
+#endif
+
+            for (; x < end; ++x) {
+                int left = 2 * x, right = std::min(2 * x + 1, sw - 1);
+                const Pixel& p = row0[left];
+                const Pixel& q = row0[right];
+                const Pixel& r = row1[left];
+                const Pixel& s = row1[right];
+                out[x] = {static_cast<uint8_t>((p.r + q.r + r.r + s.r + 2) >> 2),
+                          static_cast<uint8_t>((p.g + q.g + r.g + s.g + 2) >> 2),
+                          static_cast<uint8_t>((p.b + q.b + r.b + s.b + 2) >> 2),
+                          static_cast<uint8_t>((p.a + q.a + r.a + s.a + 2) >> 2)};
+            }
+        }
+    }
+
+private:
+    int levelCount = 1;
+    std::array<int, kMaxLevels> widths = {};
+    std::array<int, kMaxLevels> heights = {};
+    std::array<AlignedBuffer<Pixel>, kMaxLevels> levels; // levels[0] unused
+    Region stale = {0, 0, 0, 0};
+
+#if GLITCH_SIMD
+    // 4 pixels of two rows -> per-channel sums of the 2 blocks, in 16-bit lanes
+    static Simd::Vec blockSums(Simd::Vec top, Simd::Vec bottom) {
+        Simd::Vec left = Simd::add16(Simd::widenLo(top), Simd::widenLo(bottom));   // Pixels 0, 1
+        Simd::Vec right = Simd::add16(Simd::widenHi(top), Simd::widenHi(bottom));  // Pixels 2, 3
+        return Simd::add16(Simd::interleaveLo64(left, right), Simd::interleaveHi64(left, right));
+    }
+#endif
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include "Common.h"
+
+/**
+ * @file PixelFormat.h
+ * @brief Compile-time pixel format traits, so a kernel is written once and
+ * specialized per format instead of switching on the format per pixel.
+ *
+ * Every trait names its pixel and channel types and provides the channel
+ * arithmetic kernels are built from. Weights are in 1/256 steps like the
+ * lens coverage (256 = all of b). The Rgba8 versions are the exact integer
+ * formulas the 8-bit effects have always used, so templated kernels stay
+ * bit-exact with their 8-bit originals.
+ */
+
+/**
+ * @brief RGBA pixel with 16 bits per channel (high-bit-depth or linear-light data).
+ */
+struct Pixel16 {
+    uint16_t r, g, b, a;
+};
+
+/**
+ * @brief RGBA pixel with float channels, nominally in [0, 1].
+ */
+struct PixelF {
+    float r, g, b, a;
+};
+
+/**
+ * @struct Rgba8
+ * @brief 8-bit sRGB RGBA, the format of Pixel and of every image the engine holds.
+ */
+struct Rgba8 {
+    using Pixel = ::Pixel;
+    using Channel = uint8_t;
+    static constexpr Channel kMax = 255;
+
+    static Channel mix(Channel a, Channel b, int weight) {
+        return static_cast<Channel>((a * (256 - weight) + b * weight + 128) >> 8);
+    }
+    static Channel invert(Channel v) { return static_cast<Channel>(kMax - v); }
+    // Channel value of an 8-bit level (thresholds and other 8-bit parameters)
+    static Channel fromByte(uint8_t v) { return v; }
+    // v plus a signed amount of 8-bit levels, saturated to the channel range
+    static Channel offset(Channel v, int levels) { return static_cast<Channel>(std::max(0, std::min(255, v + levels))); }
+};
+
+/**
+ * @struct Rgba16
+ * @brief 16-bit RGBA: 16-bit scans, or linear light decoded with Srgb.h.
+ */
+struct Rgba16 {
+    using Pixel = Pixel16;
+    using Channel = uint16_t;
+    static constexpr Channel kMax = 65535;
+
+    static Channel mix(Channel a, Channel b, int weight) {
+        return static_cast<Channel>((uint32_t(a) * (256 - weight) + uint32_t(b) * weight + 128) >> 8);
+    }
+    static Channel invert(Channel v) { return static_cast<Channel>(kMax - v); }
+    static Channel fromByte(uint8_t v) { return static_cast<Channel>(v * 257); }
+    static Channel offset(Channel v, int levels) { return static_cast<Channel>(std::max(0, std::min(65535, v + levels * 257))); }
+};
+
+/**
+ * @struct RgbaF32
+ * @brief Interleaved float RGBA in [0, 1].
+ */
+struct RgbaF32 {
+    using Pixel = PixelF;
+    using Channel = float;
+    static constexpr float kMax = 1.0f;
+
+    static Channel mix(Channel a, Channel b, int weight) { return a + (b - a) * (weight * (1.0f / 256.0f)); }
+    static Channel invert(Channel v) { return kMax - v; }
+    static Channel fromByte(uint8_t v) { return v * (1.0f / 255.0f); }
+    static Channel offset(Channel v, int levels) { return std::max(0.0f, std::min(1.0f, v + levels * (1.0f / 255.0f))); }
+};
+
+/**
+ * @brief Format trait of a pixel type: PixelFormatOf<Pixel16>::type is Rgba16.
+ */
+template <typename P> struct PixelFormatOf;
+template <> struct PixelFormatOf<Pixel> { using type = Rgba8; };
+template <> struct PixelFormatOf<Pixel16> { using type = Rgba16; };
+template <> struct PixelFormatOf<PixelF> { using type = RgbaF32; };
+
+/**
+ * @brief Per-channel mix of two pixels of any format (alpha included).
+ */
+template <typename P>
+P mixPixels(const P& a, const P& b, int weight) {
+    using Format = typename PixelFormatOf<P>::type;
+    return {Format::mix(a.r, b.r, weight), Format::mix(a.g, b.g, weight),
+            Format::mix(a.b, b.b, weight), Format::mix(a.a, b.a, weight)};
+}
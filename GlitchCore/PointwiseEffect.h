@@ -0,0 +1,56 @@
+#pragma once
+#include "IEffect.h"
+#include "PixelFormat.h"
+
+/**
+ * @class PointwiseEffect
+ * @brief Base class for effects whose output pixel depends only on the same input pixel.
+ * Such effects only need to implement processSpan(); the base class walks the
+ * lens mask span by span. Because they have no neighbourhood, consecutive point-wise
+ * stages of an effect chain can be fused into a single pass over memory.
+ *
+ * The same operation is also provided on 16-bit and float pixels, so a chain
+ * of point-wise stages can run on a high-bit-depth or linear-light copy of the
+ * image (EffectChain::runPointwise). Implementations specialize one templated
+ * kernel per format (PixelFormat.h) rather than converting per pixel.
+ */
+class PointwiseEffect : public IEffect {
+public:
+    bool supportsInPlace() const override { return true; }
+    PointwiseEffect* asPointwise() override { return this; }
+
+    /**
+     * @brief Processes a contiguous run of pixels on one row.
+     * @param src Input pixels. May be the same memory as dst.
+     * @param dst Output pixels.
+     * @param count Number of pixels in the run.
+     * @param x Image X coordinate of the first pixel.
+     * @param y Image Y coordinate of the row.
+     * @param params Configuration parameters (intensity, etc).
+     */
+    virtual void processSpan(const Pixel* src, Pixel* dst, int count, int x, int y,
+                             const EffectParams& params) = 0;
+
+    /**
+     * @brief processSpan() on 16-bit pixels. 8-bit parameters (levels, thresholds)
+     * are scaled to the 16-bit range.
+     */
+    virtual void processSpan(const Pixel16* src, Pixel16* dst, int count, int x, int y,
+                             const EffectParams& params) = 0;
+
+    /**
+     * @brief processSpan() on float pixels in [0, 1].
+     */
+    virtual void processSpan(const PixelF* src, PixelF* dst, int count, int x, int y,
+                             const EffectParams& params) = 0;
+
+protected:
+    void render(const SourceView& source, const ImageView& dest,
+                const Region& region, const EffectParams& params) override {
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            int x0, x1;
+            if (!mask().span(y, x0, x1)) continue;
+            processSpan(&source.at(x0, y), &dest.at(x0, y), x1 - x0, x0, y, params);
+        }
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @struct Random
+ * @brief Counter-based random numbers for the randomized effects.
+ *
+ * Every value is a pure hash of (seed, frame, x, y, stream) through the
+ * SplitMix64 finalizer. There is no hidden generator state, so:
+ * - the result for a pixel does not depend on which thread renders it or in
+ *   which order, so effects can be split into bands and vectorized freely;
+ * - a frame is reproduced exactly from its seed and frame index.
+ */
+struct Random {
+    /**
+     * @brief 64 well-mixed random bits for one position.
+     * @param stream Distinguishes independent draws at the same position.
+     */
+    static uint64_t bits(uint32_t seed, uint32_t frame, int x, int y, uint32_t stream = 0) {
+        uint64_t key = (static_cast<uint64_t>(seed) << 32) | frame;
+        uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32) | static_cast<uint32_t>(x);
+        return mix(key ^ mix(position ^ (static_cast<uint64_t>(stream) << 48)));
+    }
+
+    /**
+     * @brief Maps 'bitCount' random bits to [0, n) by multiply-shift (no division).
+     */
+    static int below(uint64_t randomBits, int n, int bitCount = 32) {
+        uint64_t r = randomBits & ((uint64_t(1) << bitCount) - 1);
+        return static_cast<int>((r * static_cast<uint64_t>(n)) >> bitCount);
+    }
+
+private:
+    static uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
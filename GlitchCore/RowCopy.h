@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "Common.h"
+#include "Simd.h"
+
+/**
+ * @struct RowCopy
+ * @brief Row-run primitives for translation effects (Jitter, Scanline, Chromatic).
+ *
+ * A horizontal shift with clamped reads is one contiguous copy plus, near the
+ * image border, runs of the repeated edge pixel. Splitting the run once up
+ * front replaces a pair of clamps per pixel with memmove / fill, so these
+ * effects run at memory bandwidth. Results are bit-exact with the per-pixel
+ * clamped loops they replace.
+ */
+struct RowCopy {
+    /**
+     * @brief out[i] = source(clamp(srcX + i), y) for i in [0, count), clamping
+     * to the image columns. 'out' may overlap the source row.
+     */
+    static void shifted(const SourceView& source, int srcX, int y, Pixel* out, int count) {
+        if (count <= 0) return;
+        int head = std::min(count, std::max(0, -srcX));                        // Reads left of column 0
+        int start = srcX + head;
+        int body = std::min(count - head, std::max(0, source.width - start));   // Reads inside the row
+        int tail = count - head - body;                                         // Reads right of the last column
+
+        // Edge pixels are fetched before anything is written, in case out overlaps them
+        Pixel first = head > 0 ? source.at(0, y) : Pixel{};
+        Pixel last = tail > 0 ? source.at(source.width - 1, y) : Pixel{};
+        if (body > 0) std::memmove(out + head, &source.at(start, y), static_cast<size_t>(body) * sizeof(Pixel));
+        std::fill(out, out + head, first);
+        std::fill(out + head + body, out + count, last);
+    }
+
+    /**
+     * @brief Channel split over [x0, x1) of row y: red from x - offset, green from
+     * x and blue from x + offset (reads clamped to the image), alpha of out kept.
+     * 'out' points at the pixel for x0 and must not overlap the source.
+     */
+    static void splitChannels(const SourceView& source, int y, int x0, int x1, int offset, Pixel* out) {
+        // Columns whose red and blue reads need no clamping
+        int reach = std::abs(offset);
+        int safeBegin = std::max(x0, std::min(x1, reach));
+        int safeEnd = std::max(safeBegin, std::min(x1, source.width - reach));
+
+        int x = x0;
+        for (; x < safeBegin; ++x) splitPixel(source, y, x, offset, out[x - x0]);
+#if GLITCH_SIMD
+        // Three shifted loads of 4 pixels, merged bytewise by channel
+        Simd::Vec redMask = Simd::splat32(0x000000FFu);
+        Simd::Vec blueMask = Simd::splat32(0x00FF0000u);
+        Simd::Vec alphaMask = Simd::alphaMask();
+        for (; x + Simd::kPixels <= safeEnd; x += Simd::kPixels) {
+            Simd::Vec red = Simd::load(&source.at(x - offset, y));
+            Simd::Vec green = Simd::load(&source.at(x, y));
+            Simd::Vec blue = Simd::load(&source.at(x + offset, y));
+            Simd::Vec kept = Simd::load(out + (x - x0));
+            Simd::Vec v = Simd::select(redMask, red, Simd::select(blueMask, blue, Simd::select(alphaMask, kept, green)));
+            Simd::store(out + (x - x0), v);
+        }
+#endif
+        for (; x < x1; ++x) splitPixel(source, y, x, offset, out[x - x0]);
+    }
+
+private:
+    static void splitPixel(const SourceView& source, int y, int x, int offset, Pixel& p) {
+        int last = source.width - 1;
+        p.r = source.at(std::max(0, std::min(last, x - offset)), y).r;
+        p.g = source.at(x, y).g;
+        p.b = source.at(std::max(0, std::min(last, x + offset)), y).b;
+    }
+};
@@ -0,0 +1,378 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+/**
+ * @file Simd.h
+ * @brief Minimal portable 128-bit SIMD layer (16 bytes = 4 RGBA pixels).
+ *
+ * Backends, picked at compile time:
+ * - WebAssembly simd128 (build with -msimd128)
+ * - SSE2 (always available on x86-64)
+ * - NEON (AArch64 / ARMv7 with NEON)
+ * When none is available GLITCH_SIMD is 0 and effects use their scalar path.
+ * Kernels are written once against these helpers and are expected to be
+ * bit-exact with the scalar code they replace.
+ */
+
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define GLITCH_SIMD 1
+    #define GLITCH_SIMD_WASM 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define GLITCH_SIMD 1
+    #define GLITCH_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define GLITCH_SIMD 1
+    #define GLITCH_SIMD_NEON 1
+#else
+    #define GLITCH_SIMD 0
+#endif
+
+#if GLITCH_SIMD
+
+/**
+ * @struct Simd
+ * @brief Static helpers over one 128-bit register. "8" ops treat it as 16 x uint8,
+ * "16" ops as 8 x 16-bit lanes.
+ */
+struct Simd {
+#if GLITCH_SIMD_WASM
+    using Vec = v128_t;
+#elif GLITCH_SIMD_SSE2
+    using Vec = __m128i;
+#else
+    using Vec = uint8x16_t;
+#endif
+
+    static constexpr int kBytes = 16;
+    static constexpr int kPixels = 4;
+
+    static Vec load(const void* p) {
+#if GLITCH_SIMD_WASM
+        return wasm_v128_load(p);
+#elif GLITCH_SIMD_SSE2
+        return _mm_loadu_si128(static_cast<const __m128i*>(p));
+#else
+        return vld1q_u8(static_cast<const uint8_t*>(p));
+#endif
+    }
+
+    static void store(void* p, Vec v) {
+#if GLITCH_SIMD_WASM
+        wasm_v128_store(p, v);
+#elif GLITCH_SIMD_SSE2
+        _mm_storeu_si128(static_cast<__m128i*>(p), v);
+#else
+        vst1q_u8(static_cast<uint8_t*>(p), v);
+#endif
+    }
+
+    static Vec splat8(uint8_t v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u8x16_splat(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_set1_epi8(static_cast<char>(v));
+#else
+        return vdupq_n_u8(v);
+#endif
+    }
+
+    static Vec splat16(uint16_t v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u16x8_splat(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_set1_epi16(static_cast<short>(v));
+#else
+        return vreinterpretq_u8_u16(vdupq_n_u16(v));
+#endif
+    }
+
+    static Vec splat32(uint32_t v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u32x4_splat(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_set1_epi32(static_cast<int>(v));
+#else
+        return vreinterpretq_u8_u32(vdupq_n_u32(v));
+#endif
+    }
+
+    // Byte mask selecting the alpha channel of every RGBA pixel (little endian).
+    static Vec alphaMask() { return splat32(0xFF000000u); }
+
+    static Vec bitAnd(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_v128_and(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_and_si128(a, b);
+#else
+        return vandq_u8(a, b);
+#endif
+    }
+
+    static Vec bitOr(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_v128_or(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_or_si128(a, b);
+#else
+        return vorrq_u8(a, b);
+#endif
+    }
+
+    static Vec bitXor(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_v128_xor(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_xor_si128(a, b);
+#else
+        return veorq_u8(a, b);
+#endif
+    }
+
+    // mask ? a : b, per bit
+    static Vec select(Vec mask, Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_v128_bitselect(a, b, mask);
+#elif GLITCH_SIMD_SSE2
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+#else
+        return vbslq_u8(mask, a, b);
+#endif
+    }
+
+    // 0xFF where a > b (unsigned bytes)
+    static Vec greaterU8(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_u8x16_gt(a, b);
+#elif GLITCH_SIMD_SSE2
+        // a > b  <=>  max(b, a) != b  <=>  !(max(a, b) == b)
+        __m128i le = _mm_cmpeq_epi8(_mm_max_epu8(a, b), b);
+        return _mm_xor_si128(le, _mm_set1_epi8(-1));
+#else
+        return vcgtq_u8(a, b);
+#endif
+    }
+
+    // Zero-extend the low / high 8 bytes to 16-bit lanes
+    static Vec widenLo(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u16x8_extend_low_u8x16(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpacklo_epi8(v, _mm_setzero_si128());
+#else
+        return vreinterpretq_u8_u16(vmovl_u8(vget_low_u8(v)));
+#endif
+    }
+
+    static Vec widenHi(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u16x8_extend_high_u8x16(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpackhi_epi8(v, _mm_setzero_si128());
+#else
+        return vreinterpretq_u8_u16(vmovl_u8(vget_high_u8(v)));
+#endif
+    }
+
+    // Zero-extend the low / high four 16-bit lanes to 32-bit lanes
+    static Vec widen16Lo(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u32x4_extend_low_u16x8(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+#else
+        return vreinterpretq_u8_u32(vmovl_u16(vget_low_u16(vreinterpretq_u16_u8(v))));
+#endif
+    }
+
+    static Vec widen16Hi(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u32x4_extend_high_u16x8(v);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpackhi_epi16(v, _mm_setzero_si128());
+#else
+        return vreinterpretq_u8_u32(vmovl_u16(vget_high_u16(vreinterpretq_u16_u8(v))));
+#endif
+    }
+
+    // Signed 16-bit lanes -> unsigned bytes with saturation to [0, 255]
+    static Vec narrowSat(Vec lo, Vec hi) {
+#if GLITCH_SIMD_WASM
+        return wasm_u8x16_narrow_i16x8(lo, hi);
+#elif GLITCH_SIMD_SSE2
+        return _mm_packus_epi16(lo, hi);
+#else
+        return vcombine_u8(vqmovun_s16(vreinterpretq_s16_u8(lo)), vqmovun_s16(vreinterpretq_s16_u8(hi)));
+#endif
+    }
+
+    static Vec add16(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_add(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_add_epi16(a, b);
+#else
+        return vreinterpretq_u8_u16(vaddq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+#endif
+    }
+
+    // Wrapping 32-bit lane arithmetic
+    static Vec add32(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i32x4_add(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_add_epi32(a, b);
+#else
+        return vreinterpretq_u8_u32(vaddq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+#endif
+    }
+
+    static Vec sub32(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i32x4_sub(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_sub_epi32(a, b);
+#else
+        return vreinterpretq_u8_u32(vsubq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+#endif
+    }
+
+    static Vec sub16(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_sub(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_sub_epi16(a, b);
+#else
+        return vreinterpretq_u8_u16(vsubq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+#endif
+    }
+
+    // Low 16 bits of the product
+    static Vec mul16(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_mul(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_mullo_epi16(a, b);
+#else
+        return vreinterpretq_u8_u16(vmulq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+#endif
+    }
+
+    // Low 64-bit halves of a and b: [a.lo, b.lo]
+    static Vec interleaveLo64(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i64x2_shuffle(a, b, 0, 2);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpacklo_epi64(a, b);
+#else
+        return vcombine_u8(vget_low_u8(a), vget_low_u8(b));
+#endif
+    }
+
+    // High 64-bit halves of a and b: [a.hi, b.hi]
+    static Vec interleaveHi64(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i64x2_shuffle(a, b, 1, 3);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpackhi_epi64(a, b);
+#else
+        return vcombine_u8(vget_high_u8(a), vget_high_u8(b));
+#endif
+    }
+
+    // Interleave the low / high four 16-bit lanes of a and b: [a0 b0 a1 b1 ...]
+    static Vec interleave16Lo(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_shuffle(a, b, 0, 8, 1, 9, 2, 10, 3, 11);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpacklo_epi16(a, b);
+#else
+        return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[0]);
+#endif
+    }
+
+    static Vec interleave16Hi(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_shuffle(a, b, 4, 12, 5, 13, 6, 14, 7, 15);
+#elif GLITCH_SIMD_SSE2
+        return _mm_unpackhi_epi16(a, b);
+#else
+        return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[1]);
+#endif
+    }
+
+    // Signed 16-bit products, adjacent pairs summed into 32-bit lanes:
+    // [a0*b0 + a1*b1, a2*b2 + a3*b3, ...]
+    static Vec maddPairs16(Vec a, Vec b) {
+#if GLITCH_SIMD_WASM
+        return wasm_i32x4_dot_i16x8(a, b);
+#elif GLITCH_SIMD_SSE2
+        return _mm_madd_epi16(a, b);
+#else
+        int16x8_t sa = vreinterpretq_s16_u8(a), sb = vreinterpretq_s16_u8(b);
+        int32x4_t lo = vmull_s16(vget_low_s16(sa), vget_low_s16(sb));
+        int32x4_t hi = vmull_s16(vget_high_s16(sa), vget_high_s16(sb));
+        int32x4_t sums = vcombine_s32(vpadd_s32(vget_low_s32(lo), vget_high_s32(lo)),
+                                      vpadd_s32(vget_low_s32(hi), vget_high_s32(hi)));
+        return vreinterpretq_u8_s32(sums);
+#endif
+    }
+
+    // Arithmetic right shift of 32-bit lanes by a runtime amount
+    static Vec sra32(Vec v, int n) {
+#if GLITCH_SIMD_WASM
+        return wasm_i32x4_shr(v, n);
+#elif GLITCH_SIMD_SSE2
+        return _mm_sra_epi32(v, _mm_cvtsi32_si128(n));
+#else
+        return vreinterpretq_u8_s32(vshlq_s32(vreinterpretq_s32_u8(v), vdupq_n_s32(-n)));
+#endif
+    }
+
+    // Signed 32-bit lanes -> signed 16-bit lanes with saturation: [lo, hi]
+    static Vec narrow32Sat(Vec lo, Vec hi) {
+#if GLITCH_SIMD_WASM
+        return wasm_i16x8_narrow_i32x4(lo, hi);
+#elif GLITCH_SIMD_SSE2
+        return _mm_packs_epi32(lo, hi);
+#else
+        return vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(vreinterpretq_s32_u8(lo)), vqmovn_s32(vreinterpretq_s32_u8(hi))));
+#endif
+    }
+
+    // floor(sqrt(v)) of non-negative 32-bit lanes, through float lanes. Exact
+    // for v < 2^16 (every result below 256), since the float sqrt is correctly rounded.
+    static Vec sqrtFloor32(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_sqrt(wasm_f32x4_convert_i32x4(v)));
+#elif GLITCH_SIMD_SSE2
+        return _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(v)));
+#elif defined(__aarch64__)
+        return vreinterpretq_u8_s32(vcvtq_s32_f32(vsqrtq_f32(vcvtq_f32_s32(vreinterpretq_s32_u8(v)))));
+#else
+        int32_t lanes[4];
+        std::memcpy(lanes, &v, sizeof(lanes));
+        for (int32_t& lane : lanes) lane = static_cast<int32_t>(std::sqrt(static_cast<float>(lane)));
+        return vreinterpretq_u8_s32(vld1q_s32(lanes));
+#endif
+    }
+
+    // Logical right shift of 16-bit lanes
+    template <int N>
+    static Vec shr16(Vec v) {
+#if GLITCH_SIMD_WASM
+        return wasm_u16x8_shr(v, N);
+#elif GLITCH_SIMD_SSE2
+        return _mm_srli_epi16(v, N);
+#else
+        return vreinterpretq_u8_u16(vshrq_n_u16(vreinterpretq_u16_u8(v), N));
+#endif
+    }
+};
+
+#endif // GLITCH_SIMD
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "PixelFormat.h"
+
+/**
+ * @struct Srgb
+ * @brief Table-driven conversion between 8-bit sRGB and linear light.
+ *
+ * Decoding is a 256-entry lookup per channel. Encoding a 16-bit linear value
+ * is a 64 KB lookup that rounds to the nearest sRGB level (measured in the sRGB
+ * domain), so decode followed by encode returns every 8-bit value unchanged.
+ * Alpha is not gamma encoded and is only rescaled. The tables are built on
+ * first use (static storage, no heap).
+ */
+struct Srgb {
+    static uint16_t toLinear16(uint8_t v) { return tables().toLinear[v]; }
+    static float toLinearF(uint8_t v) { return tables().toLinearF[v]; }
+    static uint8_t fromLinear16(uint16_t v) { return tables().fromLinear[v]; }
+    static uint8_t fromLinearF(float v) { return fromLinearF(tables(), v); }
+
+    /**
+     * @brief Converts a run of sRGB pixels to linear light.
+     */
+    static void decode(const Pixel* src, Pixel16* dst, int count) {
+        const Tables& t = tables();
+        for (int i = 0; i < count; ++i) {
+            dst[i] = {t.toLinear[src[i].r], t.toLinear[src[i].g], t.toLinear[src[i].b],
+                      static_cast<uint16_t>(src[i].a * 257)};
+        }
+    }
+
+    static void decode(const Pixel* src, PixelF* dst, int count) {
+        const Tables& t = tables();
+        for (int i = 0; i < count; ++i) {
+            dst[i] = {t.toLinearF[src[i].r], t.toLinearF[src[i].g], t.toLinearF[src[i].b], src[i].a * (1.0f / 255.0f)};
+        }
+    }
+
+    /**
+     * @brief Converts a run of linear-light pixels back to sRGB.
+     */
+    static void encode(const Pixel16* src, Pixel* dst, int count) {
+        const Tables& t = tables();
+        for (int i = 0; i < count; ++i) {
+            dst[i] = {t.fromLinear[src[i].r], t.fromLinear[src[i].g], t.fromLinear[src[i].b],
+                      static_cast<uint8_t>((src[i].a + 128) / 257)};
+        }
+    }
+
+    static void encode(const PixelF* src, Pixel* dst, int count) {
+        const Tables& t = tables();
+        for (int i = 0; i < count; ++i) {
+            float a = std::max(0.0f, std::min(1.0f, src[i].a));
+            dst[i] = {fromLinearF(t, src[i].r), fromLinearF(t, src[i].g), fromLinearF(t, src[i].b),
+                      static_cast<uint8_t>(a * 255.0f + 0.5f)};
+        }
+    }
+
+    /**
+     * @brief The sRGB transfer function (encoded value in [0, 1] to linear light).
+     */
+    static double eotf(double v) {
+        return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+    }
+
+private:
+    struct Tables {
+        uint16_t toLinear[256];
+        float toLinearF[256];
+        uint8_t fromLinear[65536];
+
+        Tables() {
+            for (int v = 0; v < 256; ++v) {
+                double linear = eotf(v / 255.0);
+                toLinear[v] = static_cast<uint16_t>(linear * 65535.0 + 0.5);
+                toLinearF[v] = static_cast<float>(linear);
+            }
+            // Level v covers the linear values from the midpoint below it to the one above
+            int next = 0;
+            for (int v = 0; v < 256; ++v) {
+                int end = v == 255 ? 65536 : static_cast<int>(std::ceil(eotf((v + 0.5) / 255.0) * 65535.0));
+                for (; next < end; ++next) fromLinear[next] = static_cast<uint8_t>(v);
+            }
+        }
+    };
+
+    static const Tables& tables() {
+        static const Tables instance;
+        return instance;
+    }
+
+    static uint8_t fromLinearF(const Tables& t, float v) {
+        float clamped = std::max(0.0f, std::min(1.0f, v));
+        return t.fromLinear[static_cast<int>(clamped * 65535.0f + 0.5f)];
+    }
+};
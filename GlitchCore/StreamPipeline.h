@@ -0,0 +1,261 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "Common.h"
+#include "EffectChain.h"
+#include "TileScheduler.h"
+#include "VideoIO.h"
+
+/**
+ * @class BoundedQueue
+ * @brief Fixed-capacity blocking FIFO for handing work between pipeline threads.
+ * push() waits while the queue is full and pop() while it is empty; close()
+ * wakes everyone up and makes both fail once the queue has drained.
+ * The storage is allocated once by the constructor.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : items(std::max<size_t>(1, capacity)) {}
+
+    bool push(const T& item) {
+#if GLITCH_THREADS
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return closed || count < items.size(); });
+#endif
+        if (closed || count == items.size()) return false;
+        items[(head + count) % items.size()] = item;
+        ++count;
+#if GLITCH_THREADS
+        notEmpty.notify_one();
+#endif
+        return true;
+    }
+
+    bool pop(T& item) {
+#if GLITCH_THREADS
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return closed || count > 0; });
+#endif
+        if (count == 0) return false;
+        item = items[head];
+        head = (head + 1) % items.size();
+        --count;
+#if GLITCH_THREADS
+        notFull.notify_one();
+#endif
+        return true;
+    }
+
+    void close() {
+#if GLITCH_THREADS
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        closed = true;
+#if GLITCH_THREADS
+        notEmpty.notify_all();
+        notFull.notify_all();
+#endif
+    }
+
+private:
+    std::vector<T> items;
+    size_t head = 0;
+    size_t count = 0;
+    bool closed = false;
+#if GLITCH_THREADS
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+#endif
+};
+
+/**
+ * @brief One effect of a streaming chain; intensity is scaled per frame by the keyframes.
+ */
+struct StreamStage {
+    EffectType type;
+    float intensity;
+};
+
+/**
+ * @brief Lens position at a frame. Values between keyframes are interpolated linearly.
+ */
+struct Keyframe {
+    int frame;
+    float centerX;
+    float centerY;
+    float radius;
+    float intensityScale = 1.0f;
+};
+
+struct StreamOptions {
+    std::vector<StreamStage> stages;
+    std::vector<Keyframe> keyframes; // Sorted by frame. Empty: every stage covers the whole frame
+    int feather = 0;
+    RenderQuality quality = RenderQuality::Final;
+    uint32_t seed = 0;
+    int threads = TileScheduler::defaultThreadCount(); // Render threads of the process stage
+    int buffers = 4;                                   // Frames in flight between the stages
+};
+
+/**
+ * @class StreamPipeline
+ * @brief Applies an effect chain to every frame of a video stream.
+ *
+ * Decode, process and encode run on separate threads and hand frame slots to
+ * each other through BoundedQueues:
+ *
+ *   free -> [decode] -> decoded -> [process] -> processed -> [encode] -> free
+ *
+ * The pool holds 'buffers' slots allocated up front and recycled, so memory is
+ * bounded and steady state does not allocate. With every stage busy on a
+ * different frame, throughput is set by the slowest stage instead of their sum.
+ * The process stage renders each frame with an EffectChain on a TileScheduler.
+ *
+ * Builds without threads (plain wasm) run the three stages in turn per frame.
+ */
+class StreamPipeline {
+public:
+    explicit StreamPipeline(const StreamOptions& streamOptions)
+        : options(streamOptions), scheduler(streamOptions.threads) {}
+
+    /**
+     * @brief Reads every frame from reader, renders it and writes it to writer.
+     * @return Number of frames written, or -1 if the writer failed.
+     */
+    long run(FrameReader& reader, FrameWriter& writer) {
+        const VideoInfo& info = reader.getInfo();
+        int slotCount = std::max(1, options.buffers);
+        slots.resize(slotCount);
+        for (Slot& slot : slots) {
+            slot.input.resize(info.framePixels());
+            slot.output.resize(info.framePixels());
+        }
+        stages.resize(options.stages.size());
+
+        BoundedQueue<int> freeSlots(slotCount), decoded(slotCount), processed(slotCount);
+        for (int i = 0; i < slotCount; ++i) freeSlots.push(i);
+
+        long written = 0;
+        bool writeFailed = false;
+
+        auto decode = [&] {
+            int slot;
+            long frame = 0;
+            while (freeSlots.pop(slot)) {
+                if (!reader.read(slots[slot].input.data())) break;
+                slots[slot].frame = frame++;
+                if (!decoded.push(slot)) break;
+            }
+            decoded.close();
+        };
+        auto process = [&] {
+            int slot;
+            while (decoded.pop(slot)) {
+                render(slots[slot], info.width, info.height);
+                if (!processed.push(slot)) break;
+            }
+            processed.close();
+        };
+        auto encode = [&] {
+            int slot;
+            while (processed.pop(slot)) {
+                if (!writer.write(slots[slot].output.data())) {
+                    writeFailed = true;
+                    break;
+                }
+                ++written;
+                freeSlots.push(slot);
+            }
+            // Unblock the other stages if we stopped early
+            freeSlots.close();
+            decoded.close();
+            processed.close();
+        };
+
+#if GLITCH_THREADS
+        std::thread decoder(decode);
+        std::thread processor(process);
+        encode();
+        decoder.join();
+        processor.join();
+#else
+        // One slot at a time: each queue holds at most one frame between the stages
+        int slot;
+        while (freeSlots.pop(slot)) {
+            if (!reader.read(slots[slot].input.data())) break;
+            slots[slot].frame = written;
+            render(slots[slot], info.width, info.height);
+            if (!writer.write(slots[slot].output.data())) { writeFailed = true; break; }
+            ++written;
+            freeSlots.push(slot);
+        }
+        (void)decode; (void)process; (void)encode;
+#endif
+        return writeFailed ? -1 : written;
+    }
+
+    /**
+     * @brief Parameters of one stage at a frame (lens from the keyframes, or the whole frame).
+     */
+    static EffectParams paramsAt(const StreamOptions& options, const StreamStage& stage, long frame) {
+        EffectParams params = {stage.intensity, false, 0, 0, 0};
+        params.feather = options.feather;
+        params.quality = options.quality;
+        params.seed = options.seed;
+        params.frame = static_cast<uint32_t>(frame);
+        if (options.keyframes.empty()) return params;
+
+        const std::vector<Keyframe>& keys = options.keyframes;
+        size_t next = 0;
+        while (next < keys.size() && keys[next].frame <= frame) ++next;
+        const Keyframe& a = keys[next == 0 ? 0 : next - 1];
+        const Keyframe& b = keys[next == keys.size() ? keys.size() - 1 : next];
+        float t = (b.frame > a.frame) ? static_cast<float>(frame - a.frame) / (b.frame - a.frame) : 0.0f;
+        t = std::max(0.0f, std::min(1.0f, t));
+        auto lerp = [t](float from, float to) { return from + (to - from) * t; };
+
+        params.useCircleMask = true;
+        params.centerX = static_cast<int>(std::lround(lerp(a.centerX, b.centerX)));
+        params.centerY = static_cast<int>(std::lround(lerp(a.centerY, b.centerY)));
+        params.radius = static_cast<int>(std::lround(lerp(a.radius, b.radius)));
+        params.intensity = stage.intensity * lerp(a.intensityScale, b.intensityScale);
+        return params;
+    }
+
+private:
+    struct Slot {
+        std::vector<Pixel> input;  // Decoded frame
+        std::vector<Pixel> output; // Rendered frame
+        std::vector<uint8_t> luma; // Luma of input, for luma-driven effects
+        long frame = 0;
+    };
+
+    StreamOptions options;
+    TileScheduler scheduler;
+    EffectChain chain;
+    std::vector<Slot> slots;
+    std::vector<EffectStage> stages; // Per-frame chain, reused (process thread only)
+
+    void render(Slot& slot, int width, int height) {
+        bool needsLuma = false;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            stages[i].type = options.stages[i].type;
+            stages[i].params = paramsAt(options, options.stages[i], slot.frame);
+            IEffect* effect = chain.getEffect(stages[i].type);
+            needsLuma = needsLuma || (effect && effect->usesLuma());
+        }
+
+        // The chain expects the output to start as a copy of the input
+        std::copy(slot.input.begin(), slot.input.end(), slot.output.begin());
+        SourceView source = SourceView::whole(slot.input.data(), width, height);
+        if (needsLuma) {
+            slot.luma.resize(slot.input.size());
+            computeLuma(slot.input.data(), slot.luma.data(), static_cast<int>(slot.input.size()));
+            source.luma = slot.luma.data();
+        }
+        chain.run(scheduler, stages.data(), static_cast<int>(stages.size()), source,
+                  ImageView::whole(slot.output.data(), width, height));
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include "Common.h"
+#include "AlignedBuffer.h"
+#include "Simd.h"
+
+/**
+ * @class SummedAreaTable
+ * @brief Per-channel integral image: the sum of any rectangle in four lookups.
+ *
+ * Entry (i, j) holds the R, G, B and A sums of the pixels [0, i) x [0, j) of
+ * the covered area, so the table has (width + 1) x (height + 1) entries of
+ * four 32-bit lanes. The lanes wrap around; rectangle sums are still exact as
+ * long as the true sum fits in 32 bits, i.e. for rectangles under 16.8 M pixels.
+ *
+ * The engine keeps one over the whole original (attached to SourceView::integral
+ * while it is up to date). Effects handed any other source, or none, build a
+ * local table over the area they need with of().
+ */
+class SummedAreaTable {
+public:
+    /**
+     * @brief Builds the table over an area of the source (clipped to its bounds).
+     */
+    void build(const SourceView& source, const Region& requested) {
+        area = intersect(requested, source.bounds);
+        stride = area.width + 1;
+        table.resize(static_cast<size_t>(stride) * (area.height + 1) * 4);
+        std::fill(table.data(), table.data() + static_cast<size_t>(stride) * 4, 0u); // Row 0
+        for (int j = 1; j <= area.height; ++j) std::fill(entry(0, j), entry(0, j) + 4, 0u);
+        fillRows(source, area);
+    }
+
+    /**
+     * @brief Recomputes every entry that depends on the changed pixels.
+     * @return Number of entries written.
+     */
+    size_t update(const SourceView& source, const Region& changed) {
+        Region from = intersect(changed, area);
+        if (from.isEmpty()) return 0;
+        // Everything right of and below the change's top-left corner
+        from = {from.x, from.y, area.x + area.width - from.x, area.y + area.height - from.y};
+        fillRows(source, from);
+        return static_cast<size_t>(from.width) * from.height;
+    }
+
+    /**
+     * @brief Area of the image the table covers.
+     */
+    const Region& getArea() const { return area; }
+
+    bool covers(const Region& r) const {
+        return r.x >= area.x && r.y >= area.y && r.x + r.width <= area.x + area.width &&
+               r.y + r.height <= area.y + area.height;
+    }
+
+    /**
+     * @brief Channel sums (R, G, B, A) of the pixels [x0, x1) x [y0, y1), in image
+     * coordinates. The rectangle must lie inside getArea().
+     */
+    void sum(int x0, int y0, int x1, int y1, uint32_t out[4]) const {
+        const uint32_t* a = entry(x0 - area.x, y0 - area.y);
+        const uint32_t* b = entry(x1 - area.x, y0 - area.y);
+        const uint32_t* c = entry(x0 - area.x, y1 - area.y);
+        const uint32_t* d = entry(x1 - area.x, y1 - area.y);
+#if GLITCH_SIMD
+        Simd::store(out, Simd::add32(Simd::sub32(Simd::sub32(Simd::load(d), Simd::load(b)), Simd::load(c)), Simd::load(a)));
+#else
+        for (int k = 0; k < 4; ++k) out[k] = d[k] - b[k] - c[k] + a[k];
+#endif
+    }
+
+    /**
+     * @brief Rounded mean color of the pixels [x0, x1) x [y0, y1) (must not be empty).
+     */
+    Pixel average(int x0, int y0, int x1, int y1) const {
+        uint32_t sums[4];
+        sum(x0, y0, x1, y1, sums);
+        uint32_t count = static_cast<uint32_t>(x1 - x0) * static_cast<uint32_t>(y1 - y0);
+        uint32_t half = count / 2;
+        return {static_cast<uint8_t>((sums[0] + half) / count), static_cast<uint8_t>((sums[1] + half) / count),
+                static_cast<uint8_t>((sums[2] + half) / count), static_cast<uint8_t>((sums[3] + half) / count)};
+    }
+
+    /**
+     * @brief The table attached to the source if it covers the area, otherwise
+     * 'local' rebuilt over the area.
+     */
+    static const SummedAreaTable& of(const SourceView& source, const Region& area, SummedAreaTable& local) {
+        if (source.integral && source.integral->covers(intersect(area, source.bounds))) return *source.integral;
+        local.build(source, area);
+        return local;
+    }
+
+private:
+    Region area = {0, 0, 0, 0};
+    int stride = 0; // Entries per table row (area.width + 1)
+    AlignedBuffer<uint32_t> table;
+
+    uint32_t* entry(int i, int j) { return table.data() + (static_cast<size_t>(j) * stride + i) * 4; }
+    const uint32_t* entry(int i, int j) const { return table.data() + (static_cast<size_t>(j) * stride + i) * 4; }
+
+    static Region intersect(const Region& a, const Region& b) {
+        int x0 = std::max(a.x, b.x), y0 = std::max(a.y, b.y);
+        int x1 = std::min(a.x + a.width, b.x + b.width), y1 = std::min(a.y + a.height, b.y + b.height);
+        if (x1 <= x0 || y1 <= y0) return {0, 0, 0, 0};
+        return {x0, y0, x1 - x0, y1 - y0};
+    }
+
+    /**
+     * @brief Writes the entries past the pixels of 'rows' (a block reaching the
+     * right and bottom edges of the area): entry = entry above + running row sum.
+     */
+    void fillRows(const SourceView& source, const Region& rows) {
+        int i0 = rows.x - area.x;
+        for (int y = rows.y; y < rows.y + rows.height; ++y) {
+            int j = y - area.y;
+            const Pixel* pixels = &source.at(rows.x, y);
+            int count = rows.width;
+            int x = 0;
+
+            // Row sum of the columns left of the block, from the (unchanged) entries there
+            const uint32_t* left = entry(i0, j + 1);
+            const uint32_t* leftAbove = entry(i0, j);
+#if GLITCH_SIMD
+            Simd::Vec running = Simd::sub32(Simd::load(left), Simd::load(leftAbove));
+            for (; x + Simd::kPixels <= count; x += Simd::kPixels) {
+                Simd::Vec v = Simd::load(pixels + x);
+                Simd::Vec lo = Simd::widenLo(v), hi = Simd::widenHi(v);
+                Simd::Vec channels[4] = {Simd::widen16Lo(lo), Simd::widen16Hi(lo), Simd::widen16Lo(hi), Simd::widen16Hi(hi)};
+                for (int k = 0; k < 4; ++k) {
+                    running = Simd::add32(running, channels[k]);
+                    int i = i0 + x + k + 1;
+                    Simd::store(entry(i, j + 1), Simd::add32(Simd::load(entry(i, j)), running));
+                }
+            }
+            uint32_t acc[4];
+            Simd::store(acc, running);
+#else
+            uint32_t acc[4] = {left[0] - leftAbove[0], left[1] - leftAbove[1], left[2] - leftAbove[2], left[3] - leftAbove[3]};
+#endif
+            for (; x < count; ++x) {
+                const Pixel& p = pixels[x];
+                acc[0] += p.r;
+                acc[1] += p.g;
+                acc[2] += p.b;
+                acc[3] += p.a;
+                int i = i0 + x + 1;
+                const uint32_t* above = entry(i, j);
+                uint32_t* out = entry(i, j + 1);
+                for (int k = 0; k < 4; ++k) out[k] = above[k] + acc[k];
+            }
+        }
+    }
+};
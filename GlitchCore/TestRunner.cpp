@@ -9,11 +9,18 @@
 #include <cassert>
 #include <iomanip>
 #include <cmath>
-#include <cstdlib> // For rand/srand
+#include <cstdlib> // For exit
+#include <cstring> // For memcmp
+#include <cstdio>  // For remove
+#include <sstream>
 
 // Include Core Definitions
 #include "Common.h"
 
+// Count every heap allocation in this binary (see AllocationCounter.h)
+#define GLITCH_TRACK_ALLOCATIONS
+#include "AllocationCounter.h"
+
 // Include All Effects
 #include "Effects/InvertEffect.h"
 #include "Effects/PixelSortEffect.h"
@@ -22,6 +29,22 @@
 #include "Effects/SwirlEffect.h"
 #include "Effects/JitterEffect.h"
 #include "Effects/ScanlineEffect.h"
+#include "Effects/SobelEffect.h"
+#include "Effects/RippleEffect.h"
+#include "Effects/SolarizeEffect.h"
+#include "Effects/RGBNoiseEffect.h"
+#include "Effects/GaussianBlurEffect.h"
+#include "Effects/SharpenEffect.h"
+#include "Effects/EmbossEffect.h"
+#include "Effects/BoxBlurEffect.h"
+
+// Include the Engine (Unity build approach, same as bindings.cpp)
+#include "GlitchEngine.cpp"
+#include "TiledRenderer.h"
+#include "StreamPipeline.h"
+#include "ImageIO.h"
+#include "RowCopy.h"
+#include "Srgb.h"
 
 // Console Color Macros
 #define GREEN "\033[32m"
@@ -84,6 +107,27 @@ void runPixelSortTest() {
     // Expected: 50, 100, 200, 250
     if (buffer[0].r != 50 || buffer[1].r != 100) printFail("Pixel Sorting", "Sorting order incorrect.");
 
+    // Tall column (counting sort path): sorted by luma, equal keys keep their order
+    int tall = 300;
+    std::vector<Pixel> column(tall);
+    for (int i = 0; i < tall; i++) column[i] = {static_cast<uint8_t>((i * 37) % 256), 0, 0, static_cast<uint8_t>(i % 256)};
+    effect.apply(column, 1, tall, {0, 0, 1, tall}, params);
+    for (int i = 1; i < tall; i++) {
+        uint8_t a = column[i - 1].getLuma8(), b = column[i].getLuma8();
+        if (a > b || (a == b && column[i - 1].r == column[i].r && column[i - 1].a > column[i].a)) {
+            printFail("Pixel Sorting", "Counting sort is not ordered or not stable.");
+        }
+    }
+
+    // Interval mode: pixels outside the luma window stay put and split the runs
+    PixelSortEffect intervals(true);
+    std::vector<Pixel> runs = { mkPixel(200), mkPixel(150), mkPixel(100), mkPixel(0), mkPixel(180), mkPixel(120), mkPixel(255) };
+    intervals.apply(runs, 1, 7, {0, 0, 1, 7}, {50.0f, false, 0, 0, 0}); // Window [64, 192]
+    uint8_t expected[] = {200, 100, 150, 0, 120, 180, 255};
+    for (int i = 0; i < 7; i++) {
+        if (runs[i].r != expected[i]) printFail("Pixel Sorting", "Interval mode sorted across thresholds.");
+    }
+
     printPass("Pixel Sorting");
 }
 
@@ -109,7 +153,7 @@ void runChromaticTest() {
 
 /**
  * @brief Test 4: Mosaic Effect (Deterministic).
- * Verifies that a block of pixels takes the color of the top-left pixel.
+ * Verifies that a block of pixels takes the mean color of the block.
  */
 void runMosaicTest() {
     int w = 4, h = 4;
@@ -117,23 +161,26 @@ void runMosaicTest() {
     
     // Set Top-Left pixel of the first block (0,0) to WHITE
     buffer[0] = mkPixel(255); 
-    // Set neighbor (1,1) to BLACK
-    buffer[1 * w + 1] = mkPixel(0);
+    // Set pixel (2,0) of the second block to 100
+    buffer[2] = mkPixel(100);
 
     MosaicEffect effect;
     Region region = {0, 0, w, h};
     // Intensity 4 -> BlockSize = 2.
-    // Block (0,0) to (1,1) should all become WHITE (value of 0,0).
+    // Block (0,0) to (1,1) should all become (255 + 0 + 0 + 0) / 4 = 64 (rounded).
     EffectParams params = {4.0f, true, 0, 0, 10}; 
 
     effect.apply(buffer, w, h, region, params);
 
-    // Check pixel at (1,1). It was Black, should now be White (copied from 0,0)
-    if (buffer[1 * w + 1].r == 255) {
-        printPass("Mosaic Effect");
-    } else {
-        printFail("Mosaic Effect", "Pixel (1,1) did not inherit color from (0,0).");
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            if (buffer[y * w + x].r != 64) printFail("Mosaic Effect", "Block (0,0) is not the mean of its pixels.");
+            if (buffer[y * w + x + 2].r != 25) printFail("Mosaic Effect", "Block (2,0) is not the mean of its pixels.");
+        }
     }
+    if (buffer[3 * w + 3].r != 0) printFail("Mosaic Effect", "Black block changed.");
+
+    printPass("Mosaic Effect (Block Mean)");
 }
 
 /**
@@ -182,10 +229,6 @@ void runSwirlTest() {
  * Verifies that the effect alters the image content within the bubble.
  */
 void runJitterTest() {
-    std::srand(123); // Fixed seed for reproducibility? 
-                     // Actually, Jitter uses rand(), which differs by platform.
-                     // We will check for "Change detection".
-
     int w = 20, h = 20;
     std::vector<Pixel> buffer(w * h);
     
@@ -233,6 +276,7 @@ void runScanlineTest() {
     // (Scanline has a ~30% chance per line)
     bool shifted = false;
     for(int attempt=0; attempt<5; attempt++) {
+        params.frame = attempt; // New noise each attempt
         effect.apply(buffer, w, h, region, params);
         
         // Check if the white line at x=5 is broken (i.e., some pixel is now black)
@@ -248,10 +292,1678 @@ void runScanlineTest() {
     else printFail("Scanline Effect", "Vertical line remained perfectly straight.");
 }
 
+/**
+ * @brief Test 8: Dirty Rectangle Healing (Engine).
+ * Verifies that only the previous lens area is healed and that the
+ * reported dirty rect covers both the healed and the new area.
+ */
+void runDirtyRectTest() {
+    int w = 20, h = 20;
+    GlitchEngine engine;
+    engine.loadBox(w, h);
+
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) original[i] = mkPixel(255);
+
+    // First frame heals the whole (never initialized) display buffer.
+    engine.renderFrame(5, 5, 2, static_cast<int>(EffectType::INVERT), 100.0f);
+    Region r = engine.getDirtyRect();
+    if (r.x != 0 || r.y != 0 || r.width != w || r.height != h) printFail("Dirty Rect", "First frame must present the full image.");
+    if (display[5 * w + 5].r != 0) printFail("Dirty Rect", "Lens center not inverted.");
+
+    // Second frame far away: old lens healed, dirty rect is the union of both boxes.
+    engine.renderFrame(15, 15, 2, static_cast<int>(EffectType::INVERT), 100.0f);
+    r = engine.getDirtyRect();
+    if (display[5 * w + 5].r != 255) printFail("Dirty Rect", "Previous lens area was not healed.");
+    if (display[15 * w + 15].r != 0) printFail("Dirty Rect", "New lens center not inverted.");
+    if (r.x != 3 || r.y != 3 || r.width != 14 || r.height != 14) printFail("Dirty Rect", "Union rect incorrect.");
+
+    // Lens outside the image: only the previous box is reported.
+    engine.renderFrame(-1000, -1000, 0, 0, 0);
+    r = engine.getDirtyRect();
+    if (display[15 * w + 15].r != 255) printFail("Dirty Rect", "Lens area not healed for NONE effect.");
+    if (r.x != 13 || r.y != 13 || r.width != 4 || r.height != 4) printFail("Dirty Rect", "Healed rect incorrect.");
+
+    printPass("Dirty Rect Healing (Engine)");
+}
+
+/**
+ * @brief Test 9: Allocation-Free Hot Path (Engine).
+ * After one warm-up frame per effect, moving the lens must not touch the heap.
+ */
+void runAllocationFreeTest() {
+    int w = 64, h = 64;
+    GlitchEngine engine;
+    engine.setThreadCount(1); // Worker instances warm up on whichever band they steal
+    engine.loadBox(w, h);
+
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    for (int i = 0; i < w * h; i++) original[i] = mkPixel(static_cast<uint8_t>(i % 251));
+
+    for (int id = 1; id < kEffectTypeCount; id++) {
+        // Warm-up: creates the effect instance and grows its scratch storage.
+        engine.renderFrame(32, 32, 16, id, 20.0f);
+
+        size_t before = AllocationCounter::count();
+        for (int step = 0; step < 8; step++) {
+            engine.renderFrame(24 + step * 2, 30 + step, 16, id, 20.0f);
+        }
+        size_t allocations = AllocationCounter::count() - before;
+
+        if (allocations != 0) {
+            printFail("Allocation-Free Hot Path",
+                      "Effect id " + std::to_string(id) + " allocated " + std::to_string(allocations) + " times.");
+        }
+    }
+
+    printPass("Allocation-Free Hot Path (Engine)");
+}
+
+/**
+ * @brief Test 10: Halo Snapshot Equivalence.
+ * Rendering in place (from a region-plus-halo snapshot) must give exactly the
+ * same result as rendering from the full clean source image.
+ */
+void runHaloSnapshotTest() {
+    int w = 48, h = 40;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) image[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i * 29), 255};
+
+    ChromaticEffect chromatic;
+    SwirlEffect swirl;
+    RippleEffect ripple;
+    SobelEffect sobel;
+    GaussianBlurEffect blur;
+    SharpenEffect sharpen;
+    EmbossEffect emboss;
+    IEffect* effects[] = {&chromatic, &swirl, &ripple, &sobel, &blur, &sharpen, &emboss};
+
+    // One lens in the middle, one hanging over the top-left corner
+    int centers[][2] = {{24, 20}, {3, 2}};
+
+    RenderQuality qualities[] = {RenderQuality::Drag, RenderQuality::Final};
+
+    for (IEffect* effect : effects) {
+        for (auto& c : centers) for (RenderQuality quality : qualities) {
+            EffectParams params = {30.0f, true, c[0], c[1], 12};
+            params.quality = quality;
+            Region region = clipRegion({c[0] - 12, c[1] - 12, 24, 24}, w, h);
+
+            std::vector<Pixel> inPlace = image;
+            effect->apply(inPlace, w, h, region, params);
+
+            std::vector<Pixel> fromSource = image;
+            effect->apply(SourceView::whole(image.data(), w, h), ImageView::whole(fromSource.data(), w, h), region, params);
+
+            for (int i = 0; i < w * h; i++) {
+                if (inPlace[i].r != fromSource[i].r || inPlace[i].g != fromSource[i].g || inPlace[i].b != fromSource[i].b) {
+                    printFail("Halo Snapshot", "In-place result differs from source-view result.");
+                }
+            }
+        }
+    }
+
+    printPass("Halo Snapshot Equivalence");
+}
+
+/**
+ * @brief Test 11: Effect Chain (Engine).
+ * A chain with fused point-wise groups must match applying every stage in
+ * sequence, and its dirty rect must cover every stage.
+ */
+void runEffectChainTest() {
+    int w = 40, h = 30;
+    GlitchEngine engine;
+    engine.loadBox(w, h);
+
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 5), static_cast<uint8_t>(i * 11), 255};
+    std::vector<Pixel> expected(original, original + w * h);
+
+    EffectStage stages[] = {
+        {EffectType::INVERT,    {60.0f, true, 20, 15, 10}},
+        {EffectType::SOLARIZE,  {40.0f, true, 22, 14, 8}},
+        {EffectType::CHROMATIC, {3.0f,  true, 20, 15, 10}},
+        {EffectType::INVERT,    {100.0f, true, 18, 16, 12}},
+        {EffectType::SWIRL,     {30.0f, true, 20, 15, 10}},
+    };
+
+    InvertEffect invert;
+    SolarizeEffect solarize;
+    ChromaticEffect chromatic;
+    SwirlEffect swirl;
+    IEffect* sequential[] = {&invert, &solarize, &chromatic, &invert, &swirl};
+    Region expectedDirty = {0, 0, 0, 0};
+    for (int i = 0; i < 5; i++) {
+        Region region = lensRegion(stages[i].params, w, h);
+        sequential[i]->apply(expected, w, h, region, stages[i].params);
+        expectedDirty = unionRegion(expectedDirty, region);
+    }
+
+    engine.renderFrame(-100, -100, 0, 0, 0); // Heal the fresh display buffer
+    engine.renderEffects(stages, 5);
+
+    for (int i = 0; i < w * h; i++) {
+        if (display[i].r != expected[i].r || display[i].g != expected[i].g || display[i].b != expected[i].b) {
+            printFail("Effect Chain", "Chain output differs from sequential application.");
+        }
+    }
+
+    Region r = engine.getDirtyRect();
+    if (r.x != expectedDirty.x || r.y != expectedDirty.y || r.width != expectedDirty.width || r.height != expectedDirty.height) {
+        printFail("Effect Chain", "Dirty rect does not cover all stages.");
+    }
+
+    printPass("Effect Chain (Engine)");
+}
+
+/**
+ * @brief Test 12: SIMD Point-wise Kernels.
+ * The vectorized spans must be bit-exact with the scalar reference for every
+ * span length (including non multiple-of-4 tails) and a range of intensities.
+ */
+void runSimdBitExactTest() {
+    const int maxCount = 37;
+    std::vector<Pixel> src(maxCount), simdOut(maxCount), scalarOut(maxCount);
+    for (int i = 0; i < maxCount; i++) {
+        src[i] = {static_cast<uint8_t>(i * 37 + 11), static_cast<uint8_t>(i * 101 + 3), static_cast<uint8_t>(i * 59), static_cast<uint8_t>(255 - i)};
+    }
+
+    InvertEffect invert;
+    SolarizeEffect solarize;
+    RGBNoiseEffect noise;
+    float intensities[] = {0.0f, 1.0f, 17.0f, 50.0f, 73.5f, 100.0f};
+
+    for (float intensity : intensities) {
+        EffectParams params = {intensity, false, 0, 0, 0};
+        for (int count = 0; count <= maxCount; count++) {
+            invert.processSpan(src.data(), simdOut.data(), count, 0, 0, params);
+            InvertEffect::processSpanScalar(src.data(), scalarOut.data(), count, InvertEffect::getWeight(params));
+            if (std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(Pixel)) != 0) printFail("SIMD Kernels", "Invert differs from scalar.");
+
+            solarize.processSpan(src.data(), simdOut.data(), count, 0, 0, params);
+            SolarizeEffect::processSpanScalar(src.data(), scalarOut.data(), count, SolarizeEffect::getThreshold(params));
+            if (std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(Pixel)) != 0) printFail("SIMD Kernels", "Solarize differs from scalar.");
+
+            noise.processSpan(src.data(), simdOut.data(), count, 3, 5, params);
+            RGBNoiseEffect::processSpanScalar(src.data(), scalarOut.data(), count, 3, 5, params);
+            if (std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(Pixel)) != 0) printFail("SIMD Kernels", "RGB Noise differs from scalar.");
+        }
+    }
+
+    printPass("SIMD Point-wise Kernels");
+}
+
+/**
+ * @brief Test 13: Lens Mask Spans and Feathering.
+ * Row spans must cover exactly the pixels of the circle test, and a feathered
+ * chain (fused point-wise path) must match sequential feathered applies.
+ */
+void runLensMaskTest() {
+    int w = 40, h = 40;
+    LensMask mask;
+    for (int radius = 0; radius <= 25; radius++) {
+        EffectParams params = {1.0f, true, 17, 21, radius};
+        mask.update(params, lensRegion(params, w, h));
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                int dx = x - 17, dy = y - 21;
+                bool inside = dx * dx + dy * dy <= radius * radius && x >= 17 - radius && y >= 21 - radius
+                              && x < 17 + radius && y < 21 + radius;
+                if (mask.contains(x, y) != inside) printFail("Lens Mask", "Span does not match the circle test.");
+            }
+        }
+    }
+
+    // Coverage falls off monotonically across the soft edge
+    EffectParams soft = {1.0f, true, 20, 20, 15, 6};
+    mask.update(soft, lensRegion(soft, w, h));
+    int previous = LensMask::kFullCoverage;
+    for (int x = 20; x < 35; x++) {
+        int cov = mask.coverage(x, 20);
+        if (cov > previous) printFail("Lens Mask", "Feather coverage is not monotonic.");
+        previous = cov;
+    }
+    if (mask.coverage(20, 20) != LensMask::kFullCoverage || mask.coverage(34, 20) >= LensMask::kFullCoverage / 4) {
+        printFail("Lens Mask", "Feather coverage endpoints incorrect.");
+    }
+
+    // Fused chain with a soft edge vs. applying each stage on its own
+    GlitchEngine engine;
+    engine.loadBox(w, h);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i), 255};
+    std::vector<Pixel> expected(original, original + w * h);
+
+    EffectStage stages[] = {
+        {EffectType::INVERT,   {100.0f, true, 20, 20, 15, 6}},
+        {EffectType::SOLARIZE, {60.0f, true, 18, 22, 12, 4}},
+    };
+    InvertEffect invert;
+    SolarizeEffect solarize;
+    invert.apply(expected, w, h, lensRegion(stages[0].params, w, h), stages[0].params);
+    solarize.apply(expected, w, h, lensRegion(stages[1].params, w, h), stages[1].params);
+
+    engine.renderEffects(stages, 2);
+    if (std::memcmp(display, expected.data(), w * h * sizeof(Pixel)) != 0) {
+        printFail("Lens Mask", "Feathered fused chain differs from sequential applies.");
+    }
+
+    printPass("Lens Mask Spans & Feathering");
+}
+
+/**
+ * @brief Test 14: Thread-Count Determinism.
+ * A lens large enough to be split into bands must render exactly the same
+ * with one thread as with several, for every effect and for a fused chain.
+ */
+void runThreadDeterminismTest() {
+    int w = 320, h = 300;
+    GlitchEngine single, threaded;
+    single.setThreadCount(1);
+    threaded.setThreadCount(4);
+
+    GlitchEngine* engines[] = {&single, &threaded};
+    for (GlitchEngine* engine : engines) {
+        engine->loadBox(w, h);
+        Pixel* original = reinterpret_cast<Pixel*>(engine->getOriginalPointer());
+        for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i / 3), static_cast<uint8_t>(i * 13), 255};
+    }
+    const Pixel* singleOut = reinterpret_cast<Pixel*>(single.getDisplayPointer());
+    const Pixel* threadedOut = reinterpret_cast<Pixel*>(threaded.getDisplayPointer());
+
+    int feathers[] = {0, 9};
+    for (int feather : feathers) {
+        for (int id = 1; id < kEffectTypeCount; id++) {
+            for (GlitchEngine* engine : engines) {
+                engine->setFeather(feather);
+                engine->renderFrame(150, 140, 130, id, 40.0f);
+            }
+            if (std::memcmp(singleOut, threadedOut, w * h * sizeof(Pixel)) != 0) {
+                printFail("Thread Determinism", "Effect id " + std::to_string(id) + " depends on the thread count.");
+            }
+        }
+    }
+
+    EffectStage stages[] = {
+        {EffectType::INVERT,    {60.0f, true, 160, 150, 140, 5}},
+        {EffectType::SOLARIZE,  {40.0f, true, 150, 150, 120, 5}},
+        {EffectType::SWIRL,     {30.0f, true, 160, 150, 140, 5}},
+        {EffectType::MOSAIC,    {50.0f, true, 160, 150, 140, 5}},
+        {EffectType::PIXEL_SORT, {50.0f, true, 160, 150, 140, 5}},
+    };
+    single.renderEffects(stages, 5);
+    threaded.renderEffects(stages, 5);
+    if (std::memcmp(singleOut, threadedOut, w * h * sizeof(Pixel)) != 0) {
+        printFail("Thread Determinism", "Chain output depends on the thread count.");
+    }
+
+    printPass("Thread-Count Determinism");
+}
+
+/**
+ * @brief Test 15: Convolution Kernels.
+ * The vectorized weighted sum and 3x3 kernel must be bit-exact with their
+ * scalar references, Sobel must match the direct operator, normalized kernels
+ * must leave a flat image unchanged, and edge filters must respond to a step edge.
+ */
+void runConvolutionTest() {
+    // SIMD vs scalar for every tap count and span length
+    const int maxCount = 37, maxTaps = 2 * SeparableKernel::kMaxRadius + 1;
+    std::vector<Pixel> src(maxCount + maxTaps), simdOut(maxCount), scalarOut(maxCount);
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = {static_cast<uint8_t>(i * 37 + 11), static_cast<uint8_t>(i * 101 + 3), static_cast<uint8_t>(255 - i * 59), static_cast<uint8_t>(i * 5)};
+    }
+    for (int radius = 0; radius <= SeparableKernel::kMaxRadius; radius++) {
+        SeparableKernel kernel = SeparableKernel::gaussian(radius);
+        int sum = 0;
+        for (int k = 0; k <= 2 * radius; k++) sum += kernel.weights[k];
+        if (sum != 256) printFail("Convolution", "Gaussian weights do not sum to 256.");
+
+        const Pixel* inputs[maxTaps];
+        for (int k = 0; k <= 2 * radius; k++) inputs[k] = src.data() + k;
+        for (int count = 0; count <= maxCount; count++) {
+            Convolution::weightedSum(inputs, kernel.weights, 2 * radius + 1, simdOut.data(), count);
+            Convolution::weightedSumScalar(inputs, kernel.weights, 2 * radius + 1, scalarOut.data(), 0, count);
+            if (std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(Pixel)) != 0) {
+                printFail("Convolution", "Weighted sum differs from scalar.");
+            }
+        }
+    }
+
+    // 3x3 kernels: 32-bit SIMD sums vs scalar, including weights past 16-bit products
+    const int sharpenKernel[9] = {0, -512, 0, -512, 2304, -512, 0, -512, 0};
+    const int embossKernel[9] = {-1024, -512, 0, -512, 256, 512, 0, 512, 1024};
+    const int signedKernel[9] = {-32768, 32767, 3, -7, 1, 0, 12, -300, 9};
+    std::vector<Pixel> rowsIn(3 * (maxCount + 2));
+    for (size_t i = 0; i < rowsIn.size(); i++) {
+        rowsIn[i] = {static_cast<uint8_t>(i * 53 + 7), static_cast<uint8_t>(i * 29), static_cast<uint8_t>(255 - i * 17), static_cast<uint8_t>(i * 3)};
+    }
+    const Pixel* const rows3[3] = {rowsIn.data(), rowsIn.data() + maxCount + 2, rowsIn.data() + 2 * (maxCount + 2)};
+    for (const int (*kernel)[9] : {&sharpenKernel, &embossKernel, &signedKernel}) {
+        for (int shift : {0, 8, 12}) {
+            for (int count = 0; count <= maxCount; count++) {
+                Convolution::kernelRow(rows3, *kernel, shift, 128, simdOut.data(), count);
+                Convolution::kernelRowScalar(rows3, *kernel, shift, 128, scalarOut.data(), 0, count);
+                if (std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(Pixel)) != 0) {
+                    printFail("Convolution", "3x3 kernel differs from scalar.");
+                }
+            }
+        }
+    }
+
+    // Sobel passes vs. the direct 3x3 operator with an exact square root
+    {
+        int sw = 45, sh = 23;
+        std::vector<Pixel> noisy(sw * sh);
+        for (int i = 0; i < sw * sh; i++) {
+            noisy[i] = {static_cast<uint8_t>((i * 97) ^ (i >> 3)), static_cast<uint8_t>(i * 31), static_cast<uint8_t>((i * i) >> 2), 255};
+        }
+        auto lumaAt = [&](int x, int y) {
+            x = std::max(0, std::min(sw - 1, x));
+            y = std::max(0, std::min(sh - 1, y));
+            return static_cast<int>(noisy[y * sw + x].getLuma8());
+        };
+        std::vector<Pixel> edges = noisy;
+        SobelEffect sobel;
+        Region area = {3, 2, 40, 20};
+        sobel.apply(edges, sw, sh, area, {10.0f, true, 24, 12, 15});
+        LensMask lens;
+        lens.update({10.0f, true, 24, 12, 15}, area);
+        for (int y = 0; y < sh; y++) {
+            for (int x = 0; x < sw; x++) {
+                Pixel expected = noisy[y * sw + x];
+                if (lens.contains(x, y)) {
+                    int gx = (lumaAt(x + 1, y - 1) + 2 * lumaAt(x + 1, y) + lumaAt(x + 1, y + 1)) - (lumaAt(x - 1, y - 1) + 2 * lumaAt(x - 1, y) + lumaAt(x - 1, y + 1));
+                    int gy = (lumaAt(x - 1, y + 1) + 2 * lumaAt(x, y + 1) + lumaAt(x + 1, y + 1)) - (lumaAt(x - 1, y - 1) + 2 * lumaAt(x, y - 1) + lumaAt(x + 1, y - 1));
+                    uint8_t v = static_cast<uint8_t>(std::min<long long>(255, isqrt(static_cast<long long>(gx) * gx + static_cast<long long>(gy) * gy)));
+                    expected = {v, v, v, 255};
+                }
+                if (std::memcmp(&edges[y * sw + x], &expected, sizeof(Pixel)) != 0) printFail("Convolution", "Sobel magnitude is wrong.");
+            }
+        }
+    }
+
+    // Flat image: blur, sharpen and emboss are identities (also at the image border)
+    int w = 24, h = 20;
+    std::vector<Pixel> flat(w * h, Pixel{90, 140, 200, 255});
+    GaussianBlurEffect blur;
+    SharpenEffect sharpen;
+    EmbossEffect emboss;
+    IEffect* normalized[] = {&blur, &sharpen, &emboss};
+    for (IEffect* effect : normalized) {
+        std::vector<Pixel> out = flat;
+        effect->apply(out, w, h, {0, 0, w, h}, {80.0f, false, 0, 0, 0});
+        if (std::memcmp(out.data(), flat.data(), w * h * sizeof(Pixel)) != 0) {
+            printFail("Convolution", "Normalized kernel changed a flat image.");
+        }
+    }
+
+    // Vertical step edge: Sobel lights up next to it and stays dark elsewhere
+    std::vector<Pixel> step(w * h);
+    for (int i = 0; i < w * h; i++) step[i] = mkPixel((i % w) < w / 2 ? 0 : 255);
+    SobelEffect sobel;
+    sobel.apply(step, w, h, {0, 0, w, h}, {10.0f, false, 0, 0, 0});
+    if (step[5 * w + w / 2].r != 255 || step[5 * w + 2].r != 0) printFail("Convolution", "Sobel missed the step edge.");
+
+    printPass("Convolution Kernels");
+}
+
+/**
+ * @brief Test 16: Cached Luma Plane (Engine).
+ * Luma-driven effects must give the same result from the engine's cached
+ * plane as when converting pixels themselves, also after the original is
+ * edited and invalidated.
+ */
+void runLumaPlaneTest() {
+    int w = 48, h = 40;
+    GlitchEngine engine;
+    engine.loadBox(w, h);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 11), 255};
+
+    SobelEffect sobel;
+    PixelSortEffect sort;
+    std::pair<EffectType, IEffect*> effects[] = {{EffectType::SOBEL, &sobel}, {EffectType::PIXEL_SORT, &sort}};
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            // Edit part of the original after the plane was built
+            for (int y = 5; y < 25; y++) {
+                for (int x = 10; x < 30; x++) original[y * w + x] = mkPixel(static_cast<uint8_t>(x * y));
+            }
+            engine.invalidateOriginal(10, 5, 20, 20);
+        }
+
+        for (auto& entry : effects) {
+            EffectParams params = {60.0f, true, 20, 18, 15};
+            std::vector<Pixel> expected(original, original + w * h);
+            entry.second->apply(expected, w, h, lensRegion(params, w, h), params);
+
+            engine.renderFrame(20, 18, 15, static_cast<int>(entry.first), 60.0f);
+            if (std::memcmp(display, expected.data(), w * h * sizeof(Pixel)) != 0) {
+                printFail("Luma Plane", "Cached luma gives a different result than per-pixel conversion.");
+            }
+        }
+    }
+
+    printPass("Cached Luma Plane (Engine)");
+}
+
+/**
+ * @brief Test 17: Displacement Map Cache.
+ * After the lens moves, a warm (cached) Swirl/Ripple must render exactly
+ * like a fresh instance and like the direct per-pixel field evaluation.
+ * A map shared by several threads must evaluate each row once, and a
+ * full-image Swirl (uncached) must follow the exact field far from the center.
+ */
+void runDisplacementCacheTest() {
+    int w = 64, h = 56;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) image[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i * 29), 255};
+    SourceView source = SourceView::whole(image.data(), w, h);
+
+    SwirlEffect warmSwirl, coldSwirl;
+    RippleEffect warmRipple, coldRipple;
+    IEffect* warm[] = {&warmSwirl, &warmRipple};
+    IEffect* cold[] = {&coldSwirl, &coldRipple};
+
+    for (int e = 0; e < 2; e++) {
+        EffectParams first = {45.0f, true, 20, 20, 14};
+        std::vector<Pixel> scratch = image;
+        warm[e]->apply(source, ImageView::whole(scratch.data(), w, h), lensRegion(first, w, h), first);
+
+        EffectParams moved = {45.0f, true, 41, 33, 14};
+        Region region = lensRegion(moved, w, h);
+        std::vector<Pixel> cached = image, fresh = image, direct = image;
+        warm[e]->apply(source, ImageView::whole(cached.data(), w, h), region, moved);
+        cold[e]->apply(source, ImageView::whole(fresh.data(), w, h), region, moved);
+
+        // Direct evaluation of the same field, no cache involved
+        for (int y = region.y; y < region.y + region.height; y++) {
+            for (int x = region.x; x < region.x + region.width; x++) {
+                int dx = x - moved.centerX, dy = y - moved.centerY;
+                if (dx * dx + dy * dy > moved.radius * moved.radius) continue;
+                Displacement d = (e == 0) ? SwirlEffect::getDisplacement(dx, dy, moved) : RippleEffect::getDisplacement(dx, dy, moved);
+                int sx = std::max(0, std::min(w - 1, x + d.wholeX()));
+                int sy = std::max(0, std::min(h - 1, y + d.wholeY()));
+                direct[y * w + x] = image[sy * w + sx];
+            }
+        }
+
+        if (std::memcmp(cached.data(), fresh.data(), w * h * sizeof(Pixel)) != 0 ||
+            std::memcmp(cached.data(), direct.data(), w * h * sizeof(Pixel)) != 0) {
+            printFail("Displacement Cache", "Cached field differs after moving the lens.");
+        }
+    }
+
+    // One map shared by several threads: every row is evaluated exactly once
+    {
+        EffectParams lens = {45.0f, true, 0, 0, 200};
+        DisplacementMap shared;
+        std::atomic<int> evaluations{0};
+        std::atomic<int> wrong{0};
+        TileScheduler pool(4);
+        for (int frame = 0; frame < 2; frame++) {
+            pool.run(16, [&](int task, int) {
+                shared.update(lens);
+                for (int i = 0; i <= 2 * lens.radius; i++) {
+                    int dy = (i + task * 7) % (2 * lens.radius + 1) - lens.radius; // Workers start on different rows
+                    auto field = [&](int dx, int fy) { evaluations++; return SwirlEffect::getDisplacement(dx, fy, lens); };
+                    const Displacement* row = shared.row(dy, field);
+                    if (!row) continue; // Another worker is filling it
+                    for (int dx = -lens.radius; dx <= lens.radius; dx++) {
+                        Displacement d = SwirlEffect::getDisplacement(dx, dy, lens);
+                        if (row[dx].x != d.x || row[dx].y != d.y) wrong++;
+                    }
+                }
+            });
+        }
+        int side = 2 * lens.radius + 1;
+        if (wrong > 0) printFail("Displacement Cache", "Shared map returned a wrong row.");
+        if (evaluations != side * side) printFail("Displacement Cache", "Shared map evaluated rows more than once.");
+    }
+
+    // Full-image Swirl (radius 1.5 x width, as the editor and glitch_batch use):
+    // offsets reach thousands of pixels and must not saturate.
+    int bw = 3000, bh = 200;
+    std::vector<Pixel> ramp(bw * bh);
+    for (int y = 0; y < bh; y++) {
+        for (int x = 0; x < bw; x++) ramp[y * bw + x] = {static_cast<uint8_t>(x / 12), static_cast<uint8_t>(y), 0, 255};
+    }
+    EffectParams full = {66.0f, true, bw / 2, bh / 2, bw * 3 / 2};
+    full.quality = RenderQuality::Final;
+    std::vector<Pixel> swirled = ramp;
+    SwirlEffect large;
+    large.apply(swirled, bw, bh, {0, 0, bw, bh}, full);
+
+    int farReads = 0;
+    for (int y = 0; y < bh; y++) {
+        for (int x = 0; x < bw; x++) {
+            // Exact field in double precision
+            double dx = x - full.centerX, dy = y - full.centerY;
+            double dist = std::sqrt(dx * dx + dy * dy);
+            double percent = (full.radius - dist) / full.radius;
+            double theta = percent * percent * full.intensity / 10.0;
+            double ox = dx * std::cos(theta) - dy * std::sin(theta) - dx;
+            double oy = dx * std::sin(theta) + dy * std::cos(theta) - dy;
+            double sx = x + ox, sy = y + oy;
+            if (sx < 2 || sx >= bw - 3 || sy < 2 || sy >= bh - 3) continue; // Clear of the clipping edge
+            if (std::abs(ox) > 2047) farReads++;
+            const Pixel& p = swirled[y * bw + x];
+            if (std::abs(p.r - sx / 12) > 1.5 || std::abs(p.g - sy) > 1.5) {
+                printFail("Displacement Cache", "Full-image Swirl samples from the wrong place.");
+            }
+        }
+    }
+    if (farReads == 0) printFail("Displacement Cache", "Full-image Swirl test has no far reads.");
+
+    printPass("Displacement Map Cache");
+}
+
+/**
+ * @brief Test 18: Quality Tiers.
+ * The drag-tier sine stays inside its documented error bound, bilinear
+ * sampling keeps flat areas flat, and the final tier blends neighbours.
+ */
+void runQualityTierTest() {
+    float maxError = 0;
+    for (float x = -10000.0f; x <= 10000.0f; x += 0.37f) {
+        maxError = std::max(maxError, std::fabs(fastSin(x) - static_cast<float>(std::sin(static_cast<double>(x)))));
+        maxError = std::max(maxError, std::fabs(fastCos(x) - static_cast<float>(std::cos(static_cast<double>(x)))));
+    }
+    if (maxError > 2e-4f) printFail("Quality Tiers", "fastSin/fastCos exceed the documented error bound.");
+
+    int w = 40, h = 40;
+    std::vector<Pixel> flat(w * h, Pixel{70, 130, 210, 255});
+    std::vector<Pixel> ramp(w * h);
+    for (int i = 0; i < w * h; i++) ramp[i] = mkPixel(static_cast<uint8_t>((i % w) * 6));
+
+    SwirlEffect swirl;
+    RippleEffect ripple;
+    IEffect* effects[] = {&swirl, &ripple};
+    for (IEffect* effect : effects) {
+        EffectParams params = {40.0f, true, 20, 20, 15};
+        params.quality = RenderQuality::Final;
+        Region region = lensRegion(params, w, h);
+
+        std::vector<Pixel> out = flat;
+        effect->apply(out, w, h, region, params);
+        if (std::memcmp(out.data(), flat.data(), w * h * sizeof(Pixel)) != 0) printFail("Quality Tiers", "Bilinear changed a flat image.");
+
+        // On a ramp the final tier produces values nearest sampling cannot (not multiples of 6)
+        out = ramp;
+        effect->apply(out, w, h, region, params);
+        bool blended = false;
+        for (const Pixel& p : out) blended = blended || (p.r % 6 != 0);
+        if (!blended) printFail("Quality Tiers", "Final tier did not interpolate.");
+    }
+
+    printPass("Quality Tiers (Drag / Final)");
+}
+
+/**
+ * @brief Test 19: Reproducible Random Effects (Engine).
+ * Randomized effects must change between frames, depend on the seed, and
+ * reproduce a past frame exactly from its frame index.
+ */
+void runReproducibleNoiseTest() {
+    int w = 60, h = 50;
+    GlitchEngine engine;
+    engine.loadBox(w, h);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    const Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 5), static_cast<uint8_t>(i * 9), static_cast<uint8_t>(i), 255};
+
+    int ids[] = {static_cast<int>(EffectType::JITTER), static_cast<int>(EffectType::SCANLINE), static_cast<int>(EffectType::RGB_NOISE)};
+    for (int id : ids) {
+        engine.setSeed(1234);
+        engine.renderFrame(30, 25, 20, id, 30.0f);
+        std::vector<Pixel> first(display, display + w * h);
+        uint32_t firstIndex = engine.getFrameIndex();
+
+        engine.renderFrame(30, 25, 20, id, 30.0f);
+        if (std::memcmp(display, first.data(), w * h * sizeof(Pixel)) == 0) printFail("Reproducible Noise", "Noise did not change between frames.");
+
+        engine.setFrameIndex(firstIndex);
+        engine.renderFrame(30, 25, 20, id, 30.0f);
+        if (std::memcmp(display, first.data(), w * h * sizeof(Pixel)) != 0) printFail("Reproducible Noise", "Frame could not be reproduced from its index.");
+
+        engine.setSeed(99);
+        engine.setFrameIndex(firstIndex);
+        engine.renderFrame(30, 25, 20, id, 30.0f);
+        if (std::memcmp(display, first.data(), w * h * sizeof(Pixel)) == 0) printFail("Reproducible Noise", "Seed has no effect.");
+    }
+
+    printPass("Reproducible Random Effects (Engine)");
+}
+
+/**
+ * @brief Test 20: Frame Statistics.
+ * Recorded frames report sane aggregates, the ring keeps only the last
+ * kCapacity frames, per-effect pixels add up, reset clears everything, and
+ * reduced previews and linear-light chains are recorded like other frames.
+ */
+void runFrameStatsTest() {
+#if GLITCH_FRAME_STATS
+    int w = 64, h = 48;
+    GlitchEngine engine;
+    engine.setThreadCount(1);
+    engine.loadBox(w, h);
+
+    FrameStats empty = engine.getFrameStats();
+    if (empty.count != 0 || empty.totalMs.max != 0) printFail("Frame Stats", "New engine reports frames.");
+
+    // 10 x 10 lens box fully inside the image
+    int frames = FrameStatsRecorder::kCapacity + 10;
+    for (int i = 0; i < frames; i++) engine.renderFrame(20, 20, 5, static_cast<int>(EffectType::INVERT), 50.0f);
+
+    FrameStats stats = engine.getFrameStats();
+    if (stats.count != FrameStatsRecorder::kCapacity) printFail("Frame Stats", "Ring buffer did not cap the frame count.");
+    if (stats.pixels.p50 != 100 || stats.pixels.max != 100) printFail("Frame Stats", "Pixel count per frame is wrong.");
+    if (stats.bytesCopied.p50 != 100 * sizeof(Pixel)) printFail("Frame Stats", "Healing bytes are wrong.");
+
+    const StatSummary* times[] = {&stats.healMs, &stats.setupMs, &stats.applyMs, &stats.totalMs};
+    for (const StatSummary* t : times) {
+        if (t->mean < 0 || t->p50 > t->p95 || t->p95 > t->p99 || t->p99 > t->max) printFail("Frame Stats", "Percentiles are not ordered.");
+    }
+    if (stats.totalMs.max + 1e-6 < stats.applyMs.max) printFail("Frame Stats", "Total is smaller than one phase.");
+
+    if (engine.getEffectPixels(static_cast<int>(EffectType::INVERT)) != 100.0 * frames) printFail("Frame Stats", "Per-effect pixel total is wrong.");
+    if (engine.getEffectPixels(static_cast<int>(EffectType::SWIRL)) != 0) printFail("Frame Stats", "Pixels counted for an unused effect.");
+
+    engine.resetFrameStats();
+    if (engine.getFrameStats().count != 0 || engine.getEffectPixels(static_cast<int>(EffectType::INVERT)) != 0) {
+        printFail("Frame Stats", "Reset did not clear the statistics.");
+    }
+
+    // Reduced previews count the level pixels (6 x 6 box at level 1), linear chains the lens box
+    engine.buildPyramid();
+    engine.setPreviewLevel(1);
+    engine.renderPreview(20, 20, 5, static_cast<int>(EffectType::INVERT), 50.0f);
+    engine.addChainStage(static_cast<int>(EffectType::INVERT), 50.0f);
+    LinearImage<Pixel16> linear;
+    if (!engine.renderChainLinear(20, 20, 5, linear)) printFail("Frame Stats", "Linear chain was refused.");
+    FrameStats mixed = engine.getFrameStats();
+    if (mixed.count != 2 || mixed.pixels.max != 100 || mixed.pixels.mean != 68) printFail("Frame Stats", "Preview or linear frames were not recorded.");
+    if (engine.getEffectPixels(static_cast<int>(EffectType::INVERT)) != 136) printFail("Frame Stats", "Preview or linear stages were not counted.");
+
+    printPass("Frame Statistics");
+#else
+    printPass("Frame Statistics (compiled out)");
+#endif
+}
+
+/**
+ * @brief Test 21: Tiled (Out-of-Core) Rendering.
+ * Every effect rendered strip by strip over TiledImages must match the engine
+ * pixel for pixel, single- and multi-threaded, and a memory-mapped tile file
+ * must keep its contents after being unmapped and mapped again.
+ */
+void runTiledRenderTest() {
+    int w = 700, h = 610; // Partial tiles on the right and bottom edges
+    GlitchEngine engine;
+    engine.setThreadCount(1);
+    engine.setFeather(3);
+    engine.loadBox(w, h);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.getOriginalPointer());
+    const Pixel* display = reinterpret_cast<Pixel*>(engine.getDisplayPointer());
+    for (int i = 0; i < w * h; i++) {
+        original[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>((i / w) * 3 + i % 5), static_cast<uint8_t>(i >> 4), 255};
+    }
+
+    TiledImage source, dest;
+    if (!source.allocate(w, h) || !dest.allocate(w, h)) printFail("Tiled Render", "Could not allocate tiles.");
+    source.writeRegion({0, 0, w, h}, original, w);
+
+    std::vector<Pixel> result(w * h);
+    TiledRenderer renderer;
+    TileScheduler schedulers[] = {TileScheduler(1), TileScheduler(3)};
+
+    for (int quality = 0; quality <= 1; quality++) {
+        engine.setQuality(quality);
+        for (int id = 1; id < kEffectTypeCount; id++) {
+            engine.renderFrame(330, 300, 290, id, 60.0f);
+
+            EffectParams params = {60.0f, true, 330, 300, 290};
+            params.feather = 3;
+            params.quality = quality ? RenderQuality::Final : RenderQuality::Drag;
+            params.frame = engine.getFrameIndex();
+
+            for (TileScheduler& scheduler : schedulers) {
+                dest.copyFrom(source);
+                renderer.apply(scheduler, static_cast<EffectType>(id), source, dest, params);
+                dest.readRegion({0, 0, w, h}, result.data(), w);
+                if (std::memcmp(result.data(), display, w * h * sizeof(Pixel)) != 0) {
+                    std::cout << "Effect " << getEffectName(static_cast<EffectType>(id)) << ", "
+                              << scheduler.getThreadCount() << " thread(s): ";
+                    printFail("Tiled Render", "Tiled output differs from the engine.");
+                }
+            }
+        }
+    }
+
+#if GLITCH_MMAP
+    const char* path = "/tmp/glitch_tiled_test.tiles";
+    {
+        TiledImage mapped;
+        if (!mapped.mapFile(path, w, h, true)) printFail("Tiled Render", "Could not map a tile file.");
+        mapped.copyFrom(dest);
+        mapped.flush();
+    }
+    TiledImage reopened;
+    if (!reopened.mapFile(path, w, h, false)) printFail("Tiled Render", "Could not reopen the tile file.");
+    reopened.readRegion({0, 0, w, h}, result.data(), w);
+    std::vector<Pixel> expected(w * h);
+    dest.readRegion({0, 0, w, h}, expected.data(), w);
+    if (std::memcmp(result.data(), expected.data(), w * h * sizeof(Pixel)) != 0) printFail("Tiled Render", "Mapped tiles lost their contents.");
+
+    TiledImage wrongSize;
+    if (wrongSize.mapFile(path, w + 300, h, false)) printFail("Tiled Render", "Mapped a file of the wrong size.");
+    std::remove(path);
+#endif
+
+    printPass("Tiled Out-of-Core Rendering");
+}
+
+/**
+ * @brief Test 22: Streaming Pipeline.
+ * Frames pushed through the threaded decode/process/encode pipeline must match
+ * rendering each frame directly, in order; Y4M frames must survive the
+ * YUV -> RGBA -> YUV round trip.
+ */
+void runStreamPipelineTest() {
+    int w = 80, h = 60, frameCount = 7;
+
+    StreamOptions options;
+    options.stages = {{EffectType::RGB_NOISE, 30.0f}, {EffectType::MOSAIC, 40.0f}, {EffectType::SOBEL, 50.0f}};
+    options.keyframes = {{0, 20, 20, 15}, {6, 60, 40, 30, 2.0f}};
+    options.seed = 7;
+    options.threads = 2;
+    options.buffers = 2; // Fewer slots than frames: slots must be recycled
+
+    std::vector<Pixel> frames(static_cast<size_t>(w) * h * frameCount);
+    for (size_t i = 0; i < frames.size(); i++) frames[i] = {static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i / 7), static_cast<uint8_t>(i * 11), 255};
+
+    std::stringstream rawIn, rawOut;
+    rawIn.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(Pixel));
+    FrameReader reader(rawIn);
+    reader.openRaw(w, h);
+    FrameWriter writer(rawOut, reader.getInfo());
+    StreamPipeline pipeline(options);
+    if (pipeline.run(reader, writer) != frameCount) printFail("Stream Pipeline", "Wrong number of frames written.");
+
+    std::string bytes = rawOut.str();
+    if (bytes.size() != frames.size() * sizeof(Pixel)) printFail("Stream Pipeline", "Wrong output size.");
+
+    // Reference: every frame rendered directly, single-threaded
+    TileScheduler scheduler(1);
+    EffectChain chain;
+    for (int f = 0; f < frameCount; f++) {
+        const Pixel* input = &frames[static_cast<size_t>(f) * w * h];
+        std::vector<Pixel> expected(input, input + w * h);
+        std::vector<EffectStage> stages;
+        for (const StreamStage& stage : options.stages) stages.push_back({stage.type, StreamPipeline::paramsAt(options, stage, f)});
+        chain.run(scheduler, stages.data(), static_cast<int>(stages.size()), SourceView::whole(input, w, h), ImageView::whole(expected.data(), w, h));
+
+        if (std::memcmp(bytes.data() + static_cast<size_t>(f) * w * h * sizeof(Pixel), expected.data(), w * h * sizeof(Pixel)) != 0) {
+            printFail("Stream Pipeline", "Frame differs from direct rendering.");
+        }
+    }
+
+    // Keyframes interpolate lens and intensity
+    EffectParams middle = StreamPipeline::paramsAt(options, options.stages[0], 3);
+    if (middle.centerX != 40 || middle.centerY != 30 || std::fabs(middle.intensity - 45.0f) > 1e-3f) printFail("Stream Pipeline", "Keyframe interpolation is wrong.");
+
+    // Y4M 4:2:0 (odd size) without effects: luma must round-trip within 2 levels
+    int yw = 33, yh = 17, cw = (yw + 1) / 2, ch = (yh + 1) / 2;
+    std::string header = "YUV4MPEG2 W33 H17 F25:1 Ip A1:1 C420jpeg";
+    std::string yuvFrame(static_cast<size_t>(yw) * yh + 2 * cw * ch, '\0');
+    for (int i = 0; i < yw * yh; i++) yuvFrame[i] = static_cast<char>(16 + (i * 5) % 220);
+    for (int i = 0; i < 2 * cw * ch; i++) yuvFrame[yw * yh + i] = static_cast<char>(128);
+    std::stringstream y4mIn, y4mOut;
+    y4mIn << header << "\n";
+    for (int f = 0; f < 3; f++) y4mIn << "FRAME\n" << yuvFrame;
+
+    FrameReader y4mReader(y4mIn);
+    if (!y4mReader.openY4M() || y4mReader.getInfo().width != yw || !y4mReader.getInfo().chroma420) printFail("Stream Pipeline", "Y4M header not parsed.");
+    FrameWriter y4mWriter(y4mOut, y4mReader.getInfo());
+    StreamPipeline passThrough(StreamOptions{});
+    if (passThrough.run(y4mReader, y4mWriter) != 3) printFail("Stream Pipeline", "Wrong number of Y4M frames.");
+
+    std::string encoded = y4mOut.str();
+    std::string expectedStart = header + "\nFRAME\n";
+    if (encoded.compare(0, expectedStart.size(), expectedStart) != 0) printFail("Stream Pipeline", "Y4M header not echoed.");
+    if (encoded.size() != header.size() + 1 + 3 * (6 + yuvFrame.size())) printFail("Stream Pipeline", "Wrong Y4M output size.");
+    for (int i = 0; i < yw * yh; i++) {
+        int before = static_cast<uint8_t>(yuvFrame[i]);
+        int after = static_cast<uint8_t>(encoded[expectedStart.size() + i]);
+        if (std::abs(before - after) > 2) printFail("Stream Pipeline", "Y4M luma did not round-trip.");
+    }
+
+    std::stringstream unsupported("YUV4MPEG2 W8 H8 C422\n");
+    FrameReader rejecting(unsupported);
+    if (rejecting.openY4M()) printFail("Stream Pipeline", "Accepted a 4:2:2 stream.");
+
+    printPass("Streaming Video Pipeline");
+}
+
+/**
+ * @brief Test 23: Image Codecs (Batch Tool).
+ * PAM and QOI round-trip RGBA exactly, PPM round-trips RGB, a hand-written
+ * QOI stream decodes per the specification, and malformed or oversized
+ * files are rejected.
+ */
+void runImageCodecTest() {
+    int w = 37, h = 23;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) {
+        // Runs, small diffs, luma diffs, large jumps and alpha changes
+        int x = i % w, y = i / w;
+        if (y < 3) image[i] = {10, 20, 30, 255};
+        else if (y < 8) image[i] = {static_cast<uint8_t>(x), static_cast<uint8_t>(x + 1), static_cast<uint8_t>(x), 255};
+        else if (y < 13) image[i] = {static_cast<uint8_t>(x * 9), static_cast<uint8_t>(x * 7), static_cast<uint8_t>(x * 8), 255};
+        else image[i] = {static_cast<uint8_t>(i * 31), static_cast<uint8_t>(i * 17), static_cast<uint8_t>(i * 5), static_cast<uint8_t>(i * 3)};
+    }
+
+    std::vector<uint8_t> encoded;
+    std::vector<Pixel> decoded(w * h);
+    ImageFormat formats[] = {ImageFormat::PAM, ImageFormat::QOI, ImageFormat::PPM};
+    for (ImageFormat format : formats) {
+        ImageCodec::encode(image.data(), w, h, format, encoded);
+        int dw = 0, dh = 0;
+        if (!ImageCodec::readHeader(encoded.data(), encoded.size(), format, dw, dh) || dw != w || dh != h) printFail("Image Codecs", "Header not read back.");
+        if (!ImageCodec::decode(encoded.data(), encoded.size(), format, decoded.data())) printFail("Image Codecs", "Decode failed.");
+
+        for (int i = 0; i < w * h; i++) {
+            Pixel expected = image[i];
+            if (format == ImageFormat::PPM) expected.a = 255;
+            if (std::memcmp(&decoded[i], &expected, sizeof(Pixel)) != 0) printFail("Image Codecs", "Round trip changed a pixel.");
+        }
+
+        // Truncated data must fail cleanly
+        if (ImageCodec::decode(encoded.data(), encoded.size() / 2, format, decoded.data())) printFail("Image Codecs", "Accepted truncated data.");
+    }
+
+    // 3x1 QOI by hand: RGB op, DIFF op (+1, 0, -1), RUN of 1, end marker
+    const uint8_t qoi[] = {'q', 'o', 'i', 'f', 0, 0, 0, 3, 0, 0, 0, 1, 3, 0,
+                           0xfe, 100, 150, 200, 0x40 | (3 << 4) | (2 << 2) | 1, 0xc0,
+                           0, 0, 0, 0, 0, 0, 0, 1};
+    Pixel three[3];
+    if (!ImageCodec::decode(qoi, sizeof(qoi), ImageFormat::QOI, three)) printFail("Image Codecs", "Reference QOI rejected.");
+    if (three[0].r != 100 || three[0].g != 150 || three[0].b != 200 || three[0].a != 255 ||
+        three[1].r != 101 || three[1].g != 150 || three[1].b != 199 || std::memcmp(&three[1], &three[2], sizeof(Pixel)) != 0) {
+        printFail("Image Codecs", "Reference QOI decoded wrongly.");
+    }
+
+    // Netpbm headers with comments; PAM grayscale expands to RGB
+    std::string pam = "P7\n# comment\nWIDTH 2\nHEIGHT 1\nDEPTH 1\nMAXVAL 255\nTUPLTYPE GRAYSCALE\nENDHDR\n";
+    pam += std::string("\x10\x80", 2);
+    Pixel gray[2];
+    if (!ImageCodec::decode(reinterpret_cast<const uint8_t*>(pam.data()), pam.size(), ImageFormat::PAM, gray) ||
+        gray[1].r != 0x80 || gray[1].b != 0x80 || gray[1].a != 255) {
+        printFail("Image Codecs", "Grayscale PAM decoded wrongly.");
+    }
+    std::string wide = "P6 2 1 65535\n";
+    int dw, dh;
+    if (ImageCodec::readHeader(reinterpret_cast<const uint8_t*>(wide.data()), wide.size(), ImageFormat::PPM, dw, dh)) printFail("Image Codecs", "Accepted a 16-bit PPM.");
+    // Sizes whose RGBA bytes do not fit size_t are rejected, e.g. 32768 x 32768 on 32-bit targets
+    size_t max32 = 0xffffffffu;
+    if (!ImageCodec::validSize(32767, 32767, max32) || ImageCodec::validSize(32768, 32768, max32) ||
+        ImageCodec::validSize(32769, 1) || ImageCodec::validSize(0, 5)) {
+        printFail("Image Codecs", "Size limits are wrong.");
+    }
+    const uint8_t huge[] = {'q', 'o', 'i', 'f', 0, 0, 0x80, 0, 0, 0, 0x80, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    if (ImageCodec::readHeader(huge, sizeof(huge), ImageFormat::QOI, dw, dh) != (sizeof(size_t) > 4)) printFail("Image Codecs", "32768 x 32768 header check ignores size_t.");
+    if (imageFormatFromPath("dir/Image.QOI") != ImageFormat::QOI || imageFormatFromPath("a.png") != ImageFormat::Unknown) printFail("Image Codecs", "Extension mapping is wrong.");
+
+    printPass("Image Codecs (PPM / PAM / QOI)");
+}
+
+/**
+ * @brief Test 24: Image Ingest.
+ * beginIngest() hands out an aligned buffer, reuses it for images that are not
+ * larger, defers the display allocation to the first render, and the first
+ * frame after every load shows the new image outside the lens.
+ */
+void runIngestTest() {
+    GlitchEngine engine;
+    engine.setThreadCount(1);
+
+    size_t before = AllocationCounter::count();
+    uintptr_t address = engine.beginIngest(64, 48);
+    if (AllocationCounter::count() - before != 1) printFail("Image Ingest", "Ingest allocated more than the original buffer.");
+    if (address % AlignedBuffer<Pixel>::kAlignment != 0 || address != engine.getOriginalPointer()) printFail("Image Ingest", "Ingest buffer is not aligned.");
+
+    int sizes[][2] = {{64, 48}, {40, 30}, {64, 48}};
+    for (auto& size : sizes) {
+        int w = size[0], h = size[1];
+        before = AllocationCounter::count();
+        Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+        if (AllocationCounter::count() != before) printFail("Image Ingest", "Reloading a smaller or equal image allocated.");
+        for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i * 3 + w), static_cast<uint8_t>(i), static_cast<uint8_t>(h), 255};
+
+        engine.renderFrame(10, 10, 6, static_cast<int>(EffectType::INVERT), 100.0f);
+        const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                // Lens box is [4, 16) on both axes; everything else shows the new image
+                bool inBox = x >= 4 && x < 16 && y >= 4 && y < 16;
+                const Pixel& o = original[y * w + x];
+                const Pixel& d = display[y * w + x];
+                bool same = std::memcmp(&d, &o, sizeof(Pixel)) == 0;
+                if (!same && !(inBox && d.r == 255 - o.r)) printFail("Image Ingest", "First frame after a load is wrong.");
+                if (x == 10 && y == 10 && same) printFail("Image Ingest", "Lens center was not rendered.");
+            }
+        }
+        Region dirty = engine.getDirtyRect();
+        if (dirty.x != 0 || dirty.y != 0 || dirty.width != w || dirty.height != h) printFail("Image Ingest", "First frame must present the whole image.");
+    }
+
+    printPass("Zero-Copy Image Ingest");
+}
+
+/**
+ * @brief Test 25: Paint Undo.
+ * Dabs accumulate in the working image, undo/redo restore every stroke
+ * exactly, a small stroke costs far less than the tiles it touched, and the
+ * memory budget drops the oldest strokes.
+ */
+void runPaintUndoTest() {
+    int w = 300, h = 200;
+    GlitchEngine engine;
+    engine.setThreadCount(2);
+    Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+    for (int i = 0; i < w * h; i++) original[i] = {static_cast<uint8_t>(i % w), static_cast<uint8_t>(i / w), static_cast<uint8_t>(i * 7), 255};
+    std::vector<Pixel> source(original, original + w * h);
+
+    auto matches = [&](const std::vector<Pixel>& expected) {
+        return std::memcmp(original, expected.data(), expected.size() * sizeof(Pixel)) == 0;
+    };
+    auto displayMatchesOriginal = [&]() {
+        const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+        return std::memcmp(display, original, w * h * sizeof(Pixel)) == 0;
+    };
+
+    // Stroke 1: a few dabs along a line
+    engine.renderFrame(150, 100, 40, static_cast<int>(EffectType::SOLARIZE), 80.0f); // Hover lens, not committed
+    engine.beginStroke();
+    for (int x = 20; x <= 80; x += 10) engine.paintDab(x, 30, 8, static_cast<int>(EffectType::INVERT), 100.0f);
+    if (!engine.endStroke()) printFail("Paint Undo", "Stroke was not recorded.");
+    std::vector<Pixel> afterFirst(original, original + w * h);
+    if (original[30 * w + 50].r != 255 - source[30 * w + 50].r) printFail("Paint Undo", "Dab was not committed.");
+    if (std::memcmp(&original[100 * w + 150], &source[100 * w + 150], sizeof(Pixel)) != 0) printFail("Paint Undo", "Hover lens leaked into the image.");
+    if (!displayMatchesOriginal()) printFail("Paint Undo", "Display differs from the painted image.");
+
+    // Stroke 2 paints over stroke 1: inverting twice restores the source there
+    double firstMemory = engine.getUndoMemory();
+    engine.paintDab(50, 30, 8, static_cast<int>(EffectType::INVERT), 100.0f);
+    engine.endStroke();
+    std::vector<Pixel> afterSecond(original, original + w * h);
+    if (std::memcmp(&original[30 * w + 50], &source[30 * w + 50], sizeof(Pixel)) != 0) printFail("Paint Undo", "Dabs do not accumulate.");
+
+    // A 17 px dab touches at most 4 tiles of 64x64 RGBA (64 KB raw)
+    double secondCost = engine.getUndoMemory() - firstMemory;
+    if (firstMemory <= 0 || secondCost <= 0 || secondCost > 4096) printFail("Paint Undo", "Stroke deltas are not compact.");
+
+    if (!engine.undo() || !matches(afterFirst) || !displayMatchesOriginal()) printFail("Paint Undo", "Undo of stroke 2 failed.");
+    if (!engine.undo() || !matches(source) || !displayMatchesOriginal()) printFail("Paint Undo", "Undo of stroke 1 failed.");
+    if (engine.canUndo() || engine.undo()) printFail("Paint Undo", "Undo past the first stroke.");
+    if (!engine.redo() || !matches(afterFirst)) printFail("Paint Undo", "Redo of stroke 1 failed.");
+    if (!engine.redo() || !matches(afterSecond) || engine.canRedo()) printFail("Paint Undo", "Redo of stroke 2 failed.");
+
+    // A new stroke after an undo discards the redo step
+    engine.undo();
+    engine.paintDab(200, 150, 20, static_cast<int>(EffectType::MOSAIC), 60.0f);
+    engine.endStroke();
+    if (engine.canRedo()) printFail("Paint Undo", "Redo survived a new stroke.");
+    engine.undo();
+    if (!matches(afterFirst)) printFail("Paint Undo", "Undo after a branch failed.");
+
+    // Budget: only the newest strokes that fit are kept
+    engine.setUndoBudget(secondCost * 3);
+    for (int i = 0; i < 6; i++) {
+        engine.paintDab(40 + i * 40, 150, 8, static_cast<int>(EffectType::INVERT), 100.0f);
+        engine.endStroke();
+    }
+    if (engine.getUndoMemory() > secondCost * 3) printFail("Paint Undo", "History exceeds its budget.");
+    int undone = 0;
+    while (engine.undo()) undone++;
+    if (undone < 1 || undone >= 6) printFail("Paint Undo", "Budget did not drop old strokes.");
+
+    // Shrinking the budget with everything undone drops redo steps from the
+    // newest end, so the remaining ones still redo onto the right image
+    std::vector<std::vector<Pixel>> redone;
+    while (engine.redo()) redone.emplace_back(original, original + w * h);
+    while (engine.undo()) {}
+    engine.setUndoBudget(engine.getUndoMemory() - 1);
+    if (!engine.canRedo() && undone > 1) printFail("Paint Undo", "Shrinking the budget dropped every redo step.");
+    for (size_t i = 0; engine.redo(); i++) {
+        if (i >= redone.size() - 1 || !matches(redone[i]) || !displayMatchesOriginal()) {
+            printFail("Paint Undo", "Redo after shrinking the budget corrupted the image.");
+        }
+    }
+
+    printPass("Paint Undo / Redo (XOR + RLE Tiles)");
+}
+
+/**
+ * @brief Test 26: Progressive Preview.
+ * The 2x2 downsampler matches the scalar formula at odd sizes and after partial
+ * updates; a reduced preview only touches the lens, refine() reproduces the
+ * full-resolution frame, pixel-length intensities scale with the level, and the
+ * automatic level follows the time budget.
+ */
+void runProgressivePreviewTest() {
+    // Pyramid levels against a direct scalar reference, including odd sizes
+    int pw = 75, ph = 41;
+    std::vector<Pixel> image(pw * ph);
+    for (int i = 0; i < pw * ph; i++) image[i] = {static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i * 7 + 3), static_cast<uint8_t>(i / 5), static_cast<uint8_t>(200 + i % 50)};
+
+    auto checkPyramid = [&](const MipPyramid& pyramid) {
+        const Pixel* below = image.data();
+        for (int level = 1; level < pyramid.getLevelCount(); ++level) {
+            int sw = pyramid.getWidth(level - 1), sh = pyramid.getHeight(level - 1);
+            for (int y = 0; y < pyramid.getHeight(level); ++y) {
+                for (int x = 0; x < pyramid.getWidth(level); ++x) {
+                    int x1 = std::min(2 * x + 1, sw - 1), y1 = std::min(2 * y + 1, sh - 1);
+                    const Pixel& p = below[2 * y * sw + 2 * x];
+                    const Pixel& q = below[2 * y * sw + x1];
+                    const Pixel& r = below[y1 * sw + 2 * x];
+                    const Pixel& t = below[y1 * sw + x1];
+                    const Pixel& got = pyramid.data(level)[y * pyramid.getWidth(level) + x];
+                    if (got.r != ((p.r + q.r + r.r + t.r + 2) >> 2) || got.a != ((p.a + q.a + r.a + t.a + 2) >> 2)) return false;
+                }
+            }
+            below = pyramid.data(level);
+        }
+        return true;
+    };
+
+    MipPyramid pyramid;
+    pyramid.reset(pw, ph);
+    if (pyramid.getLevelCount() != 3) printFail("Progressive Preview", "Unexpected number of levels.");
+    pyramid.update(image.data());
+    if (!checkPyramid(pyramid)) printFail("Progressive Preview", "Downsampled levels are wrong.");
+
+    for (int y = 10; y < 17; y++) for (int x = 30; x < 41; x++) image[y * pw + x] = {1, 2, 3, 4};
+    pyramid.invalidate({30, 10, 11, 7});
+    size_t written = pyramid.update(image.data());
+    if (!checkPyramid(pyramid) || written == 0 || written > 60) printFail("Progressive Preview", "Partial update is wrong.");
+
+    // Engine: forced level 2, then refine
+    int w = 400, h = 300;
+    GlitchEngine engine, reference;
+    Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+    Pixel* refOriginal = reinterpret_cast<Pixel*>(reference.beginIngest(w, h));
+    for (int i = 0; i < w * h; i++) original[i] = refOriginal[i] = {static_cast<uint8_t>(i % w / 2), static_cast<uint8_t>(i / w), 90, 255};
+    engine.buildPyramid();
+
+    engine.setPreviewLevel(2);
+    engine.renderPreview(200, 150, 60, static_cast<int>(EffectType::INVERT), 100.0f);
+    engine.renderPreview(120, 100, 50, static_cast<int>(EffectType::INVERT), 100.0f);
+    if (engine.getPreviewLevel() != 2) printFail("Progressive Preview", "Forced level ignored.");
+    const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            bool inBox = x >= 70 && x <= 170 && y >= 50 && y <= 150;
+            if (!inBox && std::memcmp(&display[y * w + x], &original[y * w + x], sizeof(Pixel)) != 0) printFail("Progressive Preview", "Preview touched pixels outside the lens.");
+        }
+    }
+    const Pixel& center = display[100 * w + 120];
+    if (std::abs((255 - center.r) - original[100 * w + 120].r) > 2 || std::abs((255 - center.g) - original[100 * w + 120].g) > 2) printFail("Progressive Preview", "Reduced lens content is wrong.");
+
+    if (!engine.refine() || engine.refine()) printFail("Progressive Preview", "refine() should run exactly once.");
+    reference.renderFrame(120, 100, 50, static_cast<int>(EffectType::INVERT), 100.0f);
+    const Pixel* refDisplay = reinterpret_cast<const Pixel*>(reference.getDisplayPointer());
+    if (std::memcmp(display, refDisplay, w * h * sizeof(Pixel)) != 0) printFail("Progressive Preview", "Refined frame differs from a full render.");
+
+    // Pixel-length intensities scale with the level: a level-1 chromatic preview
+    // matches the full render to within a pixel (red and blue run 1 per pixel)
+    int cw = 256, ch = 64;
+    GlitchEngine chromatic, chromaticRef;
+    Pixel* chromaticOriginal = reinterpret_cast<Pixel*>(chromatic.beginIngest(cw, ch));
+    Pixel* chromaticRefOriginal = reinterpret_cast<Pixel*>(chromaticRef.beginIngest(cw, ch));
+    for (int i = 0; i < cw * ch; i++) chromaticOriginal[i] = chromaticRefOriginal[i] = {static_cast<uint8_t>(i % cw), 128, static_cast<uint8_t>(255 - i % cw), 255};
+    chromatic.buildPyramid();
+    chromatic.setPreviewLevel(1);
+    chromatic.renderPreview(128, 32, 28, static_cast<int>(EffectType::CHROMATIC), 20.0f);
+    chromaticRef.renderFrame(128, 32, 28, static_cast<int>(EffectType::CHROMATIC), 20.0f);
+    const Pixel* preview = reinterpret_cast<const Pixel*>(chromatic.getDisplayPointer());
+    const Pixel* full = reinterpret_cast<const Pixel*>(chromaticRef.getDisplayPointer());
+    for (int y = 8; y < 56; y++) {
+        for (int x = 104; x < 152; x++) {
+            if ((x - 128) * (x - 128) + (y - 32) * (y - 32) > 24 * 24) continue; // Inside the lens, off its stepped rim
+            const Pixel& p = preview[y * cw + x];
+            const Pixel& q = full[y * cw + x];
+            if (std::abs(p.r - q.r) > 1 || std::abs(p.b - q.b) > 1) printFail("Progressive Preview", "Reduced chromatic offset does not match the full render.");
+        }
+    }
+
+    // Automatic level: a zero budget goes to the coarsest level, a huge one to full size
+    engine.setPreviewLevel(-1);
+    engine.setPreviewBudget(0);
+    engine.renderPreview(200, 150, 150, static_cast<int>(EffectType::SOBEL), 50.0f);
+    engine.renderPreview(210, 150, 150, static_cast<int>(EffectType::SOBEL), 50.0f);
+    if (engine.getPreviewLevel() != 5) printFail("Progressive Preview", "Zero budget did not pick the coarsest level.");
+    engine.setPreviewBudget(1e9);
+    engine.renderPreview(220, 150, 150, static_cast<int>(EffectType::SOBEL), 50.0f);
+    if (engine.getPreviewLevel() != 0) printFail("Progressive Preview", "Ample budget did not render at full size.");
+
+    printPass("Progressive Preview (Mip Pyramid)");
+}
+
+/**
+ * @brief Test 27: Resumable Rendering.
+ * beginFrame + step() slices give the same pixels as renderFrame for every
+ * effect, a newer frame or a synchronous render supersedes one in flight, and
+ * the dirty rectangles reported after each step keep a presented copy in sync.
+ */
+void runResumableRenderTest() {
+    int w = 600, h = 500;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) image[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>((i / w) * 3), static_cast<uint8_t>(i % w), 255};
+
+    auto load = [&](GlitchEngine& engine) {
+        Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+        std::memcpy(original, image.data(), image.size() * sizeof(Pixel));
+    };
+    // What a host would show: updated from getDirtyRect() after every call
+    auto present = [&](GlitchEngine& engine, std::vector<Pixel>& canvas) {
+        Region dirty = engine.getDirtyRect();
+        const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+        for (int y = dirty.y; y < dirty.y + dirty.height; y++) {
+            std::memcpy(&canvas[y * w + dirty.x], &display[y * w + dirty.x], dirty.width * sizeof(Pixel));
+        }
+    };
+    auto sameDisplay = [&](GlitchEngine& a, GlitchEngine& b) {
+        return std::memcmp(reinterpret_cast<const Pixel*>(a.getDisplayPointer()), reinterpret_cast<const Pixel*>(b.getDisplayPointer()), w * h * sizeof(Pixel)) == 0;
+    };
+
+    for (int threads : {1, 3}) {
+        for (int feather : {0, 6}) {
+            GlitchEngine sliced, reference;
+            sliced.setThreadCount(threads);
+            reference.setThreadCount(threads);
+            sliced.setFeather(feather);
+            reference.setFeather(feather);
+            load(sliced);
+            load(reference);
+
+            for (int id = 1; id < kEffectTypeCount; id++) {
+                int cx = 300 + id * 5, cy = 250 - id * 3;
+                sliced.beginFrame(cx, cy, 220, id, 60.0f);
+                int steps = 0;
+                bool halfway = false;
+                while (!sliced.step(0)) {
+                    steps++;
+                    halfway = halfway || (sliced.getProgress() > 0 && sliced.getProgress() < 1);
+                }
+                reference.renderFrame(cx, cy, 220, id, 60.0f);
+                if (!sliced.isComplete() || !sameDisplay(sliced, reference)) {
+                    printFail("Resumable Rendering", std::string("Sliced frame differs for ") + getEffectName(static_cast<EffectType>(id)));
+                }
+                if (id == static_cast<int>(EffectType::INVERT) && (steps < 2 || !halfway)) printFail("Resumable Rendering", "Large lens was not split into slices.");
+            }
+        }
+    }
+
+    // Superseding: a new frame before the old one completes, then a synchronous render
+    GlitchEngine engine, reference;
+    engine.setThreadCount(2);
+    load(engine);
+    load(reference);
+    std::vector<Pixel> canvas = image;
+
+    engine.beginFrame(200, 200, 150, static_cast<int>(EffectType::SWIRL), 70.0f);
+    engine.step(0);
+    present(engine, canvas);
+    engine.beginFrame(400, 300, 120, static_cast<int>(EffectType::GAUSSIAN_BLUR), 40.0f);
+    while (!engine.step(0)) present(engine, canvas);
+    present(engine, canvas);
+    reference.renderFrame(200, 200, 150, static_cast<int>(EffectType::SWIRL), 70.0f);
+    reference.renderFrame(400, 300, 120, static_cast<int>(EffectType::GAUSSIAN_BLUR), 40.0f);
+    if (!sameDisplay(engine, reference)) printFail("Resumable Rendering", "Superseded frame left marks.");
+    if (std::memcmp(canvas.data(), reinterpret_cast<const Pixel*>(engine.getDisplayPointer()), canvas.size() * sizeof(Pixel)) != 0) printFail("Resumable Rendering", "Dirty rectangles missed pixels.");
+
+    engine.beginFrame(100, 400, 200, static_cast<int>(EffectType::PIXEL_SORT), 50.0f);
+    engine.step(0);
+    present(engine, canvas);
+    engine.beginFrame(450, 100, 90, static_cast<int>(EffectType::SOBEL), 50.0f); // Healed, never stepped
+    engine.renderFrame(300, 250, 60, static_cast<int>(EffectType::INVERT), 100.0f);
+    present(engine, canvas);
+    if (!engine.isComplete() || !engine.step(0)) printFail("Resumable Rendering", "A synchronous render did not cancel the frame in flight.");
+    present(engine, canvas);
+    reference.setFrameIndex(engine.getFrameIndex());
+    reference.renderFrame(300, 250, 60, static_cast<int>(EffectType::INVERT), 100.0f);
+    if (!sameDisplay(engine, reference)) printFail("Resumable Rendering", "Cancelled frame left marks.");
+    if (std::memcmp(canvas.data(), reinterpret_cast<const Pixel*>(engine.getDisplayPointer()), canvas.size() * sizeof(Pixel)) != 0) printFail("Resumable Rendering", "Presented image is stale after a cancel.");
+
+    printPass("Resumable Rendering (begin / step)");
+}
+
+/**
+ * @brief Test 28: Summed-Area Table.
+ * Verifies rectangle sums against brute force (whole image and sub-area
+ * tables, odd sizes), incremental updates against a rebuild, Box Blur against
+ * a brute-force box mean, that effects give the same result with the
+ * engine's table attached as with their local one, and that paint strokes
+ * do not update the engine's table until they end.
+ */
+void runSummedAreaTest() {
+    int w = 37, h = 23;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) image[i] = {static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i / w * 11), static_cast<uint8_t>(i % w * 7), static_cast<uint8_t>(255 - i % 5)};
+    SourceView source = SourceView::whole(image.data(), w, h);
+
+    auto bruteSum = [&](int x0, int y0, int x1, int y1, int channel) {
+        uint32_t total = 0;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                const Pixel& p = image[y * w + x];
+                total += channel == 0 ? p.r : channel == 1 ? p.g : channel == 2 ? p.b : p.a;
+            }
+        }
+        return total;
+    };
+    auto checkSums = [&](const SummedAreaTable& table, const std::string& what) {
+        const Region& a = table.getArea();
+        for (int y0 = a.y; y0 < a.y + a.height; y0 += 3) {
+            for (int x0 = a.x; x0 < a.x + a.width; x0 += 2) {
+                for (int y1 = y0 + 1; y1 <= a.y + a.height; y1 += 4) {
+                    for (int x1 = x0 + 1; x1 <= a.x + a.width; x1 += 5) {
+                        uint32_t sums[4];
+                        table.sum(x0, y0, x1, y1, sums);
+                        for (int c = 0; c < 4; c++) {
+                            if (sums[c] != bruteSum(x0, y0, x1, y1, c)) printFail("Summed-Area Table", "Wrong rectangle sum (" + what + ").");
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    SummedAreaTable full, sub;
+    full.build(source, {0, 0, w, h});
+    checkSums(full, "whole image");
+    sub.build(source, {5, 3, 60, 11}); // Clipped to the image
+    if (sub.getArea().x != 5 || sub.getArea().width != w - 5 || sub.getArea().height != 11) printFail("Summed-Area Table", "Sub-area not clipped to the image.");
+    checkSums(sub, "sub-area");
+
+    Pixel mean = full.average(0, 0, 2, 2);
+    int expected = (image[0].r + image[1].r + image[w].r + image[w + 1].r + 2) / 4;
+    if (mean.r != expected) printFail("Summed-Area Table", "Average is not the rounded mean.");
+
+    // Incremental update after a change matches a fresh build
+    for (int y = 9; y < 14; y++) {
+        for (int x = 20; x < 26; x++) image[y * w + x] = mkPixel(static_cast<uint8_t>(x * y));
+    }
+    size_t written = full.update(source, {20, 9, 6, 5});
+    if (written != static_cast<size_t>(w - 20) * (h - 9)) printFail("Summed-Area Table", "Update did not stop at the change's top-left corner.");
+    checkSums(full, "after update");
+    if (full.update(source, {w + 4, 0, 3, 3}) != 0) printFail("Summed-Area Table", "Update outside the area wrote entries.");
+
+    // Box Blur: every pixel is the mean of its box, clipped to the image
+    BoxBlurEffect blur;
+    EffectParams params = {12.0f, false, 0, 0, 0}; // Radius 4
+    int radius = BoxBlurEffect::getRadius(params);
+    std::vector<Pixel> blurred = image;
+    blur.apply(blurred, w, h, {0, 0, w, h}, params);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int x0 = std::max(0, x - radius), x1 = std::min(w, x + radius + 1);
+            int y0 = std::max(0, y - radius), y1 = std::min(h, y + radius + 1);
+            uint32_t count = (x1 - x0) * (y1 - y0);
+            if (blurred[y * w + x].g != (bruteSum(x0, y0, x1, y1, 1) + count / 2) / count) printFail("Summed-Area Table", "Box Blur is not the box mean.");
+        }
+    }
+
+    // Engine table attached vs. local table: same pixels
+    SummedAreaTable attached;
+    attached.build(source, {0, 0, w, h});
+    SourceView withTable = source;
+    withTable.integral = &attached;
+    for (EffectType type : {EffectType::MOSAIC, EffectType::BOX_BLUR}) {
+        std::unique_ptr<IEffect> a = EffectFactory::createEffect(type);
+        std::unique_ptr<IEffect> b = EffectFactory::createEffect(type);
+        EffectParams lens = {9.0f, true, 18, 11, 9};
+        Region region = {9, 2, 19, 19};
+        std::vector<Pixel> outA = image, outB = image;
+        a->apply(withTable, ImageView::whole(outA.data(), w, h), region, lens);
+        b->apply(source, ImageView::whole(outB.data(), w, h), region, lens);
+        if (std::memcmp(outA.data(), outB.data(), outA.size() * sizeof(Pixel)) != 0) printFail("Summed-Area Table", std::string("Attached table changes ") + getEffectName(type));
+    }
+
+#if GLITCH_FRAME_STATS
+    // Paint strokes leave the engine's table stale (dabs use lens tables); the
+    // first frame after the stroke brings it up to date
+    int ew = 160, eh = 120;
+    GlitchEngine engine, reference;
+    Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(ew, eh));
+    for (int i = 0; i < ew * eh; i++) original[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i / ew * 3), static_cast<uint8_t>(i % ew), 255};
+    int boxBlur = static_cast<int>(EffectType::BOX_BLUR);
+    engine.renderFrame(80, 60, 20, boxBlur, 30.0f);
+    engine.resetFrameStats();
+    engine.beginStroke();
+    for (int i = 0; i < 8; i++) engine.paintDab(10 + i * 15, 20 + i * 5, 12, boxBlur, 30.0f);
+    size_t lensBytes = 41 * 41 * sizeof(Pixel); // Healing the largest lens box
+    if (engine.getFrameStats().bytesCopied.max > lensBytes) printFail("Summed-Area Table", "Paint dabs updated the engine's table.");
+    engine.endStroke();
+
+    Pixel* refOriginal = reinterpret_cast<Pixel*>(reference.beginIngest(ew, eh));
+    std::memcpy(refOriginal, original, ew * eh * sizeof(Pixel));
+    engine.resetFrameStats();
+    engine.renderFrame(70, 80, 30, boxBlur, 45.0f);
+    reference.renderFrame(70, 80, 30, boxBlur, 45.0f);
+    if (engine.getFrameStats().bytesCopied.max <= lensBytes) printFail("Summed-Area Table", "Table not updated after the stroke.");
+    if (std::memcmp(reinterpret_cast<const void*>(engine.getDisplayPointer()), reinterpret_cast<const void*>(reference.getDisplayPointer()), ew * eh * sizeof(Pixel)) != 0) {
+        printFail("Summed-Area Table", "Frame after a stroke differs from a fresh engine.");
+    }
+#endif
+
+    printPass("Summed-Area Table");
+}
+
+/**
+ * @brief Test 29: Row-Run Copies.
+ * Verifies RowCopy against per-pixel clamped reads for shifts that start
+ * left of, inside and right of odd-width rows, on whole images and on
+ * lens-plus-halo snapshots, and that the alpha of split channels is kept.
+ */
+void runRowCopyTest() {
+    int w = 29, h = 5;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) image[i] = {static_cast<uint8_t>(i * 5), static_cast<uint8_t>(i * 3 + 1), static_cast<uint8_t>(i * 7 + 2), static_cast<uint8_t>(i)};
+    SourceView source = SourceView::whole(image.data(), w, h);
+    auto clampX = [&](int x) { return std::max(0, std::min(w - 1, x)); };
+    auto same = [](const Pixel& a, const Pixel& b) { return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a; };
+
+    for (int srcX = -40; srcX <= 40; srcX += 3) {
+        for (int count : {1, 4, 9, 29, 50}) {
+            std::vector<Pixel> out(count);
+            RowCopy::shifted(source, srcX, 2, out.data(), count);
+            for (int i = 0; i < count; i++) {
+                if (!same(out[i], image[2 * w + clampX(srcX + i)])) printFail("Row-Run Copies", "Shifted run differs from clamped reads.");
+            }
+        }
+    }
+
+    // Overlapping shift within one row
+    std::vector<Pixel> row(image.begin() + w, image.begin() + 2 * w);
+    std::vector<Pixel> inPlace = row;
+    RowCopy::shifted(SourceView::whole(inPlace.data(), w, 1), -3, 0, inPlace.data(), w);
+    for (int x = 0; x < w; x++) {
+        if (!same(inPlace[x], row[clampX(x - 3)])) printFail("Row-Run Copies", "Overlapping shift is wrong.");
+    }
+
+    for (int offset : {-31, -6, -1, 1, 5, 14, 30}) {
+        for (int x0 : {0, 3, 11}) {
+            for (int x1 : {12, 22, w}) {
+                std::vector<Pixel> out(x1 - x0, mkPixel(9));
+                RowCopy::splitChannels(source, 3, x0, x1, offset, out.data());
+                for (int x = x0; x < x1; x++) {
+                    const Pixel& p = out[x - x0];
+                    if (p.r != image[3 * w + clampX(x - offset)].r || p.g != image[3 * w + x].g ||
+                        p.b != image[3 * w + clampX(x + offset)].b || p.a != 255) {
+                        printFail("Row-Run Copies", "Channel split differs from clamped reads.");
+                    }
+                }
+            }
+        }
+    }
+
+    // Snapshot source: a window of rows 1..3, columns 0..19 only
+    SourceView window = {&image[1 * w], w, {0, 1, 20, 3}, w, h};
+    std::vector<Pixel> out(12);
+    RowCopy::shifted(window, -4, 2, out.data(), 12);
+    for (int i = 0; i < 12; i++) {
+        if (!same(out[i], image[2 * w + clampX(i - 4)])) printFail("Row-Run Copies", "Snapshot run differs.");
+    }
+
+    printPass("Row-Run Copies");
+}
+
+/**
+ * @brief Test 30: Pixel Formats and sRGB Tables.
+ * Verifies that sRGB -> linear -> sRGB returns every 8-bit level (16-bit and
+ * float), that encoding rounds to the nearest sRGB level, that templated
+ * kernels give the 8-bit result at 16 bits, and that the engine mixes the
+ * soft lens edge in linear light when asked to.
+ */
+void runPixelFormatTest() {
+    for (int v = 0; v < 256; v++) {
+        uint8_t level = static_cast<uint8_t>(v);
+        if (Srgb::fromLinear16(Srgb::toLinear16(level)) != level) printFail("Pixel Formats", "16-bit round trip changed a level.");
+        if (Srgb::fromLinearF(Srgb::toLinearF(level)) != level) printFail("Pixel Formats", "Float round trip changed a level.");
+        if (v > 0 && Srgb::toLinear16(level) <= Srgb::toLinear16(level - 1)) printFail("Pixel Formats", "Linear table is not increasing.");
+    }
+    for (int v = 0; v < 65536; v += 37) {
+        double linear = v / 65535.0;
+        double encoded = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+        if (std::abs(encoded * 255.0 - Srgb::fromLinear16(static_cast<uint16_t>(v))) > 0.5 + 1e-6) printFail("Pixel Formats", "Encode is not the nearest sRGB level.");
+    }
+
+    // Templated kernels: 16-bit copies of 8-bit pixels give the 8-bit result, scaled
+    int count = 64;
+    std::vector<Pixel> src(count), out8(count);
+    std::vector<Pixel16> src16(count), out16(count);
+    for (int i = 0; i < count; i++) {
+        src[i] = {static_cast<uint8_t>(i * 4), static_cast<uint8_t>(255 - i * 3), static_cast<uint8_t>(i * 11), static_cast<uint8_t>(i + 100)};
+        src16[i] = {static_cast<uint16_t>(src[i].r * 257), static_cast<uint16_t>(src[i].g * 257), static_cast<uint16_t>(src[i].b * 257), static_cast<uint16_t>(src[i].a * 257)};
+    }
+    auto scaled = [&](const std::string& what) {
+        for (int i = 0; i < count; i++) {
+            if (out16[i].r != out8[i].r * 257 || out16[i].g != out8[i].g * 257 || out16[i].b != out8[i].b * 257 || out16[i].a != out8[i].a * 257) {
+                printFail("Pixel Formats", what + " at 16 bits differs from 8 bits.");
+            }
+        }
+    };
+    InvertEffect::processSpanScalar(src.data(), out8.data(), count, 256);
+    InvertEffect::processSpanScalar<Rgba16>(src16.data(), out16.data(), count, 256);
+    scaled("Invert");
+    SolarizeEffect::processSpanScalar(src.data(), out8.data(), count, 90);
+    SolarizeEffect::processSpanScalar<Rgba16>(src16.data(), out16.data(), count, 90);
+    scaled("Solarize");
+    std::vector<PixelF> srcF(count), outF(count);
+    Srgb::decode(src.data(), srcF.data(), count);
+    InvertEffect::processSpanScalar<RgbaF32>(srcF.data(), outF.data(), count, 128);
+    for (int i = 0; i < count; i++) {
+        if (std::abs(outF[i].r - 0.5f) > 1e-6f || outF[i].a != srcF[i].a) printFail("Pixel Formats", "Float kernel is wrong.");
+    }
+
+    // Soft edge of a white lens over black: sRGB vs. linear-light mixing
+    int w = 64, h = 64;
+    for (bool linear : {false, true}) {
+        for (int threads : {1, 2}) {
+            GlitchEngine engine;
+            engine.setThreadCount(threads);
+            engine.setFeather(10);
+            engine.setLinearEdges(linear);
+            Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+            for (int i = 0; i < w * h; i++) original[i] = {0, 0, 0, 255};
+            engine.renderFrame(32, 30, 20, static_cast<int>(EffectType::INVERT), 100.0f);
+            const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+
+            EffectParams params = {100.0f, true, 32, 30, 20, 10};
+            params.linearEdge = linear;
+            LensMask mask;
+            mask.update(params, {0, 0, w, h});
+            Pixel black = {0, 0, 0, 255}, white = {255, 255, 255, 255};
+            bool brighter = false;
+            for (int y = 0; y < h; y++) {
+                int x0 = w, x1 = w;
+                mask.span(y, x0, x1);
+                for (int x = 0; x < w; x++) {
+                    Pixel expected = black;
+                    if (x >= x0 && x < x1) {
+                        int cov = mask.coverage(x, y);
+                        expected = linear ? LensMask::blendLinear(black, white, cov) : LensMask::blend(black, white, cov);
+                        brighter = brighter || LensMask::blendLinear(black, white, cov).r > LensMask::blend(black, white, cov).r;
+                    }
+                    const Pixel& p = display[y * w + x];
+                    if (p.r != expected.r || p.g != expected.g || p.b != expected.b || p.a != expected.a) {
+                        printFail("Pixel Formats", linear ? "Linear-light edge is wrong." : "sRGB edge is wrong.");
+                    }
+                }
+            }
+            if (!brighter) printFail("Pixel Formats", "Linear-light edge is not brighter than the sRGB one.");
+        }
+    }
+
+    // Rows longer than one decode batch, blended in place: each pixel mixes its
+    // two inputs in 16-bit linear light
+    EffectParams wide = {100.0f, true, 150, 0, 150, 150};
+    wide.linearEdge = true;
+    LensMask softMask;
+    softMask.update(wide, {0, 0, 301, 1});
+    int length = 301;
+    std::vector<Pixel> from(length), to(length);
+    for (int i = 0; i < length; i++) {
+        from[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(255 - i), static_cast<uint8_t>(i * 13), 255};
+        to[i] = {static_cast<uint8_t>(255 - i * 5), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i), static_cast<uint8_t>(i)};
+    }
+    std::vector<Pixel> blended = to;
+    softMask.blendRow(from.data(), blended.data(), blended.data(), 0, 0, length);
+    auto mixLinear = [](uint8_t a, uint8_t b, int cov) {
+        return Srgb::fromLinear16(Rgba16::mix(Srgb::toLinear16(a), Srgb::toLinear16(b), cov));
+    };
+    for (int i = 0; i < length; i++) {
+        int cov = softMask.coverage(i, 0);
+        const Pixel& p = blended[i];
+        if (p.r != mixLinear(from[i].r, to[i].r, cov) || p.g != mixLinear(from[i].g, to[i].g, cov) ||
+            p.b != mixLinear(from[i].b, to[i].b, cov) || p.a != (Rgba16::mix(from[i].a * 257, to[i].a * 257, cov) + 128) / 257) {
+            printFail("Pixel Formats", "Batched linear-light row blend is wrong.");
+        }
+    }
+
+    printPass("Pixel Formats (sRGB / Linear)");
+}
+
+/**
+ * @brief Test 31: Linear-Light Chains.
+ * Verifies that a fused point-wise chain run on 16-bit pixels gives the 8-bit
+ * result scaled (any thread count), that float and 16-bit agree, and that the
+ * engine's linear-light render decodes, processes and re-encodes the lens
+ * (soft edge included), storing only the lens box, while refusing chains that
+ * are not point-wise.
+ */
+void runLinearChainTest() {
+    int w = 90, h = 70;
+    std::vector<Pixel> image(w * h);
+    for (int i = 0; i < w * h; i++) {
+        image[i] = {static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 3 + 40), static_cast<uint8_t>(255 - i), static_cast<uint8_t>(i * 5)};
+    }
+
+    // Invert at full weight, Solarize and RGB Noise are exact at 16 bits
+    EffectStage stages[3];
+    stages[0] = {EffectType::INVERT, {100.0f, true, 45, 35, 30}};
+    stages[1] = {EffectType::SOLARIZE, {40.0f, true, 50, 30, 25}};
+    stages[2] = {EffectType::RGB_NOISE, {30.0f, false, 0, 0, 0}};
+    for (EffectStage& stage : stages) stage.params.seed = 7;
+
+    std::vector<Pixel> expected = image;
+    {
+        TileScheduler scheduler(1);
+        EffectChain chain;
+        chain.run(scheduler, stages, 3, SourceView::whole(image.data(), w, h), ImageView::whole(expected.data(), w, h));
+    }
+
+    std::vector<PixelF> firstF;
+    for (int threads : {1, 3}) {
+        TileScheduler scheduler(threads);
+        EffectChain chain;
+        if (!chain.isPointwise(stages, 3)) printFail("Linear Chains", "Point-wise chain not recognized.");
+
+        std::vector<Pixel16> wide(w * h);
+        for (int i = 0; i < w * h; i++) wide[i] = {static_cast<uint16_t>(image[i].r * 257), static_cast<uint16_t>(image[i].g * 257),
+                                                   static_cast<uint16_t>(image[i].b * 257), static_cast<uint16_t>(image[i].a * 257)};
+        Region dirty = chain.runPointwise(scheduler, stages, 3, BasicImageView<Pixel16>::whole(wide.data(), w, h));
+        if (dirty.x != 0 || dirty.y != 0 || dirty.width != w || dirty.height != h) printFail("Linear Chains", "Wrong dirty region.");
+        for (int i = 0; i < w * h; i++) {
+            if (wide[i].r != expected[i].r * 257 || wide[i].g != expected[i].g * 257 || wide[i].b != expected[i].b * 257 || wide[i].a != expected[i].a * 257) {
+                printFail("Linear Chains", "16-bit chain differs from the 8-bit chain.");
+            }
+        }
+
+        std::vector<PixelF> floats(w * h);
+        for (int i = 0; i < w * h; i++) floats[i] = {image[i].r / 255.0f, image[i].g / 255.0f, image[i].b / 255.0f, image[i].a / 255.0f};
+        chain.runPointwise(scheduler, stages, 3, BasicImageView<PixelF>::whole(floats.data(), w, h));
+        for (int i = 0; i < w * h; i++) {
+            if (std::abs(floats[i].r * 255.0f - expected[i].r) > 0.01f || std::abs(floats[i].b * 255.0f - expected[i].b) > 0.01f) {
+                printFail("Linear Chains", "Float chain differs from the 8-bit chain.");
+            }
+        }
+        if (firstF.empty()) firstF = floats;
+        else if (std::memcmp(firstF.data(), floats.data(), floats.size() * sizeof(PixelF)) != 0) printFail("Linear Chains", "Float chain depends on the thread count.");
+    }
+
+    // Engine: Invert in linear light with a soft edge, at 16 bits and in float
+    for (int threads : {1, 2}) {
+        GlitchEngine engine;
+        engine.setThreadCount(threads);
+        engine.setFeather(12);
+        Pixel* original = reinterpret_cast<Pixel*>(engine.beginIngest(w, h));
+        std::copy(image.begin(), image.end(), original);
+        engine.addChainStage(static_cast<int>(EffectType::INVERT), 100.0f);
+
+        LinearImage<Pixel16> linear16;
+        LinearImage<PixelF> linearF;
+        engine.renderChain(20, 20, 15); // The linear render heals this 8-bit frame
+        if (!engine.renderChainLinear(45, 35, 30, linear16)) printFail("Linear Chains", "Point-wise chain was refused.");
+        const Region& stored = linear16.getBounds();
+        Region lens = lensRegion({100.0f, true, 45, 35, 30}, w, h);
+        if (stored.x != lens.x || stored.y != lens.y || stored.width != lens.width || stored.height != lens.height) {
+            printFail("Linear Chains", "Linear copy is not sized to the lens.");
+        }
+        std::vector<Pixel> display16(reinterpret_cast<const Pixel*>(engine.getDisplayPointer()),
+                                     reinterpret_cast<const Pixel*>(engine.getDisplayPointer()) + w * h);
+        engine.renderChainLinear(45, 35, 30, linearF);
+        const Pixel* display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+        std::vector<Pixel> displayF(display, display + w * h);
+
+        EffectParams params = {100.0f, true, 45, 35, 30, 12};
+        LensMask mask;
+        mask.update(params, {0, 0, w, h});
+        auto invertLinear = [](uint8_t v, int cov) {
+            uint16_t l = Srgb::toLinear16(v);
+            return Srgb::fromLinear16(Rgba16::mix(l, static_cast<uint16_t>(65535 - l), cov));
+        };
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const Pixel& src = image[y * w + x];
+                Pixel want = src;
+                if (mask.contains(x, y)) {
+                    int cov = mask.coverage(x, y);
+                    want = {invertLinear(src.r, cov), invertLinear(src.g, cov), invertLinear(src.b, cov), src.a};
+                }
+                const Pixel& got = display16[y * w + x];
+                if (got.r != want.r || got.g != want.g || got.b != want.b || got.a != want.a) printFail("Linear Chains", "16-bit linear render is wrong.");
+                const Pixel& gotF = displayF[y * w + x];
+                if (std::abs(gotF.r - want.r) > 1 || std::abs(gotF.g - want.g) > 1 || std::abs(gotF.b - want.b) > 1 || gotF.a != want.a) {
+                    printFail("Linear Chains", "Float linear render is wrong.");
+                }
+            }
+        }
+
+        // Neighbourhood effects cannot run on wide pixels: nothing is rendered
+        engine.addChainStage(static_cast<int>(EffectType::SWIRL), 50.0f);
+        if (engine.renderChainLinear(10, 10, 5, linear16)) printFail("Linear Chains", "Swirl chain was accepted.");
+        display = reinterpret_cast<const Pixel*>(engine.getDisplayPointer());
+        if (std::memcmp(display, displayF.data(), displayF.size() * sizeof(Pixel)) != 0 || engine.getFrameIndex() != 2) {
+            printFail("Linear Chains", "Refused chain rendered a frame.");
+        }
+    }
+
+    printPass("Linear-Light Chains");
+}
+
 // --- MAIN ---
 
 int main() {
-    std::srand(static_cast<unsigned int>(time(NULL))); // Random seed
     std::cout << "\n=== GLITCH CORE FULL SUITE ===\n" << std::endl;
 
     runBubbleLogicTest();
@@ -261,7 +1973,31 @@ int main() {
     runSwirlTest();
     runJitterTest();
     runScanlineTest();
+    runDirtyRectTest();
+    runAllocationFreeTest();
+    runHaloSnapshotTest();
+    runEffectChainTest();
+    runSimdBitExactTest();
+    runLensMaskTest();
+    runThreadDeterminismTest();
+    runConvolutionTest();
+    runLumaPlaneTest();
+    runDisplacementCacheTest();
+    runQualityTierTest();
+    runReproducibleNoiseTest();
+    runFrameStatsTest();
+    runTiledRenderTest();
+    runStreamPipelineTest();
+    runImageCodecTest();
+    runIngestTest();
+    runPaintUndoTest();
+    runProgressivePreviewTest();
+    runResumableRenderTest();
+    runSummedAreaTest();
+    runRowCopyTest();
+    runPixelFormatTest();
+    runLinearChainTest();
 
-    std::cout << "\n" << GREEN << "=== ALL 7 TESTS PASSED SUCCESSFULLY ===" << RESET << "\n" << std::endl;
+    std::cout << "\n" << GREEN << "=== ALL 31 TESTS PASSED SUCCESSFULLY ===" << RESET << "\n" << std::endl;
     return 0;
 }
\ No newline at end of file
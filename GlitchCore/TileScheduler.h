@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Threads are available natively and in Emscripten builds compiled with -pthread
+ * (__EMSCRIPTEN_PTHREADS__). A plain single-threaded wasm build runs every task
+ * on the calling thread.
+ */
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    #define GLITCH_THREADS 0
+#else
+    #define GLITCH_THREADS 1
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+#endif
+
+/**
+ * @class TileScheduler
+ * @brief Persistent worker pool that runs a batch of independent tasks (tiles / bands).
+ *
+ * run(count, fn) splits the task indices into one contiguous range per worker.
+ * Each worker pops tasks from the front of its own range; when it runs dry it
+ * steals the back half of another worker's range, so uneven tiles (e.g. the
+ * short rows at the top of the lens) still balance out. The calling thread is
+ * worker 0 and participates in the work; run() returns when every task is done.
+ *
+ * Tasks receive their worker index so callers can keep per-worker state
+ * (effect instances, scratch buffers) without locking. run() does not allocate.
+ */
+class TileScheduler {
+public:
+    explicit TileScheduler(int threads = defaultThreadCount()) { start(threads); }
+    ~TileScheduler() { stop(); }
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+    static int defaultThreadCount() {
+#if GLITCH_THREADS
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+#else
+        return 1;
+#endif
+    }
+
+    int getThreadCount() const { return threadCount; }
+
+    /**
+     * @brief Restarts the pool with a new number of threads (including the caller).
+     * Must not be called while run() is in progress.
+     */
+    void setThreadCount(int threads) {
+        if (threads == threadCount) return;
+        stop();
+        start(threads);
+    }
+
+    /**
+     * @brief Runs fn(task, worker) for every task in [0, taskCount).
+     * @param taskCount Number of independent tasks.
+     * @param fn Callable invoked as fn(int task, int worker).
+     */
+    template <typename Fn>
+    void run(int taskCount, Fn&& fn) {
+        if (taskCount <= 0) return;
+        if (threadCount == 1 || taskCount == 1) {
+            for (int task = 0; task < taskCount; ++task) fn(task, 0);
+            return;
+        }
+#if GLITCH_THREADS
+        using FnType = typename std::remove_reference<Fn>::type;
+        context = static_cast<void*>(&fn);
+        invoke = [](void* ctx, int task, int worker) { (*static_cast<FnType*>(ctx))(task, worker); };
+        remaining.store(taskCount, std::memory_order_relaxed);
+
+        for (int w = 0; w < threadCount; ++w) {
+            std::lock_guard<std::mutex> guard(queues[w].lock);
+            queues[w].begin = static_cast<int>(static_cast<long long>(taskCount) * w / threadCount);
+            queues[w].end = static_cast<int>(static_cast<long long>(taskCount) * (w + 1) / threadCount);
+        }
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain(0);
+
+        std::unique_lock<std::mutex> guard(poolLock);
+        done.wait(guard, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+#endif
+    }
+
+private:
+    int threadCount = 1;
+
+#if GLITCH_THREADS
+    // Contiguous range of task indices owned by one worker
+    struct TaskRange {
+        std::mutex lock;
+        int begin = 0;
+        int end = 0;
+    };
+
+    std::unique_ptr<TaskRange[]> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex poolLock;
+    std::condition_variable wake; // New batch or shutdown
+    std::condition_variable done; // Last task of the batch finished
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    std::atomic<int> remaining{0};
+    void (*invoke)(void*, int, int) = nullptr;
+    void* context = nullptr;
+
+    void start(int threads) {
+        threadCount = std::max(1, threads);
+        queues.reset(new TaskRange[threadCount]);
+        stopping = false;
+        for (int w = 1; w < threadCount; ++w) {
+            workers.emplace_back([this, w] { workerLoop(w); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+        workers.clear();
+    }
+
+    void workerLoop(int worker) {
+        unsigned long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(poolLock);
+                wake.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            drain(worker);
+        }
+    }
+
+    // Pop from the own range first, then steal from the others until all are empty
+    void drain(int worker) {
+        int task;
+        while (popOwn(worker, task) || steal(worker, task)) {
+            invoke(context, task, worker);
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> guard(poolLock);
+                done.notify_all();
+            }
+        }
+    }
+
+    bool popOwn(int worker, int& task) {
+        TaskRange& q = queues[worker];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.begin >= q.end) return false;
+        task = q.begin++;
+        return true;
+    }
+
+    bool steal(int worker, int& task) {
+        for (int i = 1; i < threadCount; ++i) {
+            TaskRange& victim = queues[(worker + i) % threadCount];
+            int begin, end;
+            {
+                std::lock_guard<std::mutex> guard(victim.lock);
+                int available = victim.end - victim.begin;
+                if (available <= 0) continue;
+
+                // Take the back half (at least one task)
+                int take = (available + 1) / 2;
+                begin = victim.end - take;
+                end = victim.end;
+                victim.end = begin;
+            }
+            task = begin;
+            if (begin + 1 < end) {
+                TaskRange& own = queues[worker];
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = begin + 1;
+                own.end = end;
+            }
+            return true;
+        }
+        return false;
+    }
+#else
+    void start(int) { threadCount = 1; }
+    void stop() {}
+#endif
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "Common.h"
+
+/**
+ * Memory-mapped tile storage is available on native POSIX builds. Everywhere
+ * else (wasm, Windows) TiledImage only offers heap-backed tiles.
+ */
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+    #define GLITCH_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #define GLITCH_MMAP 0
+#endif
+
+/**
+ * @class TiledImage
+ * @brief RGBA image stored as kTileSize x kTileSize tiles instead of one buffer.
+ *
+ * Each tile is contiguous, so reading a window of the image only touches the
+ * tiles it intersects. Tiles either live on the heap (one allocation per tile,
+ * never one block for the whole image) or in a memory-mapped file, in which
+ * case the OS pages tiles in on first access and can evict them again: the
+ * resident memory follows the area being worked on, not the image size.
+ *
+ * File layout: tiles in row-major tile order, each a full kTileSize^2 block of
+ * pixels (tiles on the right and bottom edges are padded). No header; the
+ * caller supplies width and height.
+ */
+class TiledImage {
+public:
+    static constexpr int kTileShift = 8;
+    static constexpr int kTileSize = 1 << kTileShift; // 256 x 256 pixels = 256 KB per tile
+    static constexpr size_t kTilePixels = static_cast<size_t>(kTileSize) * kTileSize;
+
+    TiledImage() = default;
+    ~TiledImage() { release(); }
+
+    TiledImage(const TiledImage&) = delete;
+    TiledImage& operator=(const TiledImage&) = delete;
+
+    /**
+     * @brief Allocates heap tiles for a width x height image (contents undefined).
+     */
+    bool allocate(int w, int h) {
+        release();
+        if (!setSize(w, h)) return false;
+        heapTiles.resize(tiles.size());
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            heapTiles[i].resize(kTilePixels);
+            tiles[i] = heapTiles[i].data();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Maps a tile file of a width x height image (native POSIX builds only).
+     * @param create If true the file is created or resized (new contents are zero);
+     * otherwise it must already have the tiled size.
+     * @return false if mapping is unsupported or the file cannot be opened or mapped.
+     */
+    bool mapFile(const char* path, int w, int h, bool create) {
+        release();
+#if GLITCH_MMAP
+        if (!setSize(w, h)) return false;
+        size_t bytes = tiles.size() * kTilePixels * sizeof(Pixel);
+
+        int fd = ::open(path, create ? (O_RDWR | O_CREAT) : O_RDWR, 0644);
+        if (fd < 0) return fail();
+        struct stat info;
+        bool sized = create ? ::ftruncate(fd, static_cast<off_t>(bytes)) == 0
+                            : (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == bytes);
+        void* base = sized ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd); // The mapping keeps the file open
+        if (base == MAP_FAILED) return fail();
+
+        mapping = base;
+        mappedBytes = bytes;
+        Pixel* first = static_cast<Pixel*>(base);
+        for (size_t i = 0; i < tiles.size(); ++i) tiles[i] = first + i * kTilePixels;
+        return true;
+#else
+        (void)path; (void)w; (void)h; (void)create;
+        return false;
+#endif
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getTilesX() const { return tilesX; }
+    int getTilesY() const { return tilesY; }
+    bool isMapped() const { return mapping != nullptr; }
+
+    // Tile (tx, ty); its pixel (x, y) is at [(y & mask) * kTileSize + (x & mask)].
+    Pixel* tile(int tx, int ty) { return tiles[static_cast<size_t>(ty) * tilesX + tx]; }
+    const Pixel* tile(int tx, int ty) const { return tiles[static_cast<size_t>(ty) * tilesX + tx]; }
+
+    /**
+     * @brief Copies 'area' (inside the image) into out, 'stride' pixels per row.
+     */
+    void readRegion(const Region& area, Pixel* out, int stride) const {
+        forEachRun(area, [&](Pixel* tileRun, int x, int y, int count) {
+            std::memcpy(out + static_cast<size_t>(y - area.y) * stride + (x - area.x), tileRun, count * sizeof(Pixel));
+        });
+    }
+
+    /**
+     * @brief Copies pixels from in ('stride' pixels per row) into 'area' (inside the image).
+     */
+    void writeRegion(const Region& area, const Pixel* in, int stride) {
+        forEachRun(area, [&](Pixel* tileRun, int x, int y, int count) {
+            std::memcpy(tileRun, in + static_cast<size_t>(y - area.y) * stride + (x - area.x), count * sizeof(Pixel));
+        });
+    }
+
+    /**
+     * @brief Copies every tile of an image with the same size.
+     */
+    void copyFrom(const TiledImage& other) {
+        if (other.width != width || other.height != height) return;
+        for (size_t i = 0; i < tiles.size(); ++i) std::memcpy(tiles[i], other.tiles[i], kTilePixels * sizeof(Pixel));
+    }
+
+    /**
+     * @brief Asks the OS to write dirty mapped tiles back to the file (no-op for heap tiles).
+     */
+    void flush() {
+#if GLITCH_MMAP
+        if (mapping) ::msync(mapping, mappedBytes, MS_SYNC);
+#endif
+    }
+
+private:
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<Pixel*> tiles;                 // Row-major tile pointers into the storage below
+    std::vector<std::vector<Pixel>> heapTiles; // Heap backing
+    void* mapping = nullptr;                   // File backing
+    size_t mappedBytes = 0;
+
+    bool setSize(int w, int h) {
+        if (w <= 0 || h <= 0) return false;
+        width = w;
+        height = h;
+        tilesX = (w + kTileSize - 1) >> kTileShift;
+        tilesY = (h + kTileSize - 1) >> kTileShift;
+        tiles.assign(static_cast<size_t>(tilesX) * tilesY, nullptr);
+        return true;
+    }
+
+    bool fail() {
+        release();
+        return false;
+    }
+
+    void release() {
+#if GLITCH_MMAP
+        if (mapping) ::munmap(mapping, mappedBytes);
+#endif
+        mapping = nullptr;
+        mappedBytes = 0;
+        heapTiles.clear();
+        tiles.clear();
+        width = height = tilesX = tilesY = 0;
+    }
+
+    /**
+     * @brief Calls fn(tileRun, x, y, count) for every row run of 'area' that lies in one tile.
+     */
+    template <typename Fn>
+    void forEachRun(const Region& area, Fn&& fn) const {
+        const int mask = kTileSize - 1;
+        for (int y = area.y; y < area.y + area.height; ++y) {
+            int ty = y >> kTileShift;
+            for (int x = area.x; x < area.x + area.width;) {
+                int tx = x >> kTileShift;
+                int count = std::min(area.x + area.width, (tx + 1) << kTileShift) - x;
+                Pixel* run = tiles[static_cast<size_t>(ty) * tilesX + tx] + static_cast<size_t>(y & mask) * kTileSize + (x & mask);
+                fn(run, x, y, count);
+                x += count;
+            }
+        }
+    }
+};
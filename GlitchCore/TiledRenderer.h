@@ -0,0 +1,129 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <vector>
+#include "Common.h"
+#include "EffectRegistry.h"
+#include "TiledImage.h"
+#include "TileScheduler.h"
+
+/**
+ * @class TiledRenderer
+ * @brief Applies effects to TiledImages (out-of-core, e.g. print-resolution scans).
+ *
+ * The lens region is cut into strips along the effect's band direction (see
+ * IEffect::getParallelism), kStripSize long and aligned like EffectChain bands.
+ * Each strip reads its dirty bounds plus halo from the source tiles into a
+ * contiguous window, renders into a copy of its dirty bounds, and writes the
+ * result back to the destination tiles. Only the tiles intersecting the lens
+ * are touched, and the working set is one strip window per worker thread.
+ *
+ * Strips are rendered on the TileScheduler with one effect registry and one
+ * pair of strip buffers per worker, reused across calls.
+ *
+ * Effects that are not band-local (IEffect::isBandLocal) run as a single strip
+ * covering the whole lens, so their working set is the lens box.
+ */
+class TiledRenderer {
+public:
+    static constexpr int kStripSize = TiledImage::kTileSize;
+
+    /**
+     * @brief Renders one effect inside the lens of 'params' from source into dest.
+     * @param dest A different image of the same size. Pixels outside the returned
+     * region are left as they are, so dest is normally a copy of source.
+     * @return The area written, clipped to the image (empty for NONE or an off-image lens).
+     */
+    Region apply(TileScheduler& scheduler, EffectType type, const TiledImage& source,
+                 TiledImage& dest, const EffectParams& params) {
+        int threads = scheduler.getThreadCount();
+        if (static_cast<int>(workers.size()) != threads) workers.resize(threads);
+
+        int w = source.getWidth(), h = source.getHeight();
+        IEffect* main = workers[0].effects.get(type);
+        Region region = lensRegion(params, w, h);
+        if (!main || region.isEmpty() || &source == &dest || dest.getWidth() != w || dest.getHeight() != h) {
+            return {0, 0, 0, 0};
+        }
+        Region dirty = clipRegion(main->getDirtyBounds(region, params), w, h);
+
+        Parallelism mode = main->isBandLocal() ? main->getParallelism() : Parallelism::Serial;
+        int align = std::max(1, main->getBandAlignment(params));
+        int stripLength = (kStripSize + align - 1) / align * align;
+        int length = (mode == Parallelism::Columns) ? region.width : region.height;
+        int strips = (mode == Parallelism::Serial) ? 1 : (length + stripLength - 1) / stripLength;
+
+        if (strips > 1) {
+            // Create instances up front, sharing worker 0's caches
+            for (Worker& worker : workers) worker.effects.get(type)->shareCaches(*main);
+        }
+        scheduler.run(strips, [&](int task, int worker) {
+            Region strip = region;
+            Region owned = dirty;
+            if (strips > 1) {
+                // The first and last strips also own the dirty bounds spilling past the region
+                int start = task * stripLength;
+                int end = std::min(length, start + stripLength);
+                int origin = (mode == Parallelism::Columns) ? region.x : region.y;
+                int ownedStart = (task == 0) ? INT_MIN / 2 : origin + start;
+                int ownedEnd = (task == strips - 1) ? INT_MAX / 2 : origin + end;
+                if (mode == Parallelism::Columns) {
+                    strip = {region.x + start, region.y, end - start, region.height};
+                    owned = sliceColumns(dirty, ownedStart, ownedEnd);
+                } else {
+                    strip = {region.x, region.y + start, region.width, end - start};
+                    owned = sliceRows(dirty, ownedStart, ownedEnd);
+                }
+            }
+            renderStrip(workers[worker], type, source, dest, strip, owned, params);
+        });
+        return dirty;
+    }
+
+private:
+    struct Worker {
+        EffectRegistry effects;    // This worker's effect instances
+        std::vector<Pixel> input;  // Strip dirty bounds plus halo, read from the source tiles
+        std::vector<Pixel> output; // Strip dirty bounds, rendered
+    };
+
+    std::vector<Worker> workers;
+
+    static Region sliceColumns(const Region& r, int x0, int x1) {
+        int a = std::max(r.x, x0), b = std::min(r.x + r.width, x1);
+        return (b > a) ? Region{a, r.y, b - a, r.height} : Region{0, 0, 0, 0};
+    }
+
+    static Region sliceRows(const Region& r, int y0, int y1) {
+        int a = std::max(r.y, y0), b = std::min(r.y + r.height, y1);
+        return (b > a) ? Region{r.x, a, r.width, b - a} : Region{0, 0, 0, 0};
+    }
+
+    static void renderStrip(Worker& worker, EffectType type, const TiledImage& source, TiledImage& dest,
+                            const Region& strip, const Region& owned, const EffectParams& params) {
+        if (owned.isEmpty()) return;
+        int w = source.getWidth(), h = source.getHeight();
+        IEffect* effect = worker.effects.get(type);
+
+        Region bounds = clipRegion(effect->getDirtyBounds(strip, params), w, h);
+        int halo = effect->getHaloSize(params);
+        Region window = clipRegion({bounds.x - halo, bounds.y - halo, bounds.width + 2 * halo, bounds.height + 2 * halo}, w, h);
+
+        size_t windowPixels = static_cast<size_t>(window.width) * window.height;
+        if (worker.input.size() < windowPixels) worker.input.resize(windowPixels);
+        source.readRegion(window, worker.input.data(), window.width);
+        SourceView input = {worker.input.data(), window.width, window, w, h};
+
+        // Unmasked pixels of the output keep their source value
+        size_t boundsPixels = static_cast<size_t>(bounds.width) * bounds.height;
+        if (worker.output.size() < boundsPixels) worker.output.resize(boundsPixels);
+        ImageView output = {worker.output.data(), bounds.width, bounds, w, h};
+        for (int y = bounds.y; y < bounds.y + bounds.height; ++y) {
+            const Pixel* row = &input.at(bounds.x, y);
+            std::copy(row, row + bounds.width, &output.at(bounds.x, y));
+        }
+
+        effect->apply(input, output, strip, params);
+        dest.writeRegion(owned, &output.at(owned.x, owned.y), bounds.width);
+    }
+};
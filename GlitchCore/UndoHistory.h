@@ -0,0 +1,295 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Common.h"
+
+/**
+ * @class UndoHistory
+ * @brief Undo/redo of paint strokes, stored as compressed per-tile deltas.
+ *
+ * The image is split into kTileSize x kTileSize tiles. While a stroke is open,
+ * capture() saves the pre-stroke pixels of each tile the first time the stroke
+ * touches it. endStroke() then turns every saved tile into (before XOR after)
+ * and run-length encodes the zero runs, so a stroke costs roughly what it
+ * painted. XOR is its own inverse: the same delta undoes and redoes a stroke.
+ *
+ * Committed strokes are kept under a byte budget; the oldest are dropped
+ * first. The pre-stroke copies of an open stroke are not counted against it.
+ */
+class UndoHistory {
+public:
+    static constexpr int kTileSize = 64;
+    static constexpr size_t kDefaultBudget = size_t(64) << 20;
+
+    /**
+     * @brief Forgets every stroke and sets up the tile grid for a w x h image.
+     */
+    void reset(int w, int h) {
+        width = w;
+        height = h;
+        tilesX = (w + kTileSize - 1) / kTileSize;
+        tilesY = (h + kTileSize - 1) / kTileSize;
+        strokes.clear();
+        applied = 0;
+        memoryUsage = 0;
+        capturing = false;
+        capturedTiles.clear();
+        tileSlot.clear(); // Sized by the first stroke: loading an image allocates nothing here
+    }
+
+    /**
+     * @brief Maximum size of the stored deltas in bytes. Shrinking it drops redo steps,
+     * then the oldest strokes, now.
+     */
+    void setBudget(size_t bytes) {
+        budget = bytes;
+        enforceBudget();
+    }
+    size_t getBudget() const { return budget; }
+
+    /**
+     * @brief Bytes used by the stored strokes (compressed deltas and tile headers).
+     */
+    size_t getMemoryUsage() const { return memoryUsage; }
+
+    int getUndoCount() const { return static_cast<int>(applied); }
+    int getRedoCount() const { return static_cast<int>(strokes.size() - applied); }
+    bool isCapturing() const { return capturing; }
+
+    /**
+     * @brief Opens a stroke (no-op if one is open). Its changes become one undo step.
+     */
+    void beginStroke() {
+        if (tileSlot.empty()) tileSlot.assign(static_cast<size_t>(tilesX) * tilesY, -1);
+        capturing = true;
+    }
+
+    /**
+     * @brief Saves the current pixels of the tiles overlapping the area, unless
+     * the open stroke already saved them. Call before the area is modified.
+     */
+    void capture(const Pixel* image, const Region& area) {
+        if (!capturing || area.isEmpty()) return;
+        int tx0 = area.x / kTileSize, tx1 = (area.x + area.width - 1) / kTileSize;
+        int ty0 = area.y / kTileSize, ty1 = (area.y + area.height - 1) / kTileSize;
+
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                int tile = ty * tilesX + tx;
+                if (tileSlot[tile] >= 0) continue;
+
+                int slot = static_cast<int>(capturedTiles.size());
+                tileSlot[tile] = slot;
+                capturedTiles.push_back(tile);
+                size_t tilePixels = static_cast<size_t>(kTileSize) * kTileSize;
+                if (before.size() < (slot + 1) * tilePixels) before.resize((slot + 1) * tilePixels);
+
+                Region r = tileRegion(tile);
+                Pixel* dst = before.data() + slot * tilePixels;
+                for (int y = 0; y < r.height; ++y) {
+                    std::memcpy(dst + y * r.width, image + static_cast<size_t>(r.y + y) * width + r.x, r.width * sizeof(Pixel));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Closes the open stroke and stores it as the newest undo step.
+     * Any redo steps are discarded. A stroke that changed nothing is not stored.
+     * @return True if a step was stored.
+     */
+    bool endStroke(const Pixel* image) {
+        if (!capturing) return false;
+        capturing = false;
+
+        Stroke stroke;
+        size_t tilePixels = static_cast<size_t>(kTileSize) * kTileSize;
+        for (size_t slot = 0; slot < capturedTiles.size(); ++slot) {
+            int tile = capturedTiles[slot];
+            tileSlot[tile] = -1;
+
+            // XOR of the saved and current pixels, tile rows packed together
+            Region r = tileRegion(tile);
+            size_t rowBytes = r.width * sizeof(Pixel);
+            scratch.resize(rowBytes * r.height);
+            const uint8_t* saved = reinterpret_cast<const uint8_t*>(before.data() + slot * tilePixels);
+            bool changed = false;
+            for (int y = 0; y < r.height; ++y) {
+                const uint8_t* now = reinterpret_cast<const uint8_t*>(image + static_cast<size_t>(r.y + y) * width + r.x);
+                uint8_t* out = scratch.data() + y * rowBytes;
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    out[i] = saved[y * rowBytes + i] ^ now[i];
+                    changed |= (out[i] != 0);
+                }
+            }
+            if (!changed) continue;
+
+            TileDelta delta;
+            delta.tile = tile;
+            delta.offset = stroke.data.size();
+            encode(scratch.data(), scratch.size(), stroke.data);
+            delta.size = stroke.data.size() - delta.offset;
+            stroke.tiles.push_back(delta);
+            stroke.bounds = unionRegion(stroke.bounds, r);
+        }
+        capturedTiles.clear();
+        if (stroke.tiles.empty()) return false;
+
+        stroke.data.shrink_to_fit();
+        stroke.bytes = stroke.data.size() + stroke.tiles.size() * sizeof(TileDelta);
+
+        // A new step makes the undone ones unreachable
+        while (strokes.size() > applied) {
+            memoryUsage -= strokes.back().bytes;
+            strokes.pop_back();
+        }
+        memoryUsage += stroke.bytes;
+        strokes.push_back(std::move(stroke));
+        applied++;
+        enforceBudget();
+        return applied > 0;
+    }
+
+    /**
+     * @brief Reverts the newest applied stroke in the image.
+     * @return Area that changed (empty if there was nothing to undo).
+     */
+    Region undo(Pixel* image) {
+        if (applied == 0) return {0, 0, 0, 0};
+        applied--;
+        return applyDelta(strokes[applied], image);
+    }
+
+    /**
+     * @brief Re-applies the newest undone stroke.
+     * @return Area that changed (empty if there was nothing to redo).
+     */
+    Region redo(Pixel* image) {
+        if (applied == strokes.size()) return {0, 0, 0, 0};
+        return applyDelta(strokes[applied++], image);
+    }
+
+private:
+    struct TileDelta {
+        int tile;      // Index in the tile grid
+        size_t offset; // Start of the encoded delta in Stroke::data
+        size_t size;
+    };
+
+    struct Stroke {
+        std::vector<TileDelta> tiles;
+        std::vector<uint8_t> data;
+        Region bounds = {0, 0, 0, 0};
+        size_t bytes = 0;
+    };
+
+    // Zero runs shorter than this stay inside a literal: a new run costs two varints
+    static constexpr size_t kMinZeroRun = 4;
+
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    size_t budget = kDefaultBudget;
+
+    std::deque<Stroke> strokes; // Oldest first
+    size_t applied = 0;         // strokes[0, applied) are in the image, the rest can be redone
+    size_t memoryUsage = 0;
+
+    // Open stroke: pre-stroke copies of the touched tiles, reused across strokes
+    bool capturing = false;
+    std::vector<int> tileSlot;      // Per tile: slot in `before`, or -1
+    std::vector<int> capturedTiles; // Per slot: tile index
+    std::vector<Pixel> before;
+    std::vector<uint8_t> scratch;
+
+    Region tileRegion(int tile) const {
+        int tx = tile % tilesX, ty = tile / tilesX;
+        return clipRegion({tx * kTileSize, ty * kTileSize, kTileSize, kTileSize}, width, height);
+    }
+
+    // Redo steps go first, newest first: each delta only applies on top of the
+    // steps before it, so the oldest undone step must outlive the newer ones.
+    // Then the oldest applied steps.
+    void enforceBudget() {
+        while (memoryUsage > budget && strokes.size() > applied) {
+            memoryUsage -= strokes.back().bytes;
+            strokes.pop_back();
+        }
+        while (memoryUsage > budget && !strokes.empty()) {
+            memoryUsage -= strokes.front().bytes;
+            strokes.pop_front();
+            applied--;
+        }
+    }
+
+    static void putVarint(size_t value, std::vector<uint8_t>& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static size_t getVarint(const uint8_t*& p) {
+        size_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = *p++;
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+    }
+
+    /**
+     * @brief Appends the delta as [zero run][literal count][literal bytes] records.
+     */
+    static void encode(const uint8_t* bytes, size_t count, std::vector<uint8_t>& out) {
+        size_t i = 0;
+        while (i < count) {
+            size_t literal = i;
+            while (literal < count && bytes[literal] == 0) literal++;
+
+            // Extend the literal up to the next long zero run (or the end)
+            size_t end = literal;
+            while (end < count) {
+                if (bytes[end] != 0) { end++; continue; }
+                size_t run = end;
+                while (run < count && bytes[run] == 0 && run - end < kMinZeroRun) run++;
+                if (run - end >= kMinZeroRun || run == count) break;
+                end = run;
+            }
+
+            putVarint(literal - i, out);
+            putVarint(end - literal, out);
+            out.insert(out.end(), bytes + literal, bytes + end);
+            i = end;
+        }
+    }
+
+    Region applyDelta(const Stroke& stroke, Pixel* image) {
+        for (const TileDelta& delta : stroke.tiles) {
+            Region r = tileRegion(delta.tile);
+            size_t rowBytes = r.width * sizeof(Pixel);
+            size_t total = rowBytes * r.height;
+
+            // Walk the records, XOR-ing literal bytes into the tile rows
+            const uint8_t* p = stroke.data.data() + delta.offset;
+            const uint8_t* end = p + delta.size;
+            size_t position = 0;
+            while (p < end && position < total) {
+                position += getVarint(p);
+                size_t literal = getVarint(p);
+                for (size_t i = 0; i < literal; ++i, ++position) {
+                    size_t y = position / rowBytes, x = position % rowBytes;
+                    uint8_t* row = reinterpret_cast<uint8_t*>(image + static_cast<size_t>(r.y + y) * width + r.x);
+                    row[x] ^= p[i];
+                }
+                p += literal;
+            }
+        }
+        return stroke.bounds;
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Common.h"
+
+/**
+ * @enum VideoFormat
+ * @brief Uncompressed frame streams understood by FrameReader / FrameWriter.
+ */
+enum class VideoFormat {
+    RawRGBA, // Headerless back-to-back RGBA frames; the size is given by the caller
+    Y4M      // YUV4MPEG2 stream, 4:2:0 or 4:4:4, 8 bit
+};
+
+/**
+ * @brief Geometry and layout of a frame stream.
+ */
+struct VideoInfo {
+    VideoFormat format = VideoFormat::RawRGBA;
+    int width = 0;
+    int height = 0;
+    bool chroma420 = true; // Y4M only: 4:2:0 (else 4:4:4)
+    std::string header;    // Y4M only: stream header line, echoed by FrameWriter
+
+    size_t framePixels() const { return static_cast<size_t>(width) * height; }
+    int chromaWidth() const { return chroma420 ? (width + 1) / 2 : width; }
+    int chromaHeight() const { return chroma420 ? (height + 1) / 2 : height; }
+};
+
+/**
+ * @brief BT.601 limited-range conversions in 8.8 fixed point.
+ */
+struct YuvConvert {
+    static uint8_t clamp(int v) { return static_cast<uint8_t>(std::max(0, std::min(255, v))); }
+
+    static Pixel toRgb(int y, int u, int v) {
+        int c = 298 * (y - 16) + 128;
+        int d = u - 128, e = v - 128;
+        return {clamp((c + 409 * e) >> 8), clamp((c - 100 * d - 208 * e) >> 8), clamp((c + 516 * d) >> 8), 255};
+    }
+
+    static uint8_t lumaOf(const Pixel& p) { return clamp(((66 * p.r + 129 * p.g + 25 * p.b + 128) >> 8) + 16); }
+    // Chroma of summed channels, divided by 2^(shift - 8) pixels (shift 8: one pixel, 10: a 2x2 block)
+    static uint8_t uOf(int r, int g, int b, int shift) { return clamp(((-38 * r - 74 * g + 112 * b + (1 << (shift - 1))) >> shift) + 128); }
+    static uint8_t vOf(int r, int g, int b, int shift) { return clamp(((112 * r - 94 * g - 18 * b + (1 << (shift - 1))) >> shift) + 128); }
+};
+
+/**
+ * @class FrameReader
+ * @brief Decodes frames from a raw RGBA or Y4M stream into RGBA pixels.
+ * Buffers are sized when the stream is opened; read() does not allocate.
+ */
+class FrameReader {
+public:
+    explicit FrameReader(std::istream& input) : in(input) {}
+
+    /**
+     * @brief Reads headerless RGBA frames of width x height.
+     */
+    bool openRaw(int width, int height) {
+        if (width <= 0 || height <= 0) return false;
+        info = VideoInfo();
+        info.format = VideoFormat::RawRGBA;
+        info.width = width;
+        info.height = height;
+        return true;
+    }
+
+    /**
+     * @brief Parses the YUV4MPEG2 stream header.
+     * @return false if it is missing or describes an unsupported layout (only 8-bit
+     * 4:2:0 and 4:4:4 are supported).
+     */
+    bool openY4M() {
+        std::string line;
+        if (!std::getline(in, line) || line.compare(0, 9, "YUV4MPEG2") != 0) return false;
+
+        info = VideoInfo();
+        info.format = VideoFormat::Y4M;
+        info.header = line;
+        std::istringstream tags(line.substr(9));
+        std::string tag;
+        while (tags >> tag) {
+            if (tag[0] == 'W') info.width = std::atoi(tag.c_str() + 1);
+            else if (tag[0] == 'H') info.height = std::atoi(tag.c_str() + 1);
+            else if (tag[0] == 'C') {
+                if (tag == "C444") info.chroma420 = false;
+                else if (tag.compare(0, 4, "C420") != 0) return false; // 4:2:2, mono, high bit depth
+            }
+        }
+        if (info.width <= 0 || info.height <= 0) return false;
+
+        planes.resize(info.framePixels() + 2 * static_cast<size_t>(info.chromaWidth()) * info.chromaHeight());
+        return true;
+    }
+
+    const VideoInfo& getInfo() const { return info; }
+
+    /**
+     * @brief Decodes the next frame into out (width * height pixels).
+     * @return false at the end of the stream or on a truncated frame.
+     */
+    bool read(Pixel* out) {
+        if (info.format == VideoFormat::RawRGBA) {
+            std::streamsize bytes = static_cast<std::streamsize>(info.framePixels() * sizeof(Pixel));
+            in.read(reinterpret_cast<char*>(out), bytes);
+            return in.gcount() == bytes;
+        }
+
+        // "FRAME" plus optional per-frame tags up to the newline
+        char c;
+        std::string tag;
+        while (in.get(c) && c != '\n') {
+            if (tag.size() < 5) tag += c;
+        }
+        if (tag != "FRAME") return false;
+
+        std::streamsize bytes = static_cast<std::streamsize>(planes.size());
+        in.read(reinterpret_cast<char*>(planes.data()), bytes);
+        if (in.gcount() != bytes) return false;
+
+        int cw = info.chromaWidth();
+        size_t chromaSize = static_cast<size_t>(cw) * info.chromaHeight();
+        const uint8_t* yPlane = planes.data();
+        const uint8_t* uPlane = yPlane + info.framePixels();
+        const uint8_t* vPlane = uPlane + chromaSize;
+        int shift = info.chroma420 ? 1 : 0;
+
+        for (int y = 0; y < info.height; ++y) {
+            const uint8_t* yRow = yPlane + static_cast<size_t>(y) * info.width;
+            const uint8_t* uRow = uPlane + static_cast<size_t>(y >> shift) * cw;
+            const uint8_t* vRow = vPlane + static_cast<size_t>(y >> shift) * cw;
+            Pixel* row = out + static_cast<size_t>(y) * info.width;
+            for (int x = 0; x < info.width; ++x) {
+                row[x] = YuvConvert::toRgb(yRow[x], uRow[x >> shift], vRow[x >> shift]);
+            }
+        }
+        return true;
+    }
+
+private:
+    std::istream& in;
+    VideoInfo info;
+    std::vector<uint8_t> planes; // One Y4M frame: Y, U, V
+};
+
+/**
+ * @class FrameWriter
+ * @brief Encodes RGBA frames in the layout of a VideoInfo (normally the reader's).
+ * 4:2:0 chroma is the average of each 2x2 block. write() does not allocate.
+ */
+class FrameWriter {
+public:
+    FrameWriter(std::ostream& output, const VideoInfo& layout) : out(output), info(layout) {
+        if (info.format == VideoFormat::Y4M) {
+            planes.resize(info.framePixels() + 2 * static_cast<size_t>(info.chromaWidth()) * info.chromaHeight());
+        }
+    }
+
+    /**
+     * @brief Writes one frame (and the stream header before the first one).
+     * @return false if the output stream failed.
+     */
+    bool write(const Pixel* frame) {
+        if (info.format == VideoFormat::RawRGBA) {
+            out.write(reinterpret_cast<const char*>(frame), static_cast<std::streamsize>(info.framePixels() * sizeof(Pixel)));
+            return static_cast<bool>(out);
+        }
+
+        if (!headerWritten) {
+            out << info.header << '\n';
+            headerWritten = true;
+        }
+        encode(frame);
+        out << "FRAME\n";
+        out.write(reinterpret_cast<const char*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+        return static_cast<bool>(out);
+    }
+
+private:
+    std::ostream& out;
+    VideoInfo info;
+    std::vector<uint8_t> planes;
+    bool headerWritten = false;
+
+    void encode(const Pixel* frame) {
+        int w = info.width, h = info.height;
+        int cw = info.chromaWidth(), ch = info.chromaHeight();
+        uint8_t* yPlane = planes.data();
+        uint8_t* uPlane = yPlane + info.framePixels();
+        uint8_t* vPlane = uPlane + static_cast<size_t>(cw) * ch;
+
+        for (size_t i = 0; i < info.framePixels(); ++i) yPlane[i] = YuvConvert::lumaOf(frame[i]);
+
+        int step = info.chroma420 ? 2 : 1;
+        for (int cy = 0; cy < ch; ++cy) {
+            for (int cx = 0; cx < cw; ++cx) {
+                // Sum the block, repeating the last row/column on odd sizes
+                int r = 0, g = 0, b = 0;
+                for (int dy = 0; dy < step; ++dy) {
+                    for (int dx = 0; dx < step; ++dx) {
+                        int x = std::min(w - 1, cx * step + dx), y = std::min(h - 1, cy * step + dy);
+                        const Pixel& p = frame[static_cast<size_t>(y) * w + x];
+                        r += p.r; g += p.g; b += p.b;
+                    }
+                }
+                int shift = info.chroma420 ? 10 : 8;
+                uPlane[static_cast<size_t>(cy) * cw + cx] = YuvConvert::uOf(r, g, b, shift);
+                vPlane[static_cast<size_t>(cy) * cw + cx] = YuvConvert::vOf(r, g, b, shift);
+            }
+        }
+    }
+};
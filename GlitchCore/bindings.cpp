@@ -22,13 +22,78 @@ EMSCRIPTEN_BINDINGS(glitch_module) {
         .value("SOBEL", EffectType::SOBEL)
         .value("RIPPLE", EffectType::RIPPLE)
         .value("SOLARIZE", EffectType::SOLARIZE)
-        .value("RGB_NOISE", EffectType::RGB_NOISE);
+        .value("RGB_NOISE", EffectType::RGB_NOISE)
+        .value("PIXEL_SORT_INTERVAL", EffectType::PIXEL_SORT_INTERVAL)
+        .value("GAUSSIAN_BLUR", EffectType::GAUSSIAN_BLUR)
+        .value("SHARPEN", EffectType::SHARPEN)
+        .value("EMBOSS", EffectType::EMBOSS)
+        .value("BOX_BLUR", EffectType::BOX_BLUR);
+
+    // Bind Region as a plain JS object ({x, y, width, height})
+    value_object<Region>("Region")
+        .field("x", &Region::x)
+        .field("y", &Region::y)
+        .field("width", &Region::width)
+        .field("height", &Region::height);
+
+    // Frame statistics (see FrameStats.h)
+    value_object<StatSummary>("StatSummary")
+        .field("mean", &StatSummary::mean)
+        .field("p50", &StatSummary::p50)
+        .field("p95", &StatSummary::p95)
+        .field("p99", &StatSummary::p99)
+        .field("max", &StatSummary::max);
+
+    value_object<FrameStats>("FrameStats")
+        .field("count", &FrameStats::count)
+        .field("healMs", &FrameStats::healMs)
+        .field("setupMs", &FrameStats::setupMs)
+        .field("applyMs", &FrameStats::applyMs)
+        .field("totalMs", &FrameStats::totalMs)
+        .field("pixels", &FrameStats::pixels)
+        .field("bytesCopied", &FrameStats::bytesCopied);
 
     // Bind the main Engine class
     class_<GlitchEngine>("GlitchEngine")
         .constructor<>()
+        .function("beginIngest", &GlitchEngine::beginIngest)
         .function("loadBox", &GlitchEngine::loadBox)
         .function("getOriginalPointer", &GlitchEngine::getOriginalPointer)
         .function("getDisplayPointer", &GlitchEngine::getDisplayPointer)
-        .function("renderFrame", &GlitchEngine::renderFrame);
+        .function("renderFrame", &GlitchEngine::renderFrame)
+        .function("getDirtyRect", &GlitchEngine::getDirtyRect)
+        .function("invalidateOriginal", &GlitchEngine::invalidateOriginal)
+        .function("setFeather", &GlitchEngine::setFeather)
+        .function("setLinearEdges", &GlitchEngine::setLinearEdges)
+        .function("setQuality", &GlitchEngine::setQuality)
+        .function("setSeed", &GlitchEngine::setSeed)
+        .function("getFrameIndex", &GlitchEngine::getFrameIndex)
+        .function("setFrameIndex", &GlitchEngine::setFrameIndex)
+        .function("setThreadCount", &GlitchEngine::setThreadCount)
+        .function("getThreadCount", &GlitchEngine::getThreadCount)
+        .function("getFrameStats", &GlitchEngine::getFrameStats)
+        .function("getEffectPixels", &GlitchEngine::getEffectPixels)
+        .function("resetFrameStats", &GlitchEngine::resetFrameStats)
+        .function("beginStroke", &GlitchEngine::beginStroke)
+        .function("paintDab", &GlitchEngine::paintDab)
+        .function("endStroke", &GlitchEngine::endStroke)
+        .function("undo", &GlitchEngine::undo)
+        .function("redo", &GlitchEngine::redo)
+        .function("canUndo", &GlitchEngine::canUndo)
+        .function("canRedo", &GlitchEngine::canRedo)
+        .function("setUndoBudget", &GlitchEngine::setUndoBudget)
+        .function("getUndoMemory", &GlitchEngine::getUndoMemory)
+        .function("buildPyramid", &GlitchEngine::buildPyramid)
+        .function("renderPreview", &GlitchEngine::renderPreview)
+        .function("refine", &GlitchEngine::refine)
+        .function("setPreviewBudget", &GlitchEngine::setPreviewBudget)
+        .function("setPreviewLevel", &GlitchEngine::setPreviewLevel)
+        .function("getPreviewLevel", &GlitchEngine::getPreviewLevel)
+        .function("beginFrame", &GlitchEngine::beginFrame)
+        .function("step", &GlitchEngine::step)
+        .function("isComplete", &GlitchEngine::isComplete)
+        .function("getProgress", &GlitchEngine::getProgress)
+        .function("clearChain", &GlitchEngine::clearChain)
+        .function("addChainStage", &GlitchEngine::addChainStage)
+        .function("renderChain", &GlitchEngine::renderChain);
 }
\ No newline at end of file
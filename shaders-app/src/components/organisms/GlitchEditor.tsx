@@ -21,11 +21,30 @@ const EffectType = {
     SOBEL: 8,
     RIPPLE: 9,
     SOLARIZE: 10,
-    RGB_NOISE: 11
+    RGB_NOISE: 11,
+    PIXEL_SORT_INTERVAL: 12,
+    GAUSSIAN_BLUR: 13,
+    SHARPEN: 14,
+    EMBOSS: 15,
+    BOX_BLUR: 16
 } as const;
 
 type EffectType = typeof EffectType[keyof typeof EffectType];
 
+/**
+ * @enum RenderQuality
+ * @brief Resampling tier of the geometric effects. MUST match the C++ enum.
+ */
+const RenderQuality = {
+    DRAG: 0,
+    FINAL: 1
+} as const;
+
+type RenderQuality = typeof RenderQuality[keyof typeof RenderQuality];
+
+// Render time per animation frame for sliced frames, leaving room for input and painting
+const STEP_BUDGET_MICROS = 8000;
+
 /**
  * @component GlitchEditor
  * @brief Main container component for the image processing tool.
@@ -40,11 +59,29 @@ export const GlitchEditor: React.FC = () => {
     const [activeEffect, setActiveEffect] = useState<EffectType>(EffectType.PIXEL_SORT);
     const [radius, setRadius] = useState<number>(150);
     const [intensity, setIntensity] = useState<number>(50);
-    const [editMode, setEditMode] = useState<'bubble' | 'full'>('bubble');
+    const [feather, setFeather] = useState<number>(0);
+    const [linearEdges, setLinearEdges] = useState<boolean>(false);
+    const [editMode, setEditMode] = useState<'bubble' | 'full' | 'paint'>('bubble');
+
+    // Paint mode: strokes are committed into the image and can be undone
+    const isPaintingRef = useRef<boolean>(false);
+    const [history, setHistory] = useState({ canUndo: false, canRedo: false });
+
+    // Bubble mode: reduced-resolution previews while moving, refined once idle.
+    // The tier of the last bubble frame decides whether the refinement is needed.
+    const refineTimerRef = useRef<number | undefined>(undefined);
+    const bubbleTierRef = useRef<RenderQuality>(RenderQuality.FINAL);
+
+    // Pointer events only record the latest position; a single animation-frame
+    // loop renders it and advances slow frames in time-budgeted slices.
+    const pendingPointerRef = useRef<{ x: number, y: number } | null>(null);
+    const rafRef = useRef<number>(0);
+    const frameLoopRef = useRef<() => void>(() => {});
 
     /**
      * @function renderToCanvas
      * @brief Helper to paint the C++ buffer back to the canvas.
+     * Only the dirty rectangle reported by the engine is uploaded.
      */
     const renderToCanvas = useCallback(() => {
         const canvas = canvasRef.current;
@@ -52,6 +89,9 @@ export const GlitchEditor: React.FC = () => {
 
         const ctx = canvas.getContext('2d');
         if (!ctx) return;
+
+        const dirty = engine.getDirtyRect();
+        if (dirty.width <= 0 || dirty.height <= 0) return;
         
         const displayPtr = engine.getDisplayPointer();
         
@@ -62,9 +102,19 @@ export const GlitchEditor: React.FC = () => {
         );
         
         const newImageData = new ImageData(wasmView, canvas.width, canvas.height);
-        ctx.putImageData(newImageData, 0, 0);
+        ctx.putImageData(newImageData, 0, 0, dirty.x, dirty.y, dirty.width, dirty.height);
     }, [engine, wasmModule]);
 
+    /**
+     * @function requestFrame
+     * @brief Schedules the frame loop for the next animation frame (once).
+     */
+    const requestFrame = useCallback(() => {
+        if (!rafRef.current) rafRef.current = requestAnimationFrame(() => frameLoopRef.current());
+    }, []);
+
+    useEffect(() => () => cancelAnimationFrame(rafRef.current), []);
+
     /**
      * @function applyFullImageEffect
      * @brief Applies the effect to the entire image by using a large radius.
@@ -81,9 +131,11 @@ export const GlitchEditor: React.FC = () => {
         const maxDim = Math.max(canvas.width, canvas.height);
         const fullRadius = maxDim * 1.5;
 
-        engine.renderFrame(cx, cy, fullRadius, activeEffect, intensity);
-        renderToCanvas();
-    }, [engine, activeEffect, intensity, renderToCanvas]);
+        // Whole image at the clean (bilinear) tier, rendered in slices so the UI stays responsive
+        engine.setQuality(RenderQuality.FINAL);
+        engine.beginFrame(cx, cy, fullRadius, activeEffect, intensity);
+        requestFrame();
+    }, [engine, activeEffect, intensity, requestFrame]);
 
     /**
      * @function handleImageUpload
@@ -113,18 +165,17 @@ export const GlitchEditor: React.FC = () => {
                 ctx.drawImage(img, 0, 0);
 
                 // --- C++ Memory Sync ---
-                engine.loadBox(img.width, img.height);
-                
                 const imageData = ctx.getImageData(0, 0, img.width, img.height);
-                const originalPtr = engine.getOriginalPointer();
+                const originalPtr = engine.beginIngest(img.width, img.height);
                 
-                // Create a typed view into the Wasm heap
+                // Single copy straight into the Wasm heap. The canvas already shows
+                // the image, and the engine prepares its display on the first render.
                 const wasmHeap = new Uint8Array(wasmModule.HEAPU8.buffer, originalPtr, img.width * img.height * 4);
                 wasmHeap.set(imageData.data);
+                engine.buildPyramid(); // Reduced copies for the drag previews
 
-                // Initial render to clear artifacts
-                engine.renderFrame(-1000, -1000, 0, 0, 0); 
                 setImageUploaded(true);
+                setHistory({ canUndo: false, canRedo: false }); // Loading resets the history
 
                 // If in full mode, apply effect immediately
                 if (editMode === 'full') {
@@ -140,6 +191,16 @@ export const GlitchEditor: React.FC = () => {
         reader.readAsDataURL(file);
     };
 
+    // Keep the engine's soft lens edge in sync with the slider
+    useEffect(() => {
+        if (engine) engine.setFeather(feather);
+    }, [engine, feather]);
+
+    // Mix the soft edge in linear light (no dark fringe between contrasting colors)
+    useEffect(() => {
+        if (engine) engine.setLinearEdges(linearEdges);
+    }, [engine, linearEdges]);
+
     // Re-run full effect when parameters change in 'full' mode
     useEffect(() => {
         if (editMode === 'full' && imageUploaded) {
@@ -147,6 +208,123 @@ export const GlitchEditor: React.FC = () => {
         }
     }, [editMode, imageUploaded, applyFullImageEffect]);
 
+    /**
+     * @function toCanvasPoint
+     * @brief Converts client coordinates to canvas pixels (the canvas may be CSS-scaled).
+     */
+    const toCanvasPoint = (clientX: number, clientY: number): { x: number, y: number } | null => {
+        const canvas = canvasRef.current;
+        if (!canvas) return null;
+        const rect = canvas.getBoundingClientRect();
+        return {
+            x: (clientX - rect.left) * (canvas.width / rect.width),
+            y: (clientY - rect.top) * (canvas.height / rect.height)
+        };
+    };
+
+    const refreshHistory = useCallback(() => {
+        if (engine) setHistory({ canUndo: engine.canUndo(), canRedo: engine.canRedo() });
+    }, [engine]);
+
+    /**
+     * @function paintAt
+     * @brief Commits one brush dab (Paint Mode), opening a stroke on the first call.
+     */
+    const paintAt = (clientX: number, clientY: number): void => {
+        if (!imageUploaded || !engine) return;
+        const point = toCanvasPoint(clientX, clientY);
+        if (!point) return;
+
+        // Dabs are permanent: always use the clean tier
+        engine.setQuality(RenderQuality.FINAL);
+        engine.paintDab(point.x, point.y, radius, activeEffect, intensity);
+        isPaintingRef.current = true;
+        renderToCanvas();
+    };
+
+    /**
+     * @function finishStroke
+     * @brief Closes the current stroke so it becomes a single undo step.
+     */
+    const finishStroke = (): void => {
+        if (!isPaintingRef.current || !engine) return;
+        isPaintingRef.current = false;
+        engine.endStroke();
+        refreshHistory();
+    };
+
+    const handleUndo = useCallback(() => {
+        if (engine && engine.undo()) renderToCanvas();
+        refreshHistory();
+    }, [engine, renderToCanvas, refreshHistory]);
+
+    const handleRedo = useCallback(() => {
+        if (engine && engine.redo()) renderToCanvas();
+        refreshHistory();
+    }, [engine, renderToCanvas, refreshHistory]);
+
+    // Ctrl+Z / Ctrl+Shift+Z (Cmd on macOS)
+    useEffect(() => {
+        const onKeyDown = (e: KeyboardEvent) => {
+            if (!(e.ctrlKey || e.metaKey) || e.key.toLowerCase() !== 'z') return;
+            e.preventDefault();
+            if (e.shiftKey) handleRedo();
+            else handleUndo();
+        };
+        window.addEventListener('keydown', onKeyDown);
+        return () => window.removeEventListener('keydown', onKeyDown);
+    }, [handleUndo, handleRedo]);
+
+    /**
+     * @function frameLoop
+     * @brief One animation frame: renders the latest pointer position (superseding
+     * any frame in flight) or advances the frame in flight by one time slice.
+     */
+    frameLoopRef.current = (): void => {
+        rafRef.current = 0;
+        if (!engine) return;
+
+        const pointer = pendingPointerRef.current;
+        if (pointer) {
+            pendingPointerRef.current = null;
+
+            // Interactive tier while dragging; the level adapts to the frame budget
+            engine.setQuality(RenderQuality.DRAG);
+            engine.renderPreview(pointer.x, pointer.y, radius, activeEffect, intensity);
+            bubbleTierRef.current = RenderQuality.DRAG;
+            renderToCanvas();
+
+            // Refine once the pointer rests: full resolution and the clean tier, even
+            // when the preview already ran at level 0 (it still used the drag tier)
+            window.clearTimeout(refineTimerRef.current);
+            refineTimerRef.current = window.setTimeout(() => {
+                if (bubbleTierRef.current !== RenderQuality.DRAG) return;
+                bubbleTierRef.current = RenderQuality.FINAL;
+                engine.setQuality(RenderQuality.FINAL);
+                engine.beginFrame(pointer.x, pointer.y, radius, activeEffect, intensity);
+                requestFrame();
+            }, 150);
+        } else if (!engine.isComplete()) {
+            engine.step(STEP_BUDGET_MICROS);
+            renderToCanvas();
+        }
+
+        if (pendingPointerRef.current || !engine.isComplete()) requestFrame();
+    };
+
+    /**
+     * @function previewAt
+     * @brief Queues a bubble render at this position for the next animation frame.
+     * Events arriving in between only move the queued position.
+     */
+    const previewAt = (x: number, y: number): void => {
+        pendingPointerRef.current = { x, y };
+        requestFrame();
+    };
+
+    // Drop a pending refinement when leaving bubble mode or unmounting
+    useEffect(() => () => window.clearTimeout(refineTimerRef.current), [editMode]);
+
     /**
      * @function handleMouseMove
      * @brief Triggers the C++ render loop based on mouse position (Bubble Mode only).
@@ -155,6 +333,10 @@ export const GlitchEditor: React.FC = () => {
     const handleMouseMove = (e: MouseEvent<HTMLCanvasElement>): void => {
         if (!imageUploaded || !engine || !wasmModule || !canvasRef.current) return;
         if (editMode === 'full') return; // Disable mouse interaction in full mode
+        if (editMode === 'paint') {
+            if (e.buttons & 1) paintAt(e.clientX, e.clientY);
+            return;
+        }
 
         const canvas = canvasRef.current;
         const rect = canvas.getBoundingClientRect();
@@ -167,8 +349,7 @@ export const GlitchEditor: React.FC = () => {
         const y = (e.clientY - rect.top) * scaleY;
 
         // Execute C++ Logic
-        engine.renderFrame(x, y, radius, activeEffect, intensity);
-        renderToCanvas();
+        previewAt(x, y);
     };
 
     /**
@@ -179,6 +360,10 @@ export const GlitchEditor: React.FC = () => {
     const handleTouchMove = (e: TouchEvent<HTMLCanvasElement>): void => {
         if (!imageUploaded || !engine || !wasmModule || !canvasRef.current) return;
         if (editMode === 'full') return;
+        if (editMode === 'paint') {
+            paintAt(e.touches[0].clientX, e.touches[0].clientY);
+            return;
+        }
 
         const canvas = canvasRef.current;
         const rect = canvas.getBoundingClientRect();
@@ -190,8 +375,7 @@ export const GlitchEditor: React.FC = () => {
         const x = (touch.clientX - rect.left) * scaleX;
         const y = (touch.clientY - rect.top) * scaleY;
 
-        engine.renderFrame(x, y, radius, activeEffect, intensity);
-        renderToCanvas();
+        previewAt(x, y);
     };
 
     /**
@@ -244,7 +428,23 @@ export const GlitchEditor: React.FC = () => {
                         >
                             Full Image
                         </button>
+                        <button 
+                            className={`mode-btn ${editMode === 'paint' ? 'active' : ''}`}
+                            onClick={() => setEditMode('paint')}
+                        >
+                            Paint
+                        </button>
                     </div>
+                    {editMode === 'paint' && (
+                        <div className="mode-toggle">
+                            <button className="mode-btn" onClick={handleUndo} disabled={!history.canUndo}>
+                                Undo
+                            </button>
+                            <button className="mode-btn" onClick={handleRedo} disabled={!history.canRedo}>
+                                Redo
+                            </button>
+                        </div>
+                    )}
                 </section>
 
                 <section className="sidebar-section">
@@ -266,8 +466,17 @@ export const GlitchEditor: React.FC = () => {
 
                 <section className="sidebar-section">
                     <div className="section-title">Parameters</div>
-                    {editMode === 'bubble' && (
-                        <RangeSlider label="Bubble Radius" value={radius} min={50} max={500} onChange={setRadius} />
+                    {editMode !== 'full' && (
+                        <>
+                            <RangeSlider label={editMode === 'paint' ? 'Brush Radius' : 'Bubble Radius'} value={radius} min={50} max={500} onChange={setRadius} />
+                            <RangeSlider label="Edge Feather" value={feather} min={0} max={50} onChange={setFeather} />
+                            {feather > 0 && (
+                                <div className="mode-toggle">
+                                    <button className={`mode-btn ${!linearEdges ? 'active' : ''}`} onClick={() => setLinearEdges(false)}>sRGB Edge</button>
+                                    <button className={`mode-btn ${linearEdges ? 'active' : ''}`} onClick={() => setLinearEdges(true)}>Linear Edge</button>
+                                </div>
+                            )}
+                        </>
                     )}
                     <RangeSlider label="Intensity" value={intensity} min={1} max={100} onChange={setIntensity} />
                 </section>
@@ -289,8 +498,12 @@ export const GlitchEditor: React.FC = () => {
                 <canvas 
                     ref={canvasRef} 
                     onMouseMove={handleMouseMove}
+                    onMouseDown={(e) => { if (editMode === 'paint' && e.button === 0) paintAt(e.clientX, e.clientY); }}
+                    onMouseUp={finishStroke}
+                    onMouseLeave={finishStroke}
                     onTouchMove={handleTouchMove}
                     onTouchStart={handleTouchMove}
+                    onTouchEnd={finishStroke}
                     className={`editor-canvas ${editMode === 'full' ? 'full-mode' : ''}`}
                     style={{ 
                         display: imageUploaded ? 'block' : 'none',
@@ -4,13 +4,61 @@
  * @description Defines the interface for the C++ GlitchEngine and the Wasm module factory.
  */
 
+/**
+ * @interface DirtyRect
+ * @brief Rectangle of the display buffer that changed in the last frame.
+ */
+export interface DirtyRect {
+    x: number;
+    y: number;
+    width: number;
+    height: number;
+}
+
+/**
+ * @interface StatSummary
+ * @brief Distribution of one per-frame measurement over the recorded frames.
+ */
+export interface StatSummary {
+    mean: number;
+    p50: number;
+    p95: number;
+    p99: number;
+    max: number;
+}
+
+/**
+ * @interface FrameStats
+ * @brief Aggregated timings (milliseconds) and counters of the last recorded frames.
+ * All values are 0 in builds compiled with GLITCH_FRAME_STATS=0.
+ */
+export interface FrameStats {
+    count: number;
+    healMs: StatSummary;
+    setupMs: StatSummary;
+    applyMs: StatSummary;
+    totalMs: StatSummary;
+    pixels: StatSummary;
+    bytesCopied: StatSummary;
+}
+
 /**
  * @interface GlitchEngine
  * @brief Interface representing the C++ class exposed via Emscripten.
  */
 export interface GlitchEngine {
     /**
-     * @brief Allocates memory buffers in the Wasm heap for the image.
+     * @brief Prepares the engine for a new image and returns where to write its RGBA pixels.
+     * The buffer is reused when the image is not larger than the previous one and
+     * is not zero-filled, so the caller's single copy is the only write.
+     * @param width The width of the image in pixels.
+     * @param height The height of the image in pixels.
+     * @returns {number} Memory pointer of the original buffer (same as getOriginalPointer()).
+     */
+    beginIngest(width: number, height: number): number;
+
+    /**
+     * @brief Same as beginIngest(), without returning the pointer.
      * @param width The width of the image in pixels.
      * @param height The height of the image in pixels.
      */
@@ -38,6 +86,216 @@ export interface GlitchEngine {
      */
     renderFrame(x: number, y: number, radius: number, effectId: number, intensity: number): void;
 
+    /**
+     * @brief Returns the area changed by the last renderFrame call.
+     * Only this sub-rectangle needs to be uploaded to the canvas.
+     * @returns {DirtyRect} Empty (width/height 0) if nothing changed.
+     */
+    getDirtyRect(): DirtyRect;
+
+    /**
+     * @brief Must be called after writing into the original buffer again
+     * (other than right after loadBox). Marks the area for re-healing and
+     * for rebuilding the cached luminance.
+     */
+    invalidateOriginal(x: number, y: number, width: number, height: number): void;
+
+    /**
+     * @brief Sets the width of the soft (anti-aliased) bubble edge.
+     * @param pixels Feather width in pixels. 0 gives a hard edge.
+     */
+    setFeather(pixels: number): void;
+
+    /**
+     * @brief Mixes the soft bubble edge in linear light instead of sRGB.
+     */
+    setLinearEdges(enabled: boolean): void;
+
+    /**
+     * @brief Selects the resampling quality of Swirl and Ripple.
+     * @param tier 0 = drag (approximate trig, nearest sampling), 1 = final (exact trig, bilinear).
+     */
+    setQuality(tier: number): void;
+
+    /**
+     * @brief Seed of the randomized effects (Jitter, Scanline, RGB Noise).
+     */
+    setSeed(seed: number): void;
+
+    /**
+     * @brief Frame index used by the last render. Passing it back to
+     * setFrameIndex() and rendering the same input reproduces that frame.
+     */
+    getFrameIndex(): number;
+
+    /**
+     * @brief Makes the next render use this frame index.
+     */
+    setFrameIndex(frame: number): void;
+
+    /**
+     * @brief Sets the number of render threads, including the calling thread.
+     * Builds without pthreads always use 1.
+     * @param threads 1 renders single-threaded.
+     */
+    setThreadCount(threads: number): void;
+
+    /**
+     * @brief Returns the number of render threads in use.
+     */
+    getThreadCount(): number;
+
+    /**
+     * @brief Statistics of the last (up to 256) rendered frames: heal, setup
+     * and apply times, pixels processed and bytes copied by the engine.
+     */
+    getFrameStats(): FrameStats;
+
+    /**
+     * @brief Lens-box pixels processed by one effect since the last reset.
+     * @param effectId The integer ID of the effect.
+     */
+    getEffectPixels(effectId: number): number;
+
+    /**
+     * @brief Clears the recorded frames and the per-effect pixel totals.
+     */
+    resetFrameStats(): void;
+
+    /**
+     * @brief Starts a paint stroke; its dabs until endStroke() form one undo step.
+     */
+    beginStroke(): void;
+
+    /**
+     * @brief Applies the effect inside the bubble and commits it into the image,
+     * so later dabs and frames build on it. Opens a stroke if none is open.
+     * @param x Mouse X coordinate relative to the canvas.
+     * @param y Mouse Y coordinate relative to the canvas.
+     * @param radius The radius of the brush.
+     * @param effectId The integer ID of the effect to apply.
+     * @param intensity The intensity parameter.
+     */
+    paintDab(x: number, y: number, radius: number, effectId: number, intensity: number): void;
+
+    /**
+     * @brief Closes the stroke and stores it in the undo history.
+     * @returns {boolean} False if the stroke changed nothing.
+     */
+    endStroke(): boolean;
+
+    /**
+     * @brief Reverts the last stroke. The restored area is reported by getDirtyRect().
+     * @returns {boolean} False if there was nothing to undo.
+     */
+    undo(): boolean;
+
+    /**
+     * @brief Re-applies the last undone stroke.
+     * @returns {boolean} False if there was nothing to redo.
+     */
+    redo(): boolean;
+
+    canUndo(): boolean;
+    canRedo(): boolean;
+
+    /**
+     * @brief Caps the memory of the undo history (default 64 MB); old strokes are dropped first.
+     * @param bytes The budget in bytes.
+     */
+    setUndoBudget(bytes: number): void;
+
+    /**
+     * @brief Bytes currently used by the compressed undo history.
+     */
+    getUndoMemory(): number;
+
+    /**
+     * @brief Builds the reduced copies of the image used by renderPreview().
+     * Optional; call it after loading to keep the cost out of the first drag.
+     */
+    buildPyramid(): void;
+
+    /**
+     * @brief Like renderFrame(), but may run the effect on a 1/2^L copy of the image
+     * and upscale it into the bubble, with L chosen to fit the preview budget.
+     * @param x Mouse X coordinate relative to the canvas.
+     * @param y Mouse Y coordinate relative to the canvas.
+     * @param radius The radius of the effect bubble.
+     * @param effectId The integer ID of the effect to apply.
+     * @param intensity The intensity parameter.
+     */
+    renderPreview(x: number, y: number, radius: number, effectId: number, intensity: number): void;
+
+    /**
+     * @brief Renders the last preview again at full resolution (call once input is idle).
+     * @returns {boolean} False if the last preview was already at full resolution.
+     */
+    refine(): boolean;
+
+    /**
+     * @brief Target time of a preview frame in milliseconds (default 12).
+     */
+    setPreviewBudget(ms: number): void;
+
+    /**
+     * @brief Forces the preview level (0 = full resolution); -1 = automatic.
+     */
+    setPreviewLevel(level: number): void;
+
+    /**
+     * @brief Level used by the last renderPreview (0 = full resolution).
+     */
+    getPreviewLevel(): number;
+
+    /**
+     * @brief Starts a frame that step() renders in slices (same result as renderFrame).
+     * Supersedes a frame still in flight; synchronous renders cancel it.
+     * @param x Mouse X coordinate relative to the canvas.
+     * @param y Mouse Y coordinate relative to the canvas.
+     * @param radius The radius of the effect bubble.
+     * @param effectId The integer ID of the effect to apply.
+     * @param intensity The intensity parameter.
+     */
+    beginFrame(x: number, y: number, radius: number, effectId: number, intensity: number): void;
+
+    /**
+     * @brief Renders slices of the frame in flight for about budgetMicros (at least one slice).
+     * getDirtyRect() then covers what changed since the previous step.
+     * @returns {boolean} True once the frame is complete.
+     */
+    step(budgetMicros: number): boolean;
+
+    /**
+     * @brief True when no frame is in flight.
+     */
+    isComplete(): boolean;
+
+    /**
+     * @brief Fraction of the frame in flight rendered so far, from 0 to 1.
+     */
+    getProgress(): number;
+
+    /**
+     * @brief Removes all stages from the effect chain.
+     */
+    clearChain(): void;
+
+    /**
+     * @brief Appends an effect to the chain. Stages run in insertion order.
+     * @param effectId The integer ID of the effect to apply.
+     * @param intensity The intensity parameter for this stage.
+     */
+    addChainStage(effectId: number, intensity: number): void;
+
+    /**
+     * @brief Renders the whole effect chain inside the bubble.
+     * @param x Mouse X coordinate relative to the canvas.
+     * @param y Mouse Y coordinate relative to the canvas.
+     * @param radius The radius of the effect bubble.
+     */
+    renderChain(x: number, y: number, radius: number): void;
+
     /**
      * @brief Destructor to free C++ memory.
      * Automatically generated by Emscripten.